@@ -0,0 +1,478 @@
+/**
+ * @file diversity_combiner.c
+ * @brief Combines FX.25 frames received by several ground stations.
+ *
+ * Each station sees the same downlink through a different channel, so its copy
+ * of a frame is corrupted in different places. The combiner reads one capture
+ * per station, lines the copies of each frame up by timestamp and correlation
+ * tag, and writes each recovered AX.25 frame once as a KISS stream:
+ * 1. Selection: the first copy that decodes on its own and passes the FCS.
+ * 2. Combining: otherwise the copies are merged before RS decoding. Hard bytes
+ *    are merged by majority vote, with the vote margin as the reliability of
+ *    each byte; soft symbols are summed. The merged frame then goes through
+ *    the erasure trials of fx25_decoder, so the bytes the stations disagree
+ *    on are erased first.
+ *
+ * WHY THIS STRUCTURE:
+ * - Streaming: The captures are merged in time order, holding one frame per
+ * station, so an hour-long pass from many stations runs in one pass with
+ * memory independent of the capture length.
+ * - Shared Code: fx25_decoder.c is built in with FX25_DECODER_LIBRARY defined,
+ * so the decoding and erasure trials are the same as for a single station.
+ *
+ * Capture formats:
+ * - KISS (default): FX.25 frames as received. KISS carries no timestamps, so
+ *   copies are aligned by frame order; use this only when no station drops frames.
+ * - Raw (-r): records of an 8-byte timestamp in microseconds and a 2-byte frame
+ *   length (both little-endian) followed by the frame.
+ *
+ * Compile with:
+ * gcc -O2 -fopenmp -Wall diversity_combiner.c -o diversity_combiner -lfec -lm
+ *
+ * Run with:
+ * ./diversity_combiner [-r] [-S] [-w window_ms] [-t max_trials] <output_kiss_file> <capture> <capture> ...
+ * ./diversity_combiner -b
+ *
+ * Options:
+ * -r   Captures are raw timestamped records instead of KISS.
+ * -S   Frames carry one soft symbol per bit instead of hard bytes.
+ * -w   Largest timestamp difference between copies of one frame (default: 100 ms).
+ * -t   Maximum erasure trials for a combined frame (default: all).
+ * -b   Benchmark selection and combining over simulated AWGN stations.
+ */
+
+#define FX25_DECODER_LIBRARY
+#include "fx25_decoder.c"
+
+// =============================================================================
+// Constants
+// =============================================================================
+
+#define DIVERSITY_MAX_STATIONS 16
+#define DIVERSITY_WINDOW_MS 100   // Default alignment window
+#define RAW_HEADER_LEN 10         // Timestamp (8) + length (2)
+
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief One station's capture, with the next frame read ahead.
+ */
+typedef struct {
+    const char* name;
+    FILE* file;
+    int valid;          // 0 once the capture is exhausted
+    int64_t timestamp;  // Microseconds for raw captures, frame index for KISS
+    uint8_t frame[8 * FX25_FRAME_LEN];
+    int n_bytes;        // Frame length in bytes: tag + codeword of the tagged code
+    long frames;        // Frames read
+    long decoded_alone; // Frames this station decoded on its own
+} station_t;
+
+/**
+ * @brief Capture and decoding settings shared by all stations.
+ */
+typedef struct {
+    int raw;
+    int soft;
+    int64_t window_us;
+    int max_trials;
+} combiner_config_t;
+
+
+// =============================================================================
+// Capture Input Module
+// =============================================================================
+
+/**
+ * @brief Reads the next raw capture record.
+ * @return The frame length, or -1 at the end of the capture.
+ */
+int read_raw_record(FILE* stream, int64_t* timestamp, uint8_t* frame, int max_len) {
+    uint8_t header[RAW_HEADER_LEN];
+    while (fread(header, 1, RAW_HEADER_LEN, stream) == RAW_HEADER_LEN) {
+        uint64_t t = 0;
+        for (int i = 7; i >= 0; i--) t = (t << 8) | header[i];
+        int length = header[8] | (header[9] << 8);
+        if (length > max_len) {
+            if (fseek(stream, length, SEEK_CUR) != 0) return -1;
+            continue;
+        }
+        if (fread(frame, 1, length, stream) != (size_t)length) return -1;
+        *timestamp = (int64_t)t;
+        return length;
+    }
+    return -1;
+}
+
+/**
+ * @brief Hard-decision bytes of a frame, from hard bytes or soft symbols.
+ */
+void frame_bytes(const uint8_t* frame, int n_bytes, int soft, uint8_t* bytes) {
+    if (!soft) {
+        memcpy(bytes, frame, n_bytes);
+        return;
+    }
+    for (int i = 0; i < n_bytes; i++) {
+        uint8_t byte = 0;
+        for (int b = 0; b < 8; b++) byte = (byte << 1) | (frame[8 * i + b] >= SOFT_ERASURE);
+        bytes[i] = byte;
+    }
+}
+
+/**
+ * @brief Reads ahead the station's next FX.25 frame, skipping anything else.
+ * WHY: Codes differ in length (RS(48, 32) voice frames are short), so as in
+ * fx25_decoder the tag says how long the frame has to be. A full-length frame
+ * with an unknown tag is still kept; combining may recover it.
+ */
+void station_advance(station_t* station, const combiner_config_t* config) {
+    int max_len = config->soft ? 8 * FX25_FRAME_LEN : FX25_FRAME_LEN;
+    int length;
+    station->valid = 0;
+    while (1) {
+        if (config->raw) {
+            length = read_raw_record(station->file, &station->timestamp, station->frame, max_len);
+        } else {
+            length = read_kiss_frame(station->file, station->frame, max_len);
+            station->timestamp = station->frames;
+        }
+        if (length < 0) return;
+
+        int n_bytes = config->soft ? length / 8 : length;
+        int code = -1;
+        if (n_bytes >= 8) {
+            uint8_t tag[8];
+            frame_bytes(station->frame, 8, config->soft, tag);
+            code = fx25_match_tag(tag);
+        }
+        int expected = (code >= 0) ? 8 + FX25_CODES[code].n : FX25_FRAME_LEN;
+        if (n_bytes == expected && !(config->soft && length % 8)) {
+            station->n_bytes = n_bytes;
+            break;
+        }
+        fprintf(stderr, "Warning: %s: skipping a %d-byte frame\n", station->name, length);
+    }
+    station->frames++;
+    station->valid = 1;
+}
+
+/**
+ * @brief Closes the station captures and frees the station array.
+ */
+void close_stations(station_t* stations, int n_stations) {
+    for (int s = 0; s < n_stations; s++) {
+        if (stations[s].file) fclose(stations[s].file);
+    }
+    free(stations);
+}
+
+
+// =============================================================================
+// Combining Module
+// =============================================================================
+
+/**
+ * @brief Merges the copies of one frame into hard bytes and per-byte reliabilities.
+ * Hard copies are merged by majority vote; a byte's reliability is the margin
+ * of the winning value over the runner-up, so ties are erased first. Soft
+ * copies are summed symbol by symbol (equal-gain combining) and split into
+ * bytes as for a single soft frame.
+ * @param n_bytes Frame length in bytes, the same for every copy.
+ */
+void combine_copies(const uint8_t* const* copies, int n_copies, int n_bytes, int soft,
+                    uint8_t* bytes, uint8_t* reliability) {
+    if (soft) {
+        uint8_t symbols[8 * FX25_FRAME_LEN];
+        for (int i = 0; i < 8 * n_bytes; i++) {
+            int sum = SOFT_ERASURE;
+            for (int c = 0; c < n_copies; c++) sum += copies[c][i] - SOFT_ERASURE;
+            symbols[i] = (sum < 0) ? 0 : (sum > 255) ? 255 : sum;
+        }
+        soft_to_bytes(symbols, n_bytes, bytes, reliability);
+        return;
+    }
+    for (int i = 0; i < n_bytes; i++) {
+        int best = 0, best_votes = 0, runner_up = 0;
+        for (int c = 0; c < n_copies; c++) {
+            int votes = 0;
+            for (int d = 0; d < n_copies; d++) votes += copies[d][i] == copies[c][i];
+            if (votes > best_votes) {
+                best = c;
+                best_votes = votes;
+            }
+        }
+        for (int c = 0; c < n_copies; c++) {
+            if (copies[c][i] == copies[best][i]) continue;
+            int votes = 0;
+            for (int d = 0; d < n_copies; d++) votes += copies[d][i] == copies[c][i];
+            if (votes > runner_up) runner_up = votes;
+        }
+        bytes[i] = copies[best][i];
+        reliability[i] = best_votes - runner_up;
+    }
+}
+
+/**
+ * @brief Recovers one frame from the copies received by the stations.
+ * @param n_bytes Frame length in bytes, the same for every copy.
+ * @param decoded_alone Set per copy when that copy decoded on its own.
+ * @return 1 if a copy decoded on its own, 2 if combining recovered the frame,
+ * 0 if it failed.
+ */
+int combine_frame(fx25_encoder_t* rs, const uint8_t* const* copies, int n_copies, int n_bytes,
+                  const combiner_config_t* config, int* decoded_alone, fx25_result_t* result) {
+    uint8_t bytes[FX25_FRAME_LEN], reliability[FX25_FRAME_LEN];
+    int status = 0;
+    fx25_result_t single;
+
+    // WHY: Every copy is tried so per-station statistics stay meaningful; plain
+    // decoding is cheap next to the erasure trials that combining may need.
+    for (int c = 0; c < n_copies; c++) {
+        frame_bytes(copies[c], n_bytes, config->soft, bytes);
+        decoded_alone[c] = fx25_decode_frame(rs, bytes, NULL, 0, &single);
+        if (decoded_alone[c] && status == 0) {
+            *result = single;
+            status = 1;
+        }
+    }
+    if (status || (n_copies == 1 && !config->soft)) {
+        return status;
+    }
+    combine_copies(copies, n_copies, n_bytes, config->soft, bytes, reliability);
+    return fx25_decode_frame(rs, bytes, reliability + 8, config->max_trials, result) ? 2 : 0;
+}
+
+
+// =============================================================================
+// Benchmark Module
+// =============================================================================
+
+#define BENCH_FRAMES 1000
+#define BENCH_STATIONS 3
+#define SOFT_SCALE 32.0  // Soft units per unit of BPSK amplitude
+
+/**
+ * @brief xorshift64* generator; rand() is far too slow to feed the noise model.
+ */
+static uint64_t bench_rng = 0x9E3779B97F4A7C15ULL;
+
+double bench_uniform(void) {
+    bench_rng ^= bench_rng >> 12;
+    bench_rng ^= bench_rng << 25;
+    bench_rng ^= bench_rng >> 27;
+    return ((bench_rng * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double bench_gaussian(void) {
+    double u = bench_uniform();
+    return sqrt(-2.0 * log(u > 0.0 ? u : 1e-300)) * cos(2.0 * M_PI * bench_uniform());
+}
+
+/**
+ * @brief Frame error rate of one station, selection, and hard and soft
+ * combining, with every station seeing independent BPSK/AWGN at the same Eb/N0.
+ * @return 0 on success, 1 on error.
+ */
+int run_combiner_benchmark(fx25_encoder_t* rs) {
+    ax25_address_t src = { .call = "N0CALL", .ssid = 1 };
+    ax25_address_t dest = { .call = "CQ", .ssid = 0 };
+    uint8_t payload[FX25_N], ax25[512], frame[FX25_FRAME_LEN];
+    uint8_t soft[BENCH_STATIONS][8 * FX25_FRAME_LEN], hard[BENCH_STATIONS][FX25_FRAME_LEN];
+    const uint8_t* soft_copies[BENCH_STATIONS];
+    const uint8_t* hard_copies[BENCH_STATIONS];
+    int decoded_alone[BENCH_STATIONS];
+    int payload_len = fx25_payload_capacity(FX25_CODE_DEFAULT);
+    double rate = (double)FX25_K / FX25_N;
+    combiner_config_t hard_config = { .soft = 0, .max_trials = FX25_N };
+    combiner_config_t soft_config = { .soft = 1, .max_trials = FX25_N };
+    fx25_result_t result;
+
+    for (int s = 0; s < BENCH_STATIONS; s++) {
+        soft_copies[s] = soft[s];
+        hard_copies[s] = hard[s];
+    }
+    printf("\n  RS(255,223), %d stations, %d frames per point\n", BENCH_STATIONS, BENCH_FRAMES);
+    printf("  %8s %12s %12s %12s %12s\n", "Eb/N0", "1 station", "Selection", "Hard comb.", "Soft comb.");
+    for (double ebn0 = 0.0; ebn0 <= 5.01; ebn0 += 0.5) {
+        double sigma = sqrt(1.0 / (2.0 * rate * pow(10.0, ebn0 / 10.0)));
+        long single_errors = 0, selection_errors = 0, hard_errors = 0, soft_errors = 0;
+        for (int f = 0; f < BENCH_FRAMES; f++) {
+            for (int i = 0; i < payload_len; i++) payload[i] = bench_uniform() * 256.0;
+            int ax25_len = ax25_generate_ui_frame(ax25, dest, src, payload, payload_len);
+            fx25_encode_frame(rs, FX25_CODE_DEFAULT, ax25, ax25_len, frame);
+            for (int s = 0; s < BENCH_STATIONS; s++) {
+                for (int i = 0; i < 8 * FX25_FRAME_LEN; i++) {
+                    double x = ((frame[i >> 3] >> (7 - (i & 7))) & 1) ? 1.0 : -1.0;
+                    double y = SOFT_ERASURE + SOFT_SCALE * (x + sigma * bench_gaussian());
+                    soft[s][i] = (y < 0.0) ? 0 : (y > 255.0) ? 255 : (uint8_t)lrint(y);
+                }
+                frame_bytes(soft[s], FX25_FRAME_LEN, 1, hard[s]);
+            }
+            int status = combine_frame(rs, hard_copies, BENCH_STATIONS, FX25_FRAME_LEN, &hard_config, decoded_alone, &result);
+            single_errors += !decoded_alone[0];
+            selection_errors += status != 1;
+            hard_errors += status == 0 || result.ax25_len != ax25_len || memcmp(result.ax25, ax25, ax25_len);
+            status = combine_frame(rs, soft_copies, BENCH_STATIONS, FX25_FRAME_LEN, &soft_config, decoded_alone, &result);
+            soft_errors += status == 0 || result.ax25_len != ax25_len || memcmp(result.ax25, ax25, ax25_len);
+        }
+        printf("  %6.1fdB %12.2e %12.2e %12.2e %12.2e\n", ebn0,
+               (double)single_errors / BENCH_FRAMES, (double)selection_errors / BENCH_FRAMES,
+               (double)hard_errors / BENCH_FRAMES, (double)soft_errors / BENCH_FRAMES);
+    }
+    printf("  (BPSK/AWGN, independent noise per station, 8-bit soft symbols)\n");
+    return 0;
+}
+
+
+// =============================================================================
+// Main Application
+// =============================================================================
+
+void print_combiner_usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [-r] [-S] [-w window_ms] [-t max_trials] <output_kiss_file> <capture> <capture> ...\n"
+                    "       %s -b\n", prog, prog);
+}
+
+int main(int argc, char* argv[]) {
+    // --- 1. Argument Parsing ---
+    combiner_config_t config = { .raw = 0, .soft = 0,
+                                 .window_us = DIVERSITY_WINDOW_MS * 1000LL, .max_trials = FX25_N };
+    int benchmark = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "rSw:t:b")) != -1) {
+        switch (opt) {
+        case 'r': config.raw = 1; break;
+        case 'S': config.soft = 1; break;
+        case 'w': config.window_us = (int64_t)(atof(optarg) * 1000.0); break;
+        case 't': config.max_trials = atoi(optarg); break;
+        case 'b': benchmark = 1; break;
+        default:
+            print_combiner_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // --- 2. Initialization ---
+    fx25_encoder_t* rs = fx25_init();
+    if (!rs) {
+        fprintf(stderr, "Error: Failed to initialize Reed-Solomon codecs.\n");
+        return 1;
+    }
+    if (benchmark) {
+        int status = run_combiner_benchmark(rs);
+        fx25_cleanup(rs);
+        return status;
+    }
+    int n_stations = argc - optind - 1;
+    if (n_stations < 1 || config.window_us < 0 || config.max_trials < 0) {
+        print_combiner_usage(argv[0]);
+        fx25_cleanup(rs);
+        return 1;
+    }
+    if (n_stations > DIVERSITY_MAX_STATIONS) {
+        fprintf(stderr, "Error: At most %d captures can be combined\n", DIVERSITY_MAX_STATIONS);
+        fx25_cleanup(rs);
+        return 1;
+    }
+    if (!config.raw) {
+        config.window_us = 0; // Frame indices: only copies at the same position match
+    }
+
+    station_t* stations = calloc(n_stations, sizeof(station_t));
+    if (!stations) {
+        perror("Failed to allocate stations");
+        fx25_cleanup(rs);
+        return 1;
+    }
+    for (int s = 0; s < n_stations; s++) {
+        stations[s].name = argv[optind + 1 + s];
+        stations[s].file = fopen(stations[s].name, "rb");
+        if (!stations[s].file) {
+            perror(stations[s].name);
+            close_stations(stations, n_stations);
+            fx25_cleanup(rs);
+            return 1;
+        }
+        station_advance(&stations[s], &config);
+    }
+    FILE* output_file = fopen(argv[optind], "wb");
+    if (!output_file) {
+        perror("Error creating output file");
+        close_stations(stations, n_stations);
+        fx25_cleanup(rs);
+        return 1;
+    }
+
+    // --- 3. Combine Loop ---
+    // WHY: The station holding the earliest frame opens a group; each other
+    // station contributes its next frame if it lies within the window, has the
+    // same length and its tag names the same code (or is too corrupted to name
+    // any). Copies of different codes are never merged byte by byte.
+    long groups = 0, selected = 0, combined = 0, failed = 0;
+    long copies_histogram[DIVERSITY_MAX_STATIONS + 1] = { 0 };
+    while (1) {
+        int first = -1;
+        for (int s = 0; s < n_stations; s++) {
+            if (stations[s].valid && (first < 0 || stations[s].timestamp < stations[first].timestamp)) {
+                first = s;
+            }
+        }
+        if (first < 0) break;
+
+        uint8_t tag[8];
+        int n_bytes = stations[first].n_bytes;
+        frame_bytes(stations[first].frame, 8, config.soft, tag);
+        int code = fx25_match_tag(tag);
+        const uint8_t* copies[DIVERSITY_MAX_STATIONS];
+        int members[DIVERSITY_MAX_STATIONS], decoded_alone[DIVERSITY_MAX_STATIONS];
+        int n_copies = 0;
+        for (int s = 0; s < n_stations; s++) {
+            if (!stations[s].valid || stations[s].timestamp - stations[first].timestamp > config.window_us ||
+                stations[s].n_bytes != n_bytes) {
+                continue;
+            }
+            if (s != first && code >= 0) {
+                frame_bytes(stations[s].frame, 8, config.soft, tag);
+                int other = fx25_match_tag(tag);
+                if (other >= 0 && other != code) continue;
+            }
+            members[n_copies] = s;
+            copies[n_copies++] = stations[s].frame;
+        }
+
+        fx25_result_t result;
+        int outcome = combine_frame(rs, copies, n_copies, n_bytes, &config, decoded_alone, &result);
+        groups++;
+        copies_histogram[n_copies]++;
+        if (outcome) {
+            write_kiss_frame(output_file, result.ax25, result.ax25_len);
+            if (outcome == 1) selected++; else combined++;
+        } else {
+            failed++;
+        }
+        for (int c = 0; c < n_copies; c++) {
+            stations[members[c]].decoded_alone += decoded_alone[c];
+            station_advance(&stations[members[c]], &config);
+        }
+    }
+
+    printf("Combined %d capture(s) into %ld frame(s): %ld from a single copy, %ld by combining, %ld failed\n",
+           n_stations, groups, selected, combined, failed);
+    for (int n = 1; n <= n_stations; n++) {
+        if (copies_histogram[n]) printf("  %ld frame(s) received by %d station(s)\n", copies_histogram[n], n);
+    }
+    for (int s = 0; s < n_stations; s++) {
+        printf("  %s: %ld frame(s), %ld decoded alone\n", stations[s].name, stations[s].frames, stations[s].decoded_alone);
+    }
+
+    // --- 4. Cleanup ---
+    fclose(output_file);
+    close_stations(stations, n_stations);
+    fx25_cleanup(rs);
+
+    printf("Output written to %s\n", argv[optind]);
+    return 0;
+}
@@ -0,0 +1,657 @@
+/**
+ * @file fer_simulator.c
+ * @brief Monte-Carlo frame error rate simulator for the AX.25 / FX.25 chain.
+ *
+ * Every simulated frame goes through the real pipeline: ax25_generate_ui_frame(),
+ * fx25_encode_frame(), a channel model that flips bits of the on-air frame
+ * (correlation tag included), and the fx25_decoder receiver, which must match
+ * the tag, decode the codeword and pass the FCS. For each configuration the
+ * simulator reports the frame error rate and the goodput over LoRa: payload
+ * bits delivered per second of airtime.
+ *
+ * Channel models:
+ * - ber:p                    Independent bit errors with probability p.
+ * - ge:p_gb:p_bg:p_good:p_bad  Gilbert-Elliott bursts: a good and a bad state
+ *                            with their own bit error rates, left with
+ *                            probability p_gb (good to bad) and p_bg per bit.
+ * - pass:profile.csv         Bit errors at the SNR of a random instant of the
+ *                            passes in a t_s,el_deg,margin_db profile from
+ *                            adcs_skissue.py (--profile). The margin is taken
+ *                            over the receiver's Eb/N0 threshold and turned
+ *                            into a bit error rate with the coherent BPSK curve.
+ *
+ * Every channel describes the link at SF12 / 125 kHz, the setting the link
+ * budget is calibrated for. Other settings move the SNR as lora_link_margin()
+ * in adcs_skissue.py does: each SF step down needs 2.5 dB more SNR and the
+ * noise grows with the bandwidth. The bit error rates (both states of ge:) are
+ * mapped through the BPSK curve with that offset, so a faster setting costs
+ * errors as well as saving airtime. CR changes the airtime only.
+ *
+ * WHY THIS STRUCTURE:
+ * - Error Gaps: Instead of one random draw per bit, the channel draws the
+ * geometric gap to the next error (and to the next state change), so a frame
+ * at a low error rate costs a handful of draws rather than 2104.
+ * - Vectorized PRNG: Uniforms come from eight interleaved xorshift128+ streams
+ * filled a buffer at a time; the loop has no dependency between lanes and
+ * compiles to AVX2/NEON vector code.
+ * - All Cores: Frames are simulated in fixed-size blocks spread over OpenMP
+ * threads. Every block seeds its own generator from the configuration and
+ * block number, and early stopping is checked only between rounds of a fixed
+ * number of blocks, so results do not depend on the thread count.
+ *
+ * Sweep file: one line per configuration group, "#" starts a comment:
+ *     payload,nroots,sf,bw_khz,cr,channel
+ * Any field may list alternatives separated by "|"; every combination is run.
+ * A channel alternative without a model name keeps the model of the first.
+ *     64|128|205,16|32|64,12,125,1,ber:1e-4|1e-3|3e-3|1e-2
+ *
+ * Compile with:
+ * gcc -O3 -march=native -fopenmp -Wall fer_simulator.c -o fer_simulator -lfec -lm
+ *
+ * Run with:
+ * ./fer_simulator [-n max_frames] [-e target_errors] [-s seed] [-o results.csv] <sweep_file>
+ *
+ * Options:
+ * -n   Frames per configuration at most (default: 1000000).
+ * -e   Stop a configuration after this many frame errors (default: 200).
+ * -s   Seed of the random streams (default: 1).
+ * -o   Also write the results as CSV.
+ */
+
+#define FX25_DECODER_LIBRARY
+#include "fx25_decoder.c"
+
+// =============================================================================
+// Constants
+// =============================================================================
+
+#define SIM_MAX_CONFIGS 4096
+#define SIM_MAX_PROFILES 16
+#define SIM_MAX_ALTERNATIVES 32
+#define SIM_BLOCK_FRAMES 256        // Frames per independently seeded block
+#define SIM_ROUND_BLOCKS 32         // Blocks between early-stopping checks
+#define SIM_DEFAULT_FRAMES 1000000
+#define SIM_DEFAULT_ERRORS 200
+#define PRNG_LANES 8
+#define PRNG_BUFFER 512             // Uniforms generated per refill
+#define PROFILE_EBN0_THR_DB 7.1     // EBN0_THR in adcs_skissue.py: margin 0 dB
+#define LORA_REF_SF 12              // Setting the channel parameters describe
+#define LORA_REF_BW_KHZ 125.0
+#define LORA_SF_STEP_DB 2.5         // Demodulator SNR floor per SF step (SX1276)
+
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+typedef enum {
+    CHANNEL_BER = 0,
+    CHANNEL_GILBERT_ELLIOTT,
+    CHANNEL_PASS
+} channel_type_t;
+
+/**
+ * @brief Link margins of the samples of a pass profile.
+ */
+typedef struct {
+    char filename[256];
+    double* margin_db;
+    int n_samples;
+} pass_profile_t;
+
+/**
+ * @brief A channel model and its parameters.
+ */
+typedef struct {
+    channel_type_t type;
+    char spec[300];       // As written in the sweep file
+    double ber;           // CHANNEL_BER
+    double p_gb, p_bg;    // CHANNEL_GILBERT_ELLIOTT: per-bit state transition probabilities
+    double ber_good, ber_bad;
+    const pass_profile_t* profile; // CHANNEL_PASS
+    double offset_db;     // SNR of the LoRa setting relative to SF12 / 125 kHz
+} channel_t;
+
+/**
+ * @brief One simulated configuration and its results.
+ */
+typedef struct {
+    int payload_len;
+    int code;             // Index into FX25_CODES
+    pass_window_t lora;   // Only sf, bw_khz and cr are used
+    channel_t channel;
+    long frames;
+    long frame_errors;
+    long undetected;      // Frames delivered with the wrong contents
+} sim_config_t;
+
+/**
+ * @brief Eight interleaved xorshift128+ generators and a buffer of uniforms.
+ */
+typedef struct {
+    uint64_t s0[PRNG_LANES], s1[PRNG_LANES];
+    double buffer[PRNG_BUFFER];
+    int pos;
+} prng_t;
+
+
+// =============================================================================
+// Vectorized PRNG Module
+// =============================================================================
+
+/**
+ * @brief splitmix64, used only to expand a seed into generator states.
+ */
+static uint64_t splitmix64(uint64_t* x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void prng_seed(prng_t* prng, uint64_t seed) {
+    for (int l = 0; l < PRNG_LANES; l++) {
+        prng->s0[l] = splitmix64(&seed);
+        prng->s1[l] = splitmix64(&seed) | 1; // Never an all-zero state
+    }
+    prng->pos = PRNG_BUFFER;
+}
+
+/**
+ * @brief Refills the buffer with uniforms in [0, 1).
+ * WHY: The top 52 bits are placed in the mantissa of a double in [1, 2) rather
+ * than converted with a multiply; AVX2 has no 64-bit integer to double
+ * conversion, and this keeps the whole loop vectorized.
+ */
+void prng_refill(prng_t* prng) {
+    for (int i = 0; i < PRNG_BUFFER; i += PRNG_LANES) {
+        for (int l = 0; l < PRNG_LANES; l++) {
+            uint64_t x = prng->s0[l];
+            uint64_t y = prng->s1[l];
+            prng->s0[l] = y;
+            x ^= x << 23;
+            x ^= x >> 17;
+            x ^= y ^ (y >> 26);
+            prng->s1[l] = x;
+            uint64_t bits = ((x + y) >> 12) | 0x3FF0000000000000ULL;
+            double u;
+            memcpy(&u, &bits, sizeof(u));
+            prng->buffer[i + l] = u - 1.0;
+        }
+    }
+    prng->pos = 0;
+}
+
+static inline double prng_uniform(prng_t* prng) {
+    if (prng->pos == PRNG_BUFFER) prng_refill(prng);
+    return prng->buffer[prng->pos++];
+}
+
+/**
+ * @brief Number of trials before the next success, for success probability p.
+ */
+static inline double prng_gap(prng_t* prng, double log_q) {
+    return floor(log(1.0 - prng_uniform(prng)) / log_q); // 1 - u is in (0, 1]
+}
+
+
+// =============================================================================
+// Channel Module
+// =============================================================================
+
+/**
+ * @brief Coherent BPSK bit error rate at an Eb/N0 in dB.
+ */
+static double bpsk_ber(double ebn0_db) {
+    return 0.5 * erfc(sqrt(pow(10.0, ebn0_db / 10.0)));
+}
+
+/**
+ * @brief Inverse of bpsk_ber(), by bisection (once per configuration).
+ */
+static double bpsk_ebn0_db(double ber) {
+    double lo = -40.0, hi = 40.0;
+    for (int i = 0; i < 60; i++) {
+        double mid = 0.5 * (lo + hi);
+        if (bpsk_ber(mid) > ber) lo = mid; else hi = mid;
+    }
+    return 0.5 * (lo + hi);
+}
+
+/**
+ * @brief SNR change of a LoRa setting relative to SF12 / 125 kHz, in dB.
+ */
+double lora_margin_offset_db(int sf, double bw_khz) {
+    return -LORA_SF_STEP_DB * (LORA_REF_SF - sf) - 10.0 * log10(bw_khz / LORA_REF_BW_KHZ);
+}
+
+/**
+ * @brief Moves a bit error rate along the BPSK curve by offset_db.
+ */
+static double shift_ber(double ber, double offset_db) {
+    if (ber <= 0.0 || ber >= 0.5 || offset_db == 0.0) return ber;
+    return bpsk_ber(bpsk_ebn0_db(ber) + offset_db);
+}
+
+/**
+ * @brief Refers a channel, given at SF12 / 125 kHz, to the LoRa setting of its configuration.
+ */
+void channel_set_lora(channel_t* channel, const pass_window_t* lora) {
+    channel->offset_db = lora_margin_offset_db(lora->sf, lora->bw_khz);
+    channel->ber = shift_ber(channel->ber, channel->offset_db);
+    channel->ber_good = shift_ber(channel->ber_good, channel->offset_db);
+    channel->ber_bad = shift_ber(channel->ber_bad, channel->offset_db);
+}
+
+/**
+ * @brief Flips bits of [start, end) independently with probability p.
+ * @return The number of bits flipped.
+ */
+static long flip_random_bits(prng_t* prng, uint8_t* frame, long start, long end, double p) {
+    if (p <= 0.0) return 0;
+    if (p >= 1.0) p = 1.0 - 1e-12;
+    double log_q = log1p(-p);
+    double pos = start + prng_gap(prng, log_q);
+    long flipped = 0;
+    while (pos < end) {
+        long bit = (long)pos;
+        frame[bit >> 3] ^= 0x80 >> (bit & 7);
+        flipped++;
+        pos += 1.0 + prng_gap(prng, log_q);
+    }
+    return flipped;
+}
+
+/**
+ * @brief Passes an on-air frame of n_bits through the channel.
+ * @return The number of bits flipped.
+ */
+long channel_apply(const channel_t* channel, prng_t* prng, uint8_t* frame, long n_bits) {
+    long flipped = 0;
+    switch (channel->type) {
+    case CHANNEL_BER:
+        flipped = flip_random_bits(prng, frame, 0, n_bits, channel->ber);
+        break;
+    case CHANNEL_GILBERT_ELLIOTT: {
+        // WHY: Each frame starts in the stationary state distribution, as if
+        // caught at a random instant of a long transmission.
+        int bad = prng_uniform(prng) * (channel->p_gb + channel->p_bg) < channel->p_gb;
+        long pos = 0;
+        while (pos < n_bits) {
+            double leave = bad ? channel->p_bg : channel->p_gb;
+            double stay = (leave > 0.0) ? 1.0 + prng_gap(prng, log1p(-leave)) : (double)n_bits;
+            long end = (pos + stay < n_bits) ? pos + (long)stay : n_bits;
+            flipped += flip_random_bits(prng, frame, pos, end, bad ? channel->ber_bad : channel->ber_good);
+            pos = end;
+            bad = !bad;
+        }
+        break;
+    }
+    case CHANNEL_PASS: {
+        const pass_profile_t* profile = channel->profile;
+        int sample = (int)(prng_uniform(prng) * profile->n_samples);
+        double ebn0_db = profile->margin_db[sample] + PROFILE_EBN0_THR_DB + channel->offset_db;
+        flipped = flip_random_bits(prng, frame, 0, n_bits, bpsk_ber(ebn0_db));
+        break;
+    }
+    }
+    return flipped;
+}
+
+/**
+ * @brief Loads the link margins of a pass profile.
+ * @return 0 on success, -1 on error.
+ */
+int load_pass_profile(pass_profile_t* profile, const char* filename) {
+    FILE* f = fopen(filename, "r");
+    if (!f) {
+        perror(filename);
+        return -1;
+    }
+    snprintf(profile->filename, sizeof(profile->filename), "%s", filename);
+    profile->margin_db = NULL;
+    profile->n_samples = 0;
+    int capacity = 0;
+    char line[256];
+    double t_s, el_deg, margin_db;
+    while (fgets(line, sizeof(line), f)) {
+        if (!parse_profile_line(line, &t_s, &el_deg, &margin_db)) continue;
+        if (profile->n_samples == capacity) {
+            capacity = capacity ? 2 * capacity : 1024;
+            double* grown = realloc(profile->margin_db, capacity * sizeof(double));
+            if (!grown) {
+                perror("Failed to allocate pass profile");
+                free(profile->margin_db);
+                fclose(f);
+                return -1;
+            }
+            profile->margin_db = grown;
+        }
+        profile->margin_db[profile->n_samples++] = margin_db;
+    }
+    fclose(f);
+    if (profile->n_samples == 0) {
+        fprintf(stderr, "Error: No samples in pass profile %s\n", filename);
+        free(profile->margin_db);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Parses a channel specification (see the file header).
+ * @param profiles Cache of loaded pass profiles, shared by all configurations.
+ * @return 0 on success, -1 on error.
+ */
+int parse_channel(const char* spec, channel_t* channel, pass_profile_t* profiles, int* n_profiles) {
+    memset(channel, 0, sizeof(*channel));
+    snprintf(channel->spec, sizeof(channel->spec), "%s", spec);
+    if (sscanf(spec, "ber:%lf", &channel->ber) == 1) {
+        channel->type = CHANNEL_BER;
+        return (channel->ber >= 0.0 && channel->ber <= 1.0) ? 0 : -1;
+    }
+    if (sscanf(spec, "ge:%lf:%lf:%lf:%lf", &channel->p_gb, &channel->p_bg,
+               &channel->ber_good, &channel->ber_bad) == 4) {
+        channel->type = CHANNEL_GILBERT_ELLIOTT;
+        return (channel->p_gb > 0.0 && channel->p_bg > 0.0) ? 0 : -1;
+    }
+    if (strncmp(spec, "pass:", 5) == 0) {
+        channel->type = CHANNEL_PASS;
+        for (int i = 0; i < *n_profiles; i++) {
+            if (strcmp(profiles[i].filename, spec + 5) == 0) {
+                channel->profile = &profiles[i];
+                return 0;
+            }
+        }
+        if (*n_profiles == SIM_MAX_PROFILES) {
+            fprintf(stderr, "Error: At most %d pass profiles per sweep\n", SIM_MAX_PROFILES);
+            return -1;
+        }
+        if (load_pass_profile(&profiles[*n_profiles], spec + 5) != 0) return -1;
+        channel->profile = &profiles[(*n_profiles)++];
+        return 0;
+    }
+    return -1;
+}
+
+
+// =============================================================================
+// Sweep File Module
+// =============================================================================
+
+/**
+ * @brief Splits a field into its "|"-separated alternatives (modifies field).
+ * @return The number of alternatives.
+ */
+static int split_alternatives(char* field, char** out) {
+    int n = 0;
+    for (char* token = strtok(field, "|"); token && n < SIM_MAX_ALTERNATIVES; token = strtok(NULL, "|")) {
+        while (*token == ' ') token++;
+        token[strcspn(token, " \r\n")] = '\0';
+        out[n++] = token;
+    }
+    return n;
+}
+
+/**
+ * @brief Reads a sweep file, expanding every line into all its combinations.
+ * @return The number of configurations, or -1 on error.
+ */
+int read_sweep_file(const char* filename, sim_config_t* configs, int max_configs,
+                    pass_profile_t* profiles, int* n_profiles) {
+    FILE* f = fopen(filename, "r");
+    if (!f) {
+        perror("Error opening sweep file");
+        return -1;
+    }
+    char line[1024];
+    int n_configs = 0, line_no = 0;
+    while (fgets(line, sizeof(line), f)) {
+        line_no++;
+        line[strcspn(line, "#\r\n")] = '\0';
+        char* fields[6];
+        int n_fields = 0;
+        for (char *p = line, *comma; n_fields < 6; p = comma + 1) {
+            fields[n_fields++] = p;
+            if ((comma = strchr(p, ',')) == NULL) break;
+            *comma = '\0';
+        }
+        if (n_fields == 1 && strspn(fields[0], " \t") == strlen(fields[0])) continue; // Blank
+        if (n_fields != 6) {
+            fprintf(stderr, "Error: %s:%d: expected payload,nroots,sf,bw_khz,cr,channel\n", filename, line_no);
+            fclose(f);
+            return -1;
+        }
+        char* alternatives[6][SIM_MAX_ALTERNATIVES];
+        int counts[6], index[6] = { 0 };
+        for (int i = 0; i < 6; i++) {
+            counts[i] = split_alternatives(fields[i], alternatives[i]);
+            if (counts[i] == 0) {
+                fprintf(stderr, "Error: %s:%d: empty field\n", filename, line_no);
+                fclose(f);
+                return -1;
+            }
+        }
+        // Odometer over every combination of alternatives
+        while (1) {
+            if (n_configs == max_configs) {
+                fprintf(stderr, "Error: More than %d configurations in %s\n", max_configs, filename);
+                fclose(f);
+                return -1;
+            }
+            sim_config_t* c = &configs[n_configs];
+            memset(c, 0, sizeof(*c));
+            int nroots = atoi(alternatives[1][index[1]]);
+            c->payload_len = atoi(alternatives[0][index[0]]);
+            c->lora.sf = atoi(alternatives[2][index[2]]);
+            c->lora.bw_khz = atof(alternatives[3][index[3]]);
+            c->lora.cr = atoi(alternatives[4][index[4]]);
+            c->code = -1;
+            for (int k = 0; k < FX25_NUM_CODES; k++) {
+                if (FX25_CODES[k].nroots == nroots && FX25_CODES[k].n == FX25_N) c->code = k; // Full-length codes only
+            }
+            if (c->code < 0 || c->payload_len < 1 ||
+                c->lora.sf < 6 || c->lora.sf > 12 || c->lora.bw_khz <= 0.0 || c->lora.cr < 1 || c->lora.cr > 4) {
+                fprintf(stderr, "Error: %s:%d: invalid configuration (payload %d, nroots %d, SF%d, %g kHz, CR %d)\n",
+                        filename, line_no, c->payload_len, nroots, c->lora.sf, c->lora.bw_khz, c->lora.cr);
+                fclose(f);
+                return -1;
+            }
+            // WHY: "ber:1e-3|3e-3" reads naturally, so a bare alternative
+            // takes the model name of the first one.
+            char spec[300];
+            const char* channel = alternatives[5][index[5]];
+            const char* model_end = strchr(alternatives[5][0], ':');
+            if (!strchr(channel, ':') && model_end) {
+                snprintf(spec, sizeof(spec), "%.*s%s", (int)(model_end + 1 - alternatives[5][0]),
+                         alternatives[5][0], channel);
+            } else {
+                snprintf(spec, sizeof(spec), "%s", channel);
+            }
+            if (parse_channel(spec, &c->channel, profiles, n_profiles) != 0) {
+                fprintf(stderr, "Error: %s:%d: invalid channel \"%s\"\n", filename, line_no, spec);
+                fclose(f);
+                return -1;
+            }
+            channel_set_lora(&c->channel, &c->lora);
+            // WHY: Grids over payload and code naturally include payloads too
+            // large for the strongest codes; those combinations are dropped.
+            if (c->payload_len <= fx25_payload_capacity(c->code)) {
+                n_configs++;
+            } else {
+                fprintf(stderr, "Note: %s:%d: skipping %d-byte payload, RS(255, %d) carries at most %d\n",
+                        filename, line_no, c->payload_len, FX25_N - nroots, fx25_payload_capacity(c->code));
+            }
+
+            int i = 5;
+            while (i >= 0 && ++index[i] == counts[i]) index[i--] = 0;
+            if (i < 0) break;
+        }
+    }
+    fclose(f);
+    return n_configs;
+}
+
+
+// =============================================================================
+// Simulation Module
+// =============================================================================
+
+/**
+ * @brief Simulates one block of frames of a configuration.
+ * @param errors Receives the frame errors and undetected errors of the block.
+ */
+void simulate_block(fx25_encoder_t* rs, const sim_config_t* config, uint64_t seed,
+                    long* errors, long* undetected) {
+    ax25_address_t src = { .call = "N0CALL", .ssid = 1 };
+    ax25_address_t dest = { .call = "CQ", .ssid = 0 };
+    uint8_t payload[FX25_N], ax25[512], frame[FX25_FRAME_LEN];
+    fx25_result_t result;
+    prng_t prng;
+    prng_seed(&prng, seed);
+    *errors = 0;
+    *undetected = 0;
+    for (int f = 0; f < SIM_BLOCK_FRAMES; f++) {
+        for (int i = 0; i < config->payload_len; i++) payload[i] = (uint8_t)(prng_uniform(&prng) * 256.0);
+        int ax25_len = ax25_generate_ui_frame(ax25, dest, src, payload, config->payload_len);
+        fx25_encode_frame(rs, config->code, ax25, ax25_len, frame);
+        // WHY: A frame the channel left untouched always decodes; skipping the
+        // decoder for it nearly halves the cost of low error rate points.
+        if (channel_apply(&config->channel, &prng, frame, 8L * FX25_FRAME_LEN) == 0) continue;
+        if (!fx25_decode_frame(rs, frame, NULL, 0, &result)) {
+            (*errors)++;
+        } else if (result.ax25_len != ax25_len || memcmp(result.ax25, ax25, ax25_len) != 0) {
+            (*errors)++;
+            (*undetected)++;
+        }
+    }
+}
+
+/**
+ * @brief Runs a configuration until max_frames or target_errors is reached.
+ */
+void simulate_config(fx25_encoder_t* rs, sim_config_t* config, int config_index, uint64_t seed,
+                     long max_frames, long target_errors) {
+    long max_blocks = (max_frames + SIM_BLOCK_FRAMES - 1) / SIM_BLOCK_FRAMES;
+    config->frames = config->frame_errors = config->undetected = 0;
+    for (long first = 0; first < max_blocks && config->frame_errors < target_errors; first += SIM_ROUND_BLOCKS) {
+        long last = (first + SIM_ROUND_BLOCKS < max_blocks) ? first + SIM_ROUND_BLOCKS : max_blocks;
+        long round_errors = 0, round_undetected = 0;
+        #pragma omp parallel for schedule(dynamic, 1) reduction(+:round_errors, round_undetected)
+        for (long b = first; b < last; b++) {
+            long errors, undetected;
+            uint64_t block_seed = seed ^ ((uint64_t)config_index << 40) ^ (uint64_t)b * 0xD1B54A32D192ED03ULL;
+            simulate_block(rs, config, block_seed, &errors, &undetected);
+            round_errors += errors;
+            round_undetected += undetected;
+        }
+        config->frames += (last - first) * SIM_BLOCK_FRAMES;
+        config->frame_errors += round_errors;
+        config->undetected += round_undetected;
+    }
+}
+
+/**
+ * @brief Payload bits delivered per second of airtime.
+ */
+double config_goodput(const sim_config_t* config) {
+    double fer = (double)config->frame_errors / config->frames;
+    return (1.0 - fer) * 8.0 * config->payload_len / frame_airtime(FX25_FRAME_LEN, &config->lora);
+}
+
+
+// =============================================================================
+// Main Application
+// =============================================================================
+
+void print_simulator_usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [-n max_frames] [-e target_errors] [-s seed] [-o results.csv] <sweep_file>\n", prog);
+}
+
+int main(int argc, char* argv[]) {
+    // --- 1. Argument Parsing ---
+    long max_frames = SIM_DEFAULT_FRAMES;
+    long target_errors = SIM_DEFAULT_ERRORS;
+    uint64_t seed = 1;
+    const char* csv_filename = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:e:s:o:")) != -1) {
+        switch (opt) {
+        case 'n': max_frames = atol(optarg); break;
+        case 'e': target_errors = atol(optarg); break;
+        case 's': seed = strtoull(optarg, NULL, 0); break;
+        case 'o': csv_filename = optarg; break;
+        default:
+            print_simulator_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (argc - optind < 1 || max_frames < 1 || target_errors < 1) {
+        print_simulator_usage(argv[0]);
+        return 1;
+    }
+
+    // --- 2. Initialization ---
+    sim_config_t* configs = malloc(SIM_MAX_CONFIGS * sizeof(sim_config_t));
+    pass_profile_t* profiles = malloc(SIM_MAX_PROFILES * sizeof(pass_profile_t));
+    if (!configs || !profiles) {
+        perror("Failed to allocate configurations");
+        free(configs);
+        free(profiles);
+        return 1;
+    }
+    int n_profiles = 0;
+    int n_configs = read_sweep_file(argv[optind], configs, SIM_MAX_CONFIGS, profiles, &n_profiles);
+    fx25_encoder_t* rs = (n_configs > 0) ? fx25_init() : NULL;
+    FILE* csv = (rs && csv_filename) ? fopen(csv_filename, "w") : NULL;
+    if (!rs || (csv_filename && !csv)) {
+        if (n_configs == 0) fprintf(stderr, "Error: No configurations in %s\n", argv[optind]);
+        if (n_configs > 0 && !rs) fprintf(stderr, "Error: Failed to initialize Reed-Solomon codecs.\n");
+        if (rs && csv_filename && !csv) perror("Error creating results file");
+        fx25_cleanup(rs);
+        for (int i = 0; i < n_profiles; i++) free(profiles[i].margin_db);
+        free(profiles);
+        free(configs);
+        return 1;
+    }
+
+    // --- 3. Simulation ---
+#ifdef _OPENMP
+    printf("Simulating %d configuration(s) on %d thread(s)\n\n", n_configs, omp_get_max_threads());
+#else
+    printf("Simulating %d configuration(s) on 1 thread (no OpenMP)\n\n", n_configs);
+#endif
+    printf("%7s %6s %4s %7s %3s  %-28s %9s %10s %11s\n",
+           "Payload", "Roots", "SF", "BW kHz", "CR", "Channel", "Frames", "FER", "Goodput bps");
+    if (csv) {
+        fprintf(csv, "payload,nroots,sf,bw_khz,cr,channel,frames,frame_errors,undetected,fer,goodput_bps\n");
+    }
+    long total_frames = 0;
+    double t0 = now_seconds();
+    for (int i = 0; i < n_configs; i++) {
+        sim_config_t* c = &configs[i];
+        simulate_config(rs, c, i, seed, max_frames, target_errors);
+        total_frames += c->frames;
+        double fer = (double)c->frame_errors / c->frames;
+        printf("%7d %6d %4d %7g %3d  %-28.28s %9ld %10.3e %11.1f\n", c->payload_len, FX25_CODES[c->code].nroots,
+               c->lora.sf, c->lora.bw_khz, c->lora.cr, c->channel.spec, c->frames, fer, config_goodput(c));
+        if (csv) {
+            fprintf(csv, "%d,%d,%d,%g,%d,%s,%ld,%ld,%ld,%.6e,%.3f\n", c->payload_len, FX25_CODES[c->code].nroots,
+                    c->lora.sf, c->lora.bw_khz, c->lora.cr, c->channel.spec, c->frames, c->frame_errors,
+                    c->undetected, fer, config_goodput(c));
+        }
+    }
+    double elapsed = now_seconds() - t0;
+    printf("\n%ld frames in %.1f s (%.0f frames/s)\n", total_frames, elapsed, total_frames / elapsed);
+
+    // --- 4. Cleanup ---
+    if (csv) {
+        fclose(csv);
+        printf("Results written to %s\n", csv_filename);
+    }
+    fx25_cleanup(rs);
+    for (int i = 0; i < n_profiles; i++) free(profiles[i].margin_db);
+    free(profiles);
+    free(configs);
+    return 0;
+}
@@ -0,0 +1,402 @@
+/**
+ * @file fx25_decoder.c
+ * @brief Ground-station FX.25 decoder with soft-decision (GMD/Chase) RS decoding.
+ *
+ * Reads a KISS stream of received FX.25 frames, identifies the RS code from
+ * the correlation tag, decodes the codeword and writes the AX.25 frames whose
+ * FCS verifies as a KISS stream, as a TNC would deliver them.
+ *
+ * With soft input (-S), a frame that plain decoding cannot correct is retried
+ * with the least reliable bytes erased: trial e erases the e least reliable
+ * bytes, e = 1 .. nroots. An erasure costs one check byte instead of the two an
+ * unknown error costs, so trials can correct up to twice as many bad bytes
+ * when the demodulator's reliabilities point at them (generalized minimum
+ * distance decoding, with Chase-style trials of every erasure count).
+ *
+ * WHY THIS STRUCTURE:
+ * - Shared Code: The packetizer is built in with PACKETIZER_LIBRARY defined,
+ * so the codes, tags and CRC are the same on both ends.
+ * - Parallel Trials: The trials are independent, so they are spread over all
+ * cores (OpenMP). The first trial whose output passes the AX.25 FCS wins and
+ * stops all later ones, which bounds the decode latency; picking the lowest
+ * successful trial keeps the result independent of the thread count.
+ * - Reusable: Other ground tools build this file in with FX25_DECODER_LIBRARY.
+ *
+ * Compile with:
+ * gcc -O2 -fopenmp -Wall fx25_decoder.c -o fx25_decoder -lfec -lm
+ *
+ * Run with:
+ * ./fx25_decoder [-S] [-t max_trials] <input_kiss_file> <output_kiss_file>
+ * ./fx25_decoder -b
+ *
+ * Options:
+ * -S   Input frames carry one soft symbol per byte (0 = confident 0,
+ *      255 = confident 1, 128 = no information) instead of hard bytes.
+ * -t   Maximum erasure trials per frame (default: all, one per check byte).
+ * -b   Benchmark hard versus GMD decoding on a simulated AWGN channel.
+ */
+
+#ifndef PACKETIZER_LIBRARY
+#define PACKETIZER_LIBRARY
+#include "satellite_packetizer.c"
+#endif
+
+#include <math.h>
+#include <limits.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// =============================================================================
+// Constants
+// =============================================================================
+
+#define FX25_FRAME_LEN (8 + FX25_N)  // Correlation tag + longest codeword
+#define FX25_TAG_MAX_ERRORS 12       // Bit errors tolerated in a correlation tag
+#define SOFT_ERASURE 128             // Soft symbol carrying no information
+
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief Result of decoding one FX.25 frame.
+ */
+typedef struct {
+    int code;      // Index into FX25_CODES, -1 if the tag was not recognized
+    int trial;     // Erasures used by the successful trial (0: plain decoding), -1 if failed
+    int corrected; // Byte errors and erasures corrected
+    int ax25_len;  // Length of the recovered AX.25 frame, 0 if failed
+    uint8_t ax25[FX25_N];
+} fx25_result_t;
+
+
+// =============================================================================
+// FX.25 Decoder Module
+// =============================================================================
+
+/**
+ * @brief Identifies the RS code from a received correlation tag.
+ * @return The index into FX25_CODES of the nearest tag, or -1 if none is
+ * within FX25_TAG_MAX_ERRORS bits.
+ */
+int fx25_match_tag(const uint8_t* tag) {
+    int best = -1, best_errors = FX25_TAG_MAX_ERRORS + 1;
+    for (int i = 0; i < FX25_NUM_CODES; i++) {
+        int errors = 0;
+        for (int b = 0; b < 8; b++) {
+            errors += __builtin_popcount(tag[b] ^ FX25_CODES[i].tag[b]);
+        }
+        if (errors < best_errors) {
+            best_errors = errors;
+            best = i;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Finds the AX.25 frame at the start of a decoded data block.
+ * WHY: The frame is zero padded to the block, so it ends at the last non-zero
+ * byte or up to two bytes later (FCS bytes may be zero); the FCS picks the one.
+ * @return The AX.25 frame length, or 0 if no candidate passes the FCS.
+ */
+int fx25_find_ax25(const uint8_t* data, int k) {
+    int last = k - 1;
+    while (last >= 0 && data[last] == 0) last--;
+    for (int length = last + 1; length <= last + 3 && length <= k; length++) {
+        if (length < AX25_OVERHEAD) continue;
+        uint16_t fcs = calculate_crc(data, length - 2);
+        if ((fcs & 0xFF) == data[length - 2] && (fcs >> 8) == data[length - 1]) {
+            return length;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Orders (reliability, position) pairs packed as reliability << 16 | position.
+ */
+static int compare_reliability(const void* a, const void* b) {
+    int ka = *(const int*)a, kb = *(const int*)b;
+    return (ka > kb) - (ka < kb);
+}
+
+/**
+ * @brief Decodes one FX.25 frame, with erasure trials when reliabilities are given.
+ * @param frame Tag and codeword, 8 + n hard-decision bytes for the code in the tag.
+ * @param reliability Per-byte reliability of the codeword (0 = unknown),
+ * or NULL for plain hard-decision decoding.
+ * @param max_trials Largest number of erasures to try.
+ * @return 1 if an AX.25 frame with a valid FCS was recovered, 0 otherwise.
+ */
+int fx25_decode_frame(fx25_encoder_t* rs, const uint8_t* frame, const uint8_t* reliability,
+                      int max_trials, fx25_result_t* result) {
+    result->code = fx25_match_tag(frame);
+    result->trial = -1;
+    result->corrected = 0;
+    result->ax25_len = 0;
+    if (result->code < 0) {
+        return 0;
+    }
+    int n = FX25_CODES[result->code].n;
+    int nroots = FX25_CODES[result->code].nroots;
+    int k = n - nroots;
+    void* handle = rs->rs_handle[result->code];
+    const uint8_t* codeword = frame + 8;
+
+    int order[FX25_N];
+    int n_trials = 1;
+    if (reliability) {
+        // Least reliable first; ties keep codeword order
+        for (int i = 0; i < n; i++) order[i] = (reliability[i] << 16) | i;
+        qsort(order, n, sizeof(int), compare_reliability);
+        for (int i = 0; i < n; i++) order[i] &= 0xFFFF;
+        n_trials = 1 + ((max_trials < nroots) ? max_trials : nroots);
+    }
+
+    int best = INT_MAX;
+    #pragma omp parallel for schedule(dynamic, 1) if (n_trials > 1)
+    for (int trial = 0; trial < n_trials; trial++) {
+        int current;
+        #pragma omp atomic read
+        current = best;
+        if (trial > current) continue; // An earlier trial already succeeded
+
+        uint8_t block[FX25_N];
+        int eras_pos[FX25_N];
+        memcpy(block, codeword, n);
+        memcpy(eras_pos, order, trial * sizeof(int));
+        int corrected = decode_rs_char(handle, block, eras_pos, trial);
+        if (corrected < 0) continue;
+        int length = fx25_find_ax25(block, k);
+        if (length == 0) continue; // Miscorrection, caught by the FCS
+
+        #pragma omp critical(fx25_result)
+        {
+            if (trial < best) {
+                #pragma omp atomic write
+                best = trial;
+                result->trial = trial;
+                result->corrected = corrected;
+                result->ax25_len = length;
+                memcpy(result->ax25, block, length);
+            }
+        }
+    }
+    return result->ax25_len > 0;
+}
+
+/**
+ * @brief Splits soft symbols into hard bytes and per-byte reliabilities.
+ * A byte is as reliable as its least reliable bit.
+ */
+void soft_to_bytes(const uint8_t* symbols, int n_bytes, uint8_t* bytes, uint8_t* reliability) {
+    for (int i = 0; i < n_bytes; i++) {
+        uint8_t byte = 0, weakest = SOFT_ERASURE;
+        for (int b = 0; b < 8; b++) {
+            uint8_t s = symbols[8 * i + b];
+            int margin = (s >= SOFT_ERASURE) ? s - SOFT_ERASURE : SOFT_ERASURE - 1 - s;
+            byte = (byte << 1) | (s >= SOFT_ERASURE);
+            if (margin < weakest) weakest = margin;
+        }
+        bytes[i] = byte;
+        reliability[i] = weakest;
+    }
+}
+
+
+#ifndef FX25_DECODER_LIBRARY
+
+// =============================================================================
+// Benchmark Module
+// =============================================================================
+
+#define BENCH_FRAMES 2000
+#define SOFT_SCALE 32.0  // Soft units per unit of BPSK amplitude
+
+/**
+ * @brief xorshift64* generator; rand() is far too slow to feed the noise model.
+ */
+static uint64_t bench_rng = 0x9E3779B97F4A7C15ULL;
+
+double bench_uniform(void) {
+    bench_rng ^= bench_rng >> 12;
+    bench_rng ^= bench_rng << 25;
+    bench_rng ^= bench_rng >> 27;
+    return ((bench_rng * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double bench_gaussian(void) {
+    double u = bench_uniform();
+    return sqrt(-2.0 * log(u > 0.0 ? u : 1e-300)) * cos(2.0 * M_PI * bench_uniform());
+}
+
+/**
+ * @brief Hard versus GMD frame error rate and decode latency over BPSK/AWGN.
+ * @return 0 on success, 1 on error.
+ */
+int run_fx25_benchmark(fx25_encoder_t* rs) {
+    ax25_address_t src = { .call = "N0CALL", .ssid = 1 };
+    ax25_address_t dest = { .call = "CQ", .ssid = 0 };
+    uint8_t payload[FX25_N], ax25[512], frame[FX25_FRAME_LEN];
+    uint8_t symbols[8 * FX25_FRAME_LEN], bytes[FX25_FRAME_LEN], reliability[FX25_FRAME_LEN];
+    int payload_len = fx25_payload_capacity(FX25_CODE_DEFAULT);
+    double rate = (double)FX25_K / FX25_N;
+    fx25_result_t result;
+
+#ifdef _OPENMP
+    printf("\n  RS(255,223), %d-byte payloads, %d frames per point, %d thread(s)\n",
+           payload_len, BENCH_FRAMES, omp_get_max_threads());
+#else
+    printf("\n  RS(255,223), %d-byte payloads, %d frames per point, 1 thread (no OpenMP)\n",
+           payload_len, BENCH_FRAMES);
+#endif
+    printf("  %8s %10s %10s %10s %12s %12s\n", "Eb/N0", "Hard FER", "GMD FER", "AvgTrials", "Mean(us)", "Worst(us)");
+    for (double ebn0 = 4.0; ebn0 <= 7.01; ebn0 += 0.5) {
+        double sigma = sqrt(1.0 / (2.0 * rate * pow(10.0, ebn0 / 10.0)));
+        long hard_errors = 0, gmd_errors = 0, trials = 0;
+        double total_time = 0.0, worst_time = 0.0;
+        for (int f = 0; f < BENCH_FRAMES; f++) {
+            for (int i = 0; i < payload_len; i++) payload[i] = bench_uniform() * 256.0;
+            int ax25_len = ax25_generate_ui_frame(ax25, dest, src, payload, payload_len);
+            fx25_encode_frame(rs, FX25_CODE_DEFAULT, ax25, ax25_len, frame);
+            // WHY: The tag goes over the same channel but is matched by distance;
+            // only the codeword is at stake here.
+            for (int i = 0; i < 8 * FX25_FRAME_LEN; i++) {
+                double x = ((frame[i >> 3] >> (7 - (i & 7))) & 1) ? 1.0 : -1.0;
+                double soft = SOFT_ERASURE + SOFT_SCALE * (x + sigma * bench_gaussian());
+                symbols[i] = (soft < 0.0) ? 0 : (soft > 255.0) ? 255 : (uint8_t)lrint(soft);
+            }
+            soft_to_bytes(symbols, FX25_FRAME_LEN, bytes, reliability);
+
+            hard_errors += !fx25_decode_frame(rs, bytes, NULL, 0, &result) ||
+                           result.ax25_len != ax25_len || memcmp(result.ax25, ax25, ax25_len);
+            double t0 = now_seconds();
+            int ok = fx25_decode_frame(rs, bytes, reliability + 8, FX25_N, &result);
+            double dt = now_seconds() - t0;
+            total_time += dt;
+            if (dt > worst_time) worst_time = dt;
+            gmd_errors += !ok || result.ax25_len != ax25_len || memcmp(result.ax25, ax25, ax25_len);
+            trials += ok ? result.trial + 1 : FX25_CODES[FX25_CODE_DEFAULT].nroots + 1;
+        }
+        printf("  %6.1fdB %10.2e %10.2e %10.1f %12.1f %12.1f\n", ebn0,
+               (double)hard_errors / BENCH_FRAMES, (double)gmd_errors / BENCH_FRAMES,
+               (double)trials / BENCH_FRAMES, total_time / BENCH_FRAMES * 1e6, worst_time * 1e6);
+    }
+    printf("  (BPSK/AWGN, 8-bit soft symbols; trials counted up to the first FCS match)\n");
+    return 0;
+}
+
+
+// =============================================================================
+// Main Application
+// =============================================================================
+
+void print_fx25_usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [-S] [-t max_trials] <input_kiss_file> <output_kiss_file>\n"
+                    "       %s -b\n", prog, prog);
+}
+
+int main(int argc, char* argv[]) {
+    // --- 1. Argument Parsing ---
+    int soft_input = 0;
+    int max_trials = FX25_N;
+    int benchmark = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "St:b")) != -1) {
+        switch (opt) {
+        case 'S': soft_input = 1; break;
+        case 't': max_trials = atoi(optarg); break;
+        case 'b': benchmark = 1; break;
+        default:
+            print_fx25_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // --- 2. Initialization ---
+    fx25_encoder_t* rs = fx25_init();
+    if (!rs) {
+        fprintf(stderr, "Error: Failed to initialize Reed-Solomon codecs.\n");
+        return 1;
+    }
+    if (benchmark) {
+        int status = run_fx25_benchmark(rs);
+        fx25_cleanup(rs);
+        return status;
+    }
+    if (argc - optind < 2 || max_trials < 0) {
+        print_fx25_usage(argv[0]);
+        fx25_cleanup(rs);
+        return 1;
+    }
+    const char* input_filename = argv[optind];
+    const char* output_filename = argv[optind + 1];
+
+    FILE* input_file = fopen(input_filename, "rb");
+    if (!input_file) {
+        perror("Error opening input file");
+        fx25_cleanup(rs);
+        return 1;
+    }
+    FILE* output_file = fopen(output_filename, "wb");
+    if (!output_file) {
+        perror("Error creating output file");
+        fclose(input_file);
+        fx25_cleanup(rs);
+        return 1;
+    }
+
+    // --- 3. Decode Loop ---
+    uint8_t frame[8 * FX25_FRAME_LEN];
+    uint8_t bytes[FX25_FRAME_LEN], reliability[FX25_FRAME_LEN];
+    fx25_result_t result;
+    int frame_count = 0, plain = 0, recovered = 0, failed = 0, skipped = 0;
+    long corrected = 0;
+    int length;
+    while ((length = read_kiss_frame(input_file, frame, soft_input ? 8 * FX25_FRAME_LEN : FX25_FRAME_LEN)) >= 0) {
+        frame_count++;
+        const uint8_t* hard = frame;
+        int n_bytes = soft_input ? length / 8 : length;
+        if (soft_input) {
+            soft_to_bytes(frame, n_bytes, bytes, reliability);
+            hard = bytes;
+        }
+        // WHY: Codes differ in length (RS(48, 32) voice frames are short), so
+        // the tag says how long the frame has to be. A full-length frame with
+        // an unknown tag is still counted as a failed decode, as before.
+        int code = (n_bytes >= 8) ? fx25_match_tag(hard) : -1;
+        int expected = (code >= 0) ? 8 + FX25_CODES[code].n : FX25_FRAME_LEN;
+        if (n_bytes != expected || (soft_input && length % 8)) {
+            fprintf(stderr, "Warning: Skipping frame %d: not an FX.25 frame (%d bytes)\n", frame_count, length);
+            skipped++;
+            continue;
+        }
+        if (!fx25_decode_frame(rs, hard, soft_input ? reliability + 8 : NULL, max_trials, &result)) {
+            failed++;
+            continue;
+        }
+        write_kiss_frame(output_file, result.ax25, result.ax25_len);
+        corrected += result.corrected;
+        if (result.trial == 0) {
+            plain++;
+        } else {
+            recovered++;
+        }
+    }
+
+    // --- 4. Cleanup ---
+    fclose(input_file);
+    fclose(output_file);
+    fx25_cleanup(rs);
+
+    printf("Decoded %d of %d frame(s): %d by plain RS decoding, %d recovered by erasure trials\n",
+           plain + recovered, frame_count, plain, recovered);
+    printf("  %d failed, %d skipped, %ld byte(s) corrected\n", failed, skipped, corrected);
+    printf("Output written to %s\n", output_filename);
+    return 0;
+}
+
+#endif // FX25_DECODER_LIBRARY
@@ -0,0 +1,611 @@
+/**
+ * @file ldpc_decoder.c
+ * @brief Ground-station decoder for the LDPC frame format (packetizer -L).
+ *
+ * Reads the KISS stream of a -L downlink, decodes every quasi-cyclic LDPC
+ * codeword with layered normalized min-sum, checks the AX.25 FCS and writes
+ * the recovered AX.25 frames as a KISS stream, as a TNC would deliver them.
+ *
+ * WHY THIS STRUCTURE:
+ * - Shared Code: The packetizer is built in with PACKETIZER_LIBRARY defined,
+ * so both ends construct the same base matrix from ldpc_build().
+ * - Layered Schedule: Each block row updates the posteriors as soon as it is
+ * processed, which converges in about half the iterations of flooding.
+ * - int8 SIMD: The Z checks of a block row are independent, so messages are
+ * kept as saturating 8-bit integers and updated 32 (AVX2) or 16 (SSE4.1,
+ * NEON) at a time. Build with -DLDPC_NO_SIMD for the scalar reference.
+ * - Early Termination: The syndrome is checked after every iteration, so
+ * clean frames cost one or two iterations instead of the maximum.
+ *
+ * Compile with:
+ * gcc -O3 -march=native -Wall ldpc_decoder.c -o ldpc_decoder -lfec -lm
+ *
+ * Run with:
+ * ./ldpc_decoder [-S] [-i max_iterations] <input_kiss_file> <output_kiss_file>
+ * ./ldpc_decoder -b
+ *
+ * Options:
+ * -S   Input frames carry one soft symbol per byte (0 = confident 0,
+ *      255 = confident 1, 128 = no information) instead of packed hard bits.
+ * -i   Maximum decoder iterations per frame (default 30).
+ * -b   Benchmark: frame error rate versus Eb/N0 and decoder throughput.
+ */
+
+#define PACKETIZER_LIBRARY
+#include "satellite_packetizer.c"
+
+#include <math.h>
+
+// =============================================================================
+// SIMD Primitives
+// =============================================================================
+// WHY: The min-sum kernel is written once against these few operations; each
+// target maps them to its saturating int8 instructions.
+
+#if defined(__AVX2__) && !defined(LDPC_NO_SIMD)
+#include <immintrin.h>
+#define LDPC_SIMD "AVX2"
+#define LDPC_LANES 32
+typedef __m256i ldpc_vec_t;
+static inline ldpc_vec_t v_load(const int8_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+static inline void v_store(int8_t* p, ldpc_vec_t x) { _mm256_storeu_si256((__m256i*)p, x); }
+static inline ldpc_vec_t v_set1(int8_t x) { return _mm256_set1_epi8(x); }
+static inline ldpc_vec_t v_adds(ldpc_vec_t a, ldpc_vec_t b) { return _mm256_adds_epi8(a, b); }
+static inline ldpc_vec_t v_subs(ldpc_vec_t a, ldpc_vec_t b) { return _mm256_subs_epi8(a, b); }
+static inline ldpc_vec_t v_min(ldpc_vec_t a, ldpc_vec_t b) { return _mm256_min_epi8(a, b); }
+static inline ldpc_vec_t v_max(ldpc_vec_t a, ldpc_vec_t b) { return _mm256_max_epi8(a, b); }
+static inline ldpc_vec_t v_abs(ldpc_vec_t a) { return _mm256_abs_epi8(a); }
+static inline ldpc_vec_t v_xor(ldpc_vec_t a, ldpc_vec_t b) { return _mm256_xor_si256(a, b); }
+static inline ldpc_vec_t v_or(ldpc_vec_t a, ldpc_vec_t b) { return _mm256_or_si256(a, b); }
+static inline ldpc_vec_t v_sign(ldpc_vec_t a, ldpc_vec_t b) { return _mm256_sign_epi8(a, b); }
+static inline ldpc_vec_t v_select_eq(ldpc_vec_t x, ldpc_vec_t y, ldpc_vec_t a, ldpc_vec_t b) {
+    return _mm256_blendv_epi8(b, a, _mm256_cmpeq_epi8(x, y));
+}
+static inline ldpc_vec_t v_scale(ldpc_vec_t m) {
+    ldpc_vec_t half = _mm256_and_si256(_mm256_srli_epi16(m, 1), _mm256_set1_epi8(0x7F));
+    return _mm256_avg_epu8(m, half);
+}
+
+#elif defined(__SSE4_1__) && !defined(LDPC_NO_SIMD)
+#include <smmintrin.h>
+#define LDPC_SIMD "SSE4.1"
+#define LDPC_LANES 16
+typedef __m128i ldpc_vec_t;
+static inline ldpc_vec_t v_load(const int8_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+static inline void v_store(int8_t* p, ldpc_vec_t x) { _mm_storeu_si128((__m128i*)p, x); }
+static inline ldpc_vec_t v_set1(int8_t x) { return _mm_set1_epi8(x); }
+static inline ldpc_vec_t v_adds(ldpc_vec_t a, ldpc_vec_t b) { return _mm_adds_epi8(a, b); }
+static inline ldpc_vec_t v_subs(ldpc_vec_t a, ldpc_vec_t b) { return _mm_subs_epi8(a, b); }
+static inline ldpc_vec_t v_min(ldpc_vec_t a, ldpc_vec_t b) { return _mm_min_epi8(a, b); }
+static inline ldpc_vec_t v_max(ldpc_vec_t a, ldpc_vec_t b) { return _mm_max_epi8(a, b); }
+static inline ldpc_vec_t v_abs(ldpc_vec_t a) { return _mm_abs_epi8(a); }
+static inline ldpc_vec_t v_xor(ldpc_vec_t a, ldpc_vec_t b) { return _mm_xor_si128(a, b); }
+static inline ldpc_vec_t v_or(ldpc_vec_t a, ldpc_vec_t b) { return _mm_or_si128(a, b); }
+static inline ldpc_vec_t v_sign(ldpc_vec_t a, ldpc_vec_t b) { return _mm_sign_epi8(a, b); }
+static inline ldpc_vec_t v_select_eq(ldpc_vec_t x, ldpc_vec_t y, ldpc_vec_t a, ldpc_vec_t b) {
+    return _mm_blendv_epi8(b, a, _mm_cmpeq_epi8(x, y));
+}
+static inline ldpc_vec_t v_scale(ldpc_vec_t m) {
+    ldpc_vec_t half = _mm_and_si128(_mm_srli_epi16(m, 1), _mm_set1_epi8(0x7F));
+    return _mm_avg_epu8(m, half);
+}
+
+#elif defined(__ARM_NEON) && defined(__aarch64__) && !defined(LDPC_NO_SIMD)
+#include <arm_neon.h>
+#define LDPC_SIMD "NEON"
+#define LDPC_LANES 16
+typedef int8x16_t ldpc_vec_t;
+static inline ldpc_vec_t v_load(const int8_t* p) { return vld1q_s8(p); }
+static inline void v_store(int8_t* p, ldpc_vec_t x) { vst1q_s8(p, x); }
+static inline ldpc_vec_t v_set1(int8_t x) { return vdupq_n_s8(x); }
+static inline ldpc_vec_t v_adds(ldpc_vec_t a, ldpc_vec_t b) { return vqaddq_s8(a, b); }
+static inline ldpc_vec_t v_subs(ldpc_vec_t a, ldpc_vec_t b) { return vqsubq_s8(a, b); }
+static inline ldpc_vec_t v_min(ldpc_vec_t a, ldpc_vec_t b) { return vminq_s8(a, b); }
+static inline ldpc_vec_t v_max(ldpc_vec_t a, ldpc_vec_t b) { return vmaxq_s8(a, b); }
+static inline ldpc_vec_t v_abs(ldpc_vec_t a) { return vabsq_s8(a); }
+static inline ldpc_vec_t v_xor(ldpc_vec_t a, ldpc_vec_t b) { return veorq_s8(a, b); }
+static inline ldpc_vec_t v_or(ldpc_vec_t a, ldpc_vec_t b) { return vorrq_s8(a, b); }
+static inline ldpc_vec_t v_sign(ldpc_vec_t a, ldpc_vec_t b) { return vbslq_s8(vcltzq_s8(b), vnegq_s8(a), a); }
+static inline ldpc_vec_t v_select_eq(ldpc_vec_t x, ldpc_vec_t y, ldpc_vec_t a, ldpc_vec_t b) {
+    return vbslq_s8(vceqq_s8(x, y), a, b);
+}
+static inline ldpc_vec_t v_scale(ldpc_vec_t m) { return vrhaddq_s8(m, vshrq_n_s8(m, 1)); }
+
+#else
+#define LDPC_LANES 1
+typedef int8_t ldpc_vec_t;
+static inline int8_t sat8(int x) { return (x > 127) ? 127 : (x < -128) ? -128 : x; }
+static inline ldpc_vec_t v_load(const int8_t* p) { return *p; }
+static inline void v_store(int8_t* p, ldpc_vec_t x) { *p = x; }
+static inline ldpc_vec_t v_set1(int8_t x) { return x; }
+static inline ldpc_vec_t v_adds(ldpc_vec_t a, ldpc_vec_t b) { return sat8(a + b); }
+static inline ldpc_vec_t v_subs(ldpc_vec_t a, ldpc_vec_t b) { return sat8(a - b); }
+static inline ldpc_vec_t v_min(ldpc_vec_t a, ldpc_vec_t b) { return (a < b) ? a : b; }
+static inline ldpc_vec_t v_max(ldpc_vec_t a, ldpc_vec_t b) { return (a > b) ? a : b; }
+static inline ldpc_vec_t v_abs(ldpc_vec_t a) { return (a < 0) ? -a : a; }
+static inline ldpc_vec_t v_xor(ldpc_vec_t a, ldpc_vec_t b) { return a ^ b; }
+static inline ldpc_vec_t v_or(ldpc_vec_t a, ldpc_vec_t b) { return a | b; }
+static inline ldpc_vec_t v_sign(ldpc_vec_t a, ldpc_vec_t b) { return (b < 0) ? -a : a; }
+static inline ldpc_vec_t v_select_eq(ldpc_vec_t x, ldpc_vec_t y, ldpc_vec_t a, ldpc_vec_t b) {
+    return (x == y) ? a : b;
+}
+static inline ldpc_vec_t v_scale(ldpc_vec_t m) { return (m + (m >> 1) + 1) >> 1; }
+#endif
+
+
+// =============================================================================
+// Constants
+// =============================================================================
+
+#define LDPC_DEFAULT_ITERATIONS 30
+#define LDPC_MAX_EDGES (LDPC_MAX_ROWS * LDPC_MAX_COLS)
+#define LDPC_LLR_MAX 127 // Messages stay in -127..127 so abs() cannot overflow
+#define SOFT_ERASURE 128  // Soft symbol carrying no information
+
+#define MAX_LDPC_FRAME (4 + LDPC_MAX_CODEWORD)
+#define MAX_SYMBOLS (8 * MAX_LDPC_FRAME)
+
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief Decoder state for one code.
+ * WHY: The base matrix is flattened into per-row edge lists once, so the
+ * inner loops walk contiguous arrays instead of scanning for -1 entries.
+ */
+typedef struct {
+    const ldpc_code_t* code;
+    int row_start[LDPC_MAX_ROWS + 1]; // Edges of block row r: row_start[r] .. row_start[r+1]-1
+    int edge_col[LDPC_MAX_EDGES];
+    int edge_shift[LDPC_MAX_EDGES];
+    int max_iterations;
+    int8_t* llr;  // nb * Z posterior LLRs (positive: bit 0)
+    int8_t* msg;  // One Z-vector of check-to-bit messages per edge
+    int8_t* work; // Rotated posteriors of the row being updated
+} ldpc_decoder_t;
+
+
+// =============================================================================
+// LDPC Decoder Module
+// =============================================================================
+
+/**
+ * @brief Cleans up the decoder resources.
+ */
+void ldpc_decoder_cleanup(ldpc_decoder_t* d) {
+    if (d) {
+        free(d->llr);
+        free(d->msg);
+        free(d->work);
+        free(d);
+    }
+}
+
+/**
+ * @brief Allocates a decoder for the given code.
+ * @return A pointer to the decoder, or NULL on failure.
+ */
+ldpc_decoder_t* ldpc_decoder_init(const ldpc_code_t* code, int max_iterations) {
+    ldpc_decoder_t* d = calloc(1, sizeof(ldpc_decoder_t));
+    if (!d) {
+        return NULL;
+    }
+    d->code = code;
+    d->max_iterations = max_iterations;
+    int n_edges = 0;
+    for (int r = 0; r < code->mb; r++) {
+        d->row_start[r] = n_edges;
+        for (int c = 0; c < code->nb; c++) {
+            if (code->shift[r][c] >= 0) {
+                d->edge_col[n_edges] = c;
+                d->edge_shift[n_edges] = code->shift[r][c];
+                n_edges++;
+            }
+        }
+    }
+    d->row_start[code->mb] = n_edges;
+
+    d->llr = malloc(code->nb * LDPC_Z);
+    d->msg = malloc(n_edges * LDPC_Z);
+    d->work = malloc(code->nb * LDPC_Z); // A row has at most nb edges
+    if (!d->llr || !d->msg || !d->work) {
+        ldpc_decoder_cleanup(d);
+        return NULL;
+    }
+    return d;
+}
+
+/**
+ * @brief Copies block x rotated by shift: out[z] = x[(z + shift) mod Z].
+ */
+static inline void rotate_in(const int8_t* x, int shift, int8_t* out) {
+    memcpy(out, x + shift, LDPC_Z - shift);
+    memcpy(out + LDPC_Z - shift, x, shift);
+}
+
+/**
+ * @brief Inverse of rotate_in: x[(z + shift) mod Z] = in[z].
+ */
+static inline void rotate_out(const int8_t* in, int shift, int8_t* x) {
+    memcpy(x + shift, in, LDPC_Z - shift);
+    memcpy(x, in + LDPC_Z - shift, shift);
+}
+
+/**
+ * @brief One layered normalized min-sum update of block row r.
+ *
+ * For each check: t = L - R_old for every connected bit; the new message to a
+ * bit is 0.75 * (smallest |t| of the others) with the sign product of the
+ * others; then L = t + R_new. The Z checks of the row run in SIMD lanes.
+ */
+void ldpc_update_row(ldpc_decoder_t* d, int r) {
+    int first = d->row_start[r];
+    int degree = d->row_start[r + 1] - first;
+    int8_t* t = d->work;
+    for (int e = 0; e < degree; e++) {
+        rotate_in(d->llr + d->edge_col[first + e] * LDPC_Z, d->edge_shift[first + e], t + e * LDPC_Z);
+    }
+
+    const ldpc_vec_t floor = v_set1(-LDPC_LLR_MAX);
+    const ldpc_vec_t one = v_set1(1);
+    for (int z = 0; z < LDPC_Z; z += LDPC_LANES) {
+        ldpc_vec_t min1 = v_set1(LDPC_LLR_MAX), min2 = min1, sign = v_set1(0);
+        for (int e = 0; e < degree; e++) {
+            int8_t* msg = d->msg + (first + e) * LDPC_Z + z;
+            ldpc_vec_t x = v_max(v_subs(v_load(t + e * LDPC_Z + z), v_load(msg)), floor);
+            v_store(t + e * LDPC_Z + z, x);
+            ldpc_vec_t a = v_abs(x);
+            min2 = v_min(min2, v_max(min1, a));
+            min1 = v_min(min1, a);
+            sign = v_xor(sign, x);
+        }
+        ldpc_vec_t m1 = v_scale(min1), m2 = v_scale(min2);
+        for (int e = 0; e < degree; e++) {
+            int8_t* msg = d->msg + (first + e) * LDPC_Z + z;
+            ldpc_vec_t x = v_load(t + e * LDPC_Z + z);
+            // WHY: When two inputs tie for the minimum, min2 == min1, so
+            // comparing magnitudes replaces tracking the minimum's index.
+            ldpc_vec_t mag = v_select_eq(v_abs(x), min1, m2, m1);
+            ldpc_vec_t rnew = v_sign(mag, v_or(v_xor(sign, x), one)); // OR 1: never a zero sign
+            v_store(msg, rnew);
+            v_store(t + e * LDPC_Z + z, v_max(v_adds(x, rnew), floor));
+        }
+    }
+
+    for (int e = 0; e < degree; e++) {
+        rotate_out(t + e * LDPC_Z, d->edge_shift[first + e], d->llr + d->edge_col[first + e] * LDPC_Z);
+    }
+}
+
+/**
+ * @brief Checks every parity equation against the hard decisions.
+ * @return 1 if the posteriors form a codeword.
+ */
+int ldpc_syndrome_ok(const ldpc_decoder_t* d) {
+    int8_t acc[LDPC_Z], rotated[LDPC_Z];
+    for (int r = 0; r < d->code->mb; r++) {
+        memset(acc, 0, sizeof(acc));
+        for (int e = d->row_start[r]; e < d->row_start[r + 1]; e++) {
+            rotate_in(d->llr + d->edge_col[e] * LDPC_Z, d->edge_shift[e], rotated);
+            for (int z = 0; z < LDPC_Z; z++) acc[z] ^= rotated[z];
+        }
+        // The sign bits hold the parity of each check.
+        for (int z = 0; z < LDPC_Z; z += 8) {
+            uint64_t word;
+            memcpy(&word, acc + z, 8);
+            if (word & 0x8080808080808080ULL) return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Decodes one codeword.
+ * @param channel nb * Z channel LLRs in codeword bit order (positive: bit 0).
+ * @param info Receives the LDPC_INFO_BYTES information bytes.
+ * @param iterations Receives the number of iterations run.
+ * @return 1 if the decoder converged to a codeword, 0 otherwise.
+ */
+int ldpc_decode(ldpc_decoder_t* d, const int8_t* channel, uint8_t* info, int* iterations) {
+    const ldpc_code_t* code = d->code;
+    memcpy(d->llr, channel, code->nb * LDPC_Z);
+    memset(d->msg, 0, d->row_start[code->mb] * LDPC_Z);
+
+    int it = 0;
+    int ok = ldpc_syndrome_ok(d);
+    while (!ok && it < d->max_iterations) {
+        for (int r = 0; r < code->mb; r++) {
+            ldpc_update_row(d, r);
+        }
+        it++;
+        ok = ldpc_syndrome_ok(d);
+    }
+
+    memset(info, 0, LDPC_INFO_BYTES);
+    for (int i = 0; i < 8 * LDPC_INFO_BYTES; i++) {
+        info[i >> 3] |= (d->llr[i] < 0) << (7 - (i & 7));
+    }
+    *iterations = it;
+    return ok;
+}
+
+/**
+ * @brief Maps a soft symbol (255 = confident 1) to a channel LLR.
+ * WHY: Channel LLRs are kept within +/-32 so the posteriors have room to
+ * grow before the +/-127 saturation limit; at +/-64 a layered update on
+ * hard-decision input loses most of its information to clipping.
+ */
+static inline int8_t soft_to_llr(uint8_t s) {
+    return (SOFT_ERASURE - (int)s) >> 2;
+}
+
+/**
+ * @brief Extracts the AX.25 frame from decoded information bytes.
+ * @return The AX.25 frame length if the length byte and FCS are valid, else 0.
+ */
+int ldpc_unpack_ax25(const uint8_t* info, const uint8_t** frame) {
+    int length = info[0];
+    if (length < AX25_OVERHEAD || length > LDPC_INFO_BYTES - 1) {
+        return 0;
+    }
+    *frame = info + 1;
+    uint16_t fcs = calculate_crc(info + 1, length - 2);
+    if ((fcs & 0xFF) != info[length - 1] || (fcs >> 8) != info[length]) {
+        return 0;
+    }
+    return length;
+}
+
+
+// =============================================================================
+// Benchmark Module
+// =============================================================================
+
+#define BENCH_MAX_FRAMES 5000    // Frames per Eb/N0 point at most...
+#define BENCH_MIN_ERRORS 100     // ...or until this many frame errors
+#define BENCH_SPEED_FRAMES 200
+#define SOFT_SCALE 32.0          // Soft units per unit of BPSK amplitude
+
+/**
+ * @brief xorshift64* generator; rand() is far too slow to feed the noise model.
+ */
+static uint64_t bench_rng = 0x9E3779B97F4A7C15ULL;
+
+double bench_uniform(void) {
+    bench_rng ^= bench_rng >> 12;
+    bench_rng ^= bench_rng << 25;
+    bench_rng ^= bench_rng >> 27;
+    return ((bench_rng * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double bench_gaussian(void) {
+    double u = bench_uniform();
+    return sqrt(-2.0 * log(u > 0.0 ? u : 1e-300)) * cos(2.0 * M_PI * bench_uniform());
+}
+
+/**
+ * @brief Sends a codeword over BPSK/AWGN and returns the receiver LLRs.
+ * @param rate Code rate, to convert Eb/N0 into the symbol SNR.
+ */
+void bench_channel(const uint8_t* codeword, int n_bits, double rate, double ebn0_db, int8_t* llr) {
+    double sigma = sqrt(1.0 / (2.0 * rate * pow(10.0, ebn0_db / 10.0)));
+    for (int i = 0; i < n_bits; i++) {
+        double x = ((codeword[i >> 3] >> (7 - (i & 7))) & 1) ? 1.0 : -1.0;
+        double soft = SOFT_ERASURE + SOFT_SCALE * (x + sigma * bench_gaussian());
+        llr[i] = soft_to_llr((soft < 0.0) ? 0 : (soft > 255.0) ? 255 : (uint8_t)lrint(soft));
+    }
+}
+
+/**
+ * @brief Frame error rate of hard-decision RS(255, 223) on the same channel.
+ * WHY: The FX.25 default is the baseline the LDPC codes have to beat.
+ */
+double rs_reference_fer(double ebn0_db) {
+    double rate = (double)FX25_K / FX25_N;
+    double p_bit = 0.5 * erfc(sqrt(rate * pow(10.0, ebn0_db / 10.0)));
+    double p_byte = 1.0 - pow(1.0 - p_bit, 8);
+    if (p_byte <= 0.0) return 0.0;
+    double ok = 0.0;
+    int t = (FX25_N - FX25_K) / 2;
+    for (int e = 0; e <= t; e++) {
+        double log_term = lgamma(FX25_N + 1.0) - lgamma(e + 1.0) - lgamma(FX25_N - e + 1.0)
+                        + e * log(p_byte) + (FX25_N - e) * log1p(-p_byte);
+        ok += exp(log_term);
+    }
+    return (ok < 1.0) ? 1.0 - ok : 0.0;
+}
+
+/**
+ * @brief FER/BER versus Eb/N0 for both rates, then decoder throughput.
+ * @return 0 on success, 1 on error.
+ */
+int run_ldpc_benchmark(void) {
+    static const int rows[2] = { LDPC_MAX_ROWS, 4 };
+    static const char* names[2] = { "1/2", "2/3" };
+    uint8_t info[LDPC_INFO_BYTES], decoded[LDPC_INFO_BYTES];
+    uint8_t codeword[LDPC_MAX_CODEWORD];
+    int8_t* llr = malloc((size_t)BENCH_SPEED_FRAMES * LDPC_MAX_COLS * LDPC_Z);
+    if (!llr) {
+        return 1;
+    }
+
+#ifdef LDPC_SIMD
+    printf("\n  Decoder: layered normalized min-sum, int8 %s, at most %d iterations\n",
+           LDPC_SIMD, LDPC_DEFAULT_ITERATIONS);
+#else
+    printf("\n  Decoder: layered normalized min-sum, int8 scalar, at most %d iterations\n",
+           LDPC_DEFAULT_ITERATIONS);
+#endif
+    for (int k = 0; k < 2; k++) {
+        ldpc_code_t code;
+        ldpc_build(&code, rows[k]);
+        ldpc_decoder_t* d = ldpc_decoder_init(&code, LDPC_DEFAULT_ITERATIONS);
+        if (!d) {
+            free(llr);
+            return 1;
+        }
+        int n_bits = code.nb * LDPC_Z;
+        double rate = (double)LDPC_INFO_BLOCKS / code.nb;
+
+        printf("\n  LDPC rate %s (%d, %d)\n", names[k], n_bits, LDPC_INFO_BLOCKS * LDPC_Z);
+        printf("  %8s %8s %10s %10s %8s\n", "Eb/N0", "Frames", "FER", "BER", "AvgIt");
+        for (double ebn0 = 0.5; ebn0 <= 4.01; ebn0 += 0.25) {
+            long frames = 0, frame_errors = 0, bit_errors = 0, total_iterations = 0;
+            while (frames < BENCH_MAX_FRAMES && frame_errors < BENCH_MIN_ERRORS) {
+                for (int i = 0; i < LDPC_INFO_BYTES; i++) info[i] = bench_uniform() * 256.0;
+                ldpc_encode(&code, info, codeword);
+                bench_channel(codeword, n_bits, rate, ebn0, llr);
+                int iterations;
+                ldpc_decode(d, llr, decoded, &iterations);
+                int errors = 0;
+                for (int i = 0; i < LDPC_INFO_BYTES; i++) {
+                    errors += __builtin_popcount(info[i] ^ decoded[i]);
+                }
+                bit_errors += errors;
+                frame_errors += errors > 0;
+                total_iterations += iterations;
+                frames++;
+            }
+            printf("  %6.2fdB %8ld %10.2e %10.2e %8.1f\n", ebn0, frames,
+                   (double)frame_errors / frames, (double)bit_errors / (frames * 8.0 * LDPC_INFO_BYTES),
+                   (double)total_iterations / frames);
+            if (frame_errors == 0) break; // Below what this many frames can resolve
+        }
+
+        // --- Throughput: an operating point near the waterfall, and the worst case ---
+        double points[2] = { rows[k] == LDPC_MAX_ROWS ? 2.0 : 3.0, 0.0 };
+        for (int p = 0; p < 2; p++) {
+            for (int f = 0; f < BENCH_SPEED_FRAMES; f++) {
+                for (int i = 0; i < LDPC_INFO_BYTES; i++) info[i] = bench_uniform() * 256.0;
+                ldpc_encode(&code, info, codeword);
+                bench_channel(codeword, n_bits, rate, points[p], llr + (size_t)f * n_bits);
+            }
+            long total_iterations = 0;
+            double t0 = now_seconds();
+            for (int f = 0; f < BENCH_SPEED_FRAMES; f++) {
+                int iterations;
+                ldpc_decode(d, llr + (size_t)f * n_bits, decoded, &iterations);
+                total_iterations += iterations;
+            }
+            double dt = now_seconds() - t0;
+            printf("  Throughput at %.1f dB: %.1f Mbit/s (info), %.1f iterations/frame, %.0f us/iteration\n",
+                   points[p], BENCH_SPEED_FRAMES * 8.0 * LDPC_INFO_BYTES / dt / 1e6,
+                   (double)total_iterations / BENCH_SPEED_FRAMES,
+                   total_iterations ? dt / total_iterations * 1e6 : 0.0);
+        }
+        ldpc_decoder_cleanup(d);
+    }
+    double rs_ebn0 = 0.0;
+    while (rs_reference_fer(rs_ebn0) > 1e-2) rs_ebn0 += 0.05;
+    printf("\n  Reference: hard-decision RS(255,223) (FX.25 default) needs %.1f dB for FER 1e-2\n", rs_ebn0);
+    printf("  (BPSK/AWGN, 8-bit soft symbols)\n");
+    free(llr);
+    return 0;
+}
+
+
+// =============================================================================
+// Main Application
+// =============================================================================
+
+void print_ldpc_usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [-S] [-i max_iterations] <input_kiss_file> <output_kiss_file>\n"
+                    "       %s -b\n", prog, prog);
+}
+
+int main(int argc, char* argv[]) {
+    // --- 1. Argument Parsing ---
+    int soft_input = 0;
+    int max_iterations = LDPC_DEFAULT_ITERATIONS;
+    int opt;
+    while ((opt = getopt(argc, argv, "Si:b")) != -1) {
+        switch (opt) {
+        case 'S': soft_input = 1; break;
+        case 'i': max_iterations = atoi(optarg); break;
+        case 'b': return run_ldpc_benchmark();
+        default:
+            print_ldpc_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (argc - optind < 2 || max_iterations < 1) {
+        print_ldpc_usage(argv[0]);
+        return 1;
+    }
+    const char* input_filename = argv[optind];
+    const char* output_filename = argv[optind + 1];
+
+    // --- 2. Initialization ---
+    // WHY: The frame length identifies the code rate, so mixed streams decode.
+    ldpc_code_t codes[2];
+    ldpc_decoder_t* decoders[2] = { NULL, NULL };
+    int ok = ldpc_build(&codes[0], LDPC_MAX_ROWS) && ldpc_build(&codes[1], 4);
+    for (int k = 0; k < 2 && ok; k++) {
+        decoders[k] = ldpc_decoder_init(&codes[k], max_iterations);
+        ok = decoders[k] != NULL;
+    }
+    FILE* input_file = ok ? fopen(input_filename, "rb") : NULL;
+    FILE* output_file = input_file ? fopen(output_filename, "wb") : NULL;
+    if (!output_file) {
+        if (!ok) {
+            fprintf(stderr, "Error: Failed to initialize LDPC decoder.\n");
+        } else {
+            perror(input_file ? "Error creating output file" : "Error opening input file");
+        }
+        if (input_file) fclose(input_file);
+        ldpc_decoder_cleanup(decoders[0]);
+        ldpc_decoder_cleanup(decoders[1]);
+        return 1;
+    }
+
+    // --- 3. Decode Loop ---
+    static uint8_t frame[MAX_SYMBOLS];
+    int8_t llr[LDPC_MAX_COLS * LDPC_Z];
+    uint8_t info[LDPC_INFO_BYTES];
+    int frame_count = 0, decoded_count = 0, failed = 0, fcs_errors = 0, skipped = 0;
+    long total_iterations = 0;
+    int length;
+    while ((length = read_kiss_frame(input_file, frame, soft_input ? MAX_SYMBOLS : MAX_LDPC_FRAME)) >= 0) {
+        int n_bits = soft_input ? length : 8 * length;
+        int k = (n_bits == 8 * LDPC_FRAME_LEN(&codes[0])) ? 0 : (n_bits == 8 * LDPC_FRAME_LEN(&codes[1])) ? 1 : -1;
+        frame_count++;
+        if (k < 0) {
+            fprintf(stderr, "Warning: Skipping frame %d: %d bytes is not an LDPC frame\n", frame_count, length);
+            skipped++;
+            continue;
+        }
+        // Skip the ASM; the KISS framing already delimits the codeword.
+        for (int i = 32; i < n_bits; i++) {
+            uint8_t s = soft_input ? frame[i] : (((frame[i >> 3] >> (7 - (i & 7))) & 1) ? 255 : 0);
+            llr[i - 32] = soft_to_llr(s);
+        }
+        int iterations;
+        int converged = ldpc_decode(decoders[k], llr, info, &iterations);
+        total_iterations += iterations;
+        const uint8_t* ax25 = NULL;
+        int ax25_len = ldpc_unpack_ax25(info, &ax25);
+        if (!converged) {
+            failed++;
+        } else if (ax25_len == 0) {
+            fcs_errors++;
+        } else {
+            write_kiss_frame(output_file, ax25, ax25_len);
+            decoded_count++;
+        }
+    }
+
+    // --- 4. Cleanup ---
+    fclose(input_file);
+    fclose(output_file);
+    ldpc_decoder_cleanup(decoders[0]);
+    ldpc_decoder_cleanup(decoders[1]);
+
+    printf("Decoded %d of %d frame(s): %d did not converge, %d failed the FCS, %d skipped\n",
+           decoded_count, frame_count, failed, fcs_errors, skipped);
+    printf("Average iterations: %.1f\n",
+           (frame_count - skipped) ? (double)total_iterations / (frame_count - skipped) : 0.0);
+    printf("Output written to %s\n", output_filename);
+    return 0;
+}
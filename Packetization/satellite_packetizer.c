@@ -25,8 +25,37 @@
  * gcc -Wall satellite_packetizer.c -o packetizer -lfec
  *
  * Run with:
- * ./packetizer <source_call> <dest_call> <input_file> <output_kiss_file>
+ * ./packetizer [options] <source_call> <dest_call> <input_file> <output_kiss_file>
  * Example: ./packetizer N0CALL-1 CQ big_data.bin radio_output.kiss
+ *
+ * Options:
+ * -s <schedule.csv>  Pass schedule exported by adcs_skissue.py --schedule.
+ *                    Frames are packed into each pass's airtime budget and
+ *                    written to <output_kiss_file>.NNN (one file per pass).
+ * -B <beacon_file>   Beacon frame sent at the start of every pass (schedule mode).
+ * -H <hk_file>       Housekeeping data, sent before the payload (schedule mode).
+ * -e <profile.csv>   Elevation/link-margin profile (adcs_skissue.py --profile),
+ *                    or "-" for a live feed on stdin. The RS check-byte count
+ *                    of every frame is then chosen from the margin (16/32/64).
+ * -C <depth>         CCSDS TM framing instead of AX.25/FX.25: fixed-length
+ *                    transfer frames, RS(255, 223) interleaved to depth 1-5,
+ *                    pseudo-randomized, each behind the 0x1ACFFC1D ASM.
+ * -L <1/2|2/3>       LDPC frames instead of FX.25 RS: quasi-cyclic code with
+ *                    2048 information bits at rate 1/2 or 2/3, decoded on the
+ *                    ground with ldpc_decoder.c.
+ * -V                 Convolutional inner code (CCSDS k=7, r=1/2) over every
+ *                    FEC-encoded frame, for soft-decision Viterbi decoding on
+ *                    the ground (see viterbi_decoder.c).
+ * -A <air_bps>       Low-latency voice mode: the input is a continuous stream
+ *                    (encoded audio; "-" reads it live from stdin) cut into
+ *                    short RS(48, 32) FX.25 frames for a link of air_bps.
+ *                    Frames that would miss the deadline are dropped, at most
+ *                    one frame waits for the transmitter, and the end-to-end
+ *                    latency is reported.
+ * -D <deadline_ms>   Voice mode: latency budget per frame (default 60 ms).
+ * -R <source_bps>    Voice mode: bit rate a file input is replayed at
+ *                    (default 8750, the ADPCM 4 kHz mode of the audio link).
+ * -b                 Benchmark the FX.25 and CCSDS encoders and exit.
  */
 
 // =============================================================================
@@ -36,6 +65,9 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <unistd.h> // getopt(), read()
+#include <poll.h>   // Live elevation feed
+#include <time.h>   // clock_gettime() for the benchmark
 #include "fec.h" // Requires libfec to be installed (e.g., sudo apt install libfec-dev)
 
 // =============================================================================
@@ -47,9 +79,29 @@
 #define PID_NOL3     0xF0   // No Layer 3 protocol
 
 // --- FX.25 Protocol Constants ---
-#define FX25_K 223 // Data bytes in a Reed-Solomon block
+#define FX25_K 223 // Data bytes in a Reed-Solomon block (default code)
 #define FX25_N 255 // Total bytes (data + parity) in a Reed-Solomon block
-static const uint8_t CORR_TAG[8] = { 0xCC, 0x8F, 0x8A, 0xE4, 0x85, 0xE2, 0x98, 0x01 };
+#define FX25_NUM_CODES 4
+#define FX25_CODE_DEFAULT 1 // RS(255, 223)
+#define FX25_CODE_VOICE 3   // RS(48, 32), the shortest FX.25 frame
+
+/**
+ * @brief An FX.25 Reed-Solomon code and the correlation tag that announces it.
+ * WHY: The receiver learns the check-byte count from the tag alone, so the
+ * code can change from one frame to the next without any other signalling.
+ */
+typedef struct {
+    int nroots;     // Check bytes per codeword
+    int n;          // Codeword length; below FX25_N the code is shortened
+    uint8_t tag[8]; // Correlation tag, transmitted first
+} fx25_code_t;
+
+static const fx25_code_t FX25_CODES[FX25_NUM_CODES] = {
+    { 16, 255, { 0x3E, 0x2F, 0x53, 0x8A, 0xDF, 0xB7, 0x4D, 0xB7 } }, // RS(255, 239), FX.25 Tag_01
+    { 32, 255, { 0xCC, 0x8F, 0x8A, 0xE4, 0x85, 0xE2, 0x98, 0x01 } }, // RS(255, 223)
+    { 64, 255, { 0x36, 0x28, 0xAE, 0xDE, 0x13, 0x0C, 0xDB, 0x3A } }, // RS(255, 191), FX.25 Tag_09
+    { 16,  48, { 0xEE, 0x60, 0x96, 0x36, 0xB4, 0x6E, 0x05, 0x8F } }, // RS(48, 32), FX.25 Tag_04
+};
 
 // --- KISS Protocol Constants ---
 #define KISS_FEND 0xC0 // Frame End
@@ -58,10 +110,54 @@ static const uint8_t CORR_TAG[8] = { 0xCC, 0x8F, 0x8A, 0xE4, 0x85, 0xE2, 0x98, 0
 #define KISS_TFESC 0xDD // Transposed FESC
 #define KISS_CMD_DATA 0x00 // Command for Data Frame on port 0
 
+// --- AX.25 Frame Overhead ---
+#define AX25_OVERHEAD 18 // 14 addr + 2 ctrl/pid + 2 FCS
+
+// --- CCSDS TM Protocol Constants (CCSDS 131.0-B / 132.0-B / 133.0-B) ---
+static const uint8_t CCSDS_ASM[4] = { 0x1A, 0xCF, 0xFC, 0x1D }; // Attached Sync Marker
+#define CCSDS_RS_K 223       // Data bytes per RS(255, 223) codeword
+#define CCSDS_RS_N 255       // Codeword length
+#define CCSDS_MAX_DEPTH 5    // Largest RS interleave depth allowed by the standard
+#define CCSDS_TF_HEADER 6    // Transfer frame primary header
+#define CCSDS_SP_HEADER 6    // Space packet primary header
+#define CCSDS_SCID 0x000     // Spacecraft ID, assigned by SANA at registration
+#define CCSDS_APID 0x001     // APID of the downlinked file data
+#define CCSDS_IDLE_APID 0x7FF
+#define CCSDS_FHP_NONE 0x7FF // First header pointer: no packet starts in this frame
+
+// Convolutional inner code (CCSDS 131.0-B, k=7 r=1/2)
+// WHY: The masks are the generators 171/133 (octal) with the newest bit in bit 0;
+// both have their first and last taps set, which the Viterbi butterflies rely on.
+#define CONV_POLY_G1 0x4F
+#define CONV_POLY_G2 0x6D   // Output inverted, as in the CCSDS encoder
+#define CONV_TAIL_BITS 6    // Zero bits flushed after each frame to end in state 0
+#define CONV_ENCODED_LEN(len) (2 * (len) + 2) // 2 * (8 * len + 6) bits, padded to bytes
+
+// Quasi-cyclic LDPC frame format
+#define LDPC_Z 256            // Circulant size (bits per block)
+#define LDPC_INFO_BLOCKS 8    // 2048 information bits: a length byte + one AX.25 frame
+#define LDPC_MAX_ROWS 8       // Rate 1/2; rate 2/3 uses 4 block rows
+#define LDPC_MAX_COLS (LDPC_INFO_BLOCKS + LDPC_MAX_ROWS)
+#define LDPC_COL_WEIGHT 3     // Ones per information column of the base matrix
+#define LDPC_INFO_BYTES (LDPC_INFO_BLOCKS * LDPC_Z / 8)
+#define LDPC_MAX_CODEWORD (LDPC_MAX_COLS * LDPC_Z / 8)
+#define LDPC_FRAME_LEN(code) (4 + (code)->nb * LDPC_Z / 8) // ASM + codeword
+
 // --- Application Constants ---
 #define MAX_PAYLOAD 150 // WHY: Keep payload small enough so the final AX.25 frame is < FX25_K (223 bytes).
                         // (14 addr + 2 ctrl/pid + payload + 2 FCS) must be < 223. 150 is a safe value.
 
+// --- Pass Scheduler Constants ---
+#define MAX_PASSES 512      // Upper bound on rows read from a schedule file (a week is ~30-90 passes).
+#define LORA_MAX_PACKET 255 // SX127x FIFO limit; longer frames are split over several LoRa packets.
+
+// --- Adaptive FEC Constants ---
+// WHY: The Eb/N0 margin from link_budget() swings by >10 dB over a pass. With
+// margin to spare the 16 check bytes are enough and the freed space carries
+// payload; near link closure the 64-byte code corrects twice as many errors.
+#define FEC_LIGHT_MARGIN_DB  2.0 // Margin at or above which RS(255, 239) is used
+#define FEC_STRONG_MARGIN_DB 0.0 // Margin below which RS(255, 191) is used
+
 // =============================================================================
 // Data Structures
 // =============================================================================
@@ -74,15 +170,99 @@ typedef struct {
     uint8_t ssid;
 } ax25_address_t;
 
+/**
+ * @brief Base matrix of a quasi-cyclic LDPC code.
+ * Block (r, c) of the parity-check matrix is the Z x Z identity cyclically
+ * shifted by shift[r][c], or all zero when the shift is -1: check z of block
+ * row r sees bit (z + shift) mod Z of block column c.
+ */
+typedef struct {
+    int mb, nb;  // Block rows and columns; the first nb - mb columns are information
+    int16_t shift[LDPC_MAX_ROWS][LDPC_MAX_COLS];
+} ldpc_code_t;
+
 /**
  * @brief Holds the handle for the Reed-Solomon encoder.
  * WHY: Encapsulating the handle in a struct makes the code cleaner and easier
  * to pass around, avoiding global variables.
  */
 typedef struct {
-    void* rs_handle;
+    void* rs_handle[FX25_NUM_CODES];
+    int convolutional; // Apply the k=7 r=1/2 inner code after the RS stage
+    const ldpc_code_t* ldpc; // LDPC frame format instead of FX.25 (NULL: FX.25)
 } fx25_encoder_t;
 
+/**
+ * @brief One "t_s,el_deg,margin_db" sample of an elevation profile.
+ */
+typedef struct {
+    double t_s, el_deg, margin_db;
+} feed_sample_t;
+
+/**
+ * @brief Source of link-margin samples used to pick the FEC strength.
+ * Reads either an offline profile file, replayed against the transmit clock,
+ * or a live feed, where the newest sample available is always used.
+ */
+typedef struct {
+    feed_sample_t* samples; // Offline profile, loaded whole (NULL for a live feed)
+    int n_samples;
+    int cursor;             // Offline sample in effect
+    double dt_s;            // Offline sample spacing; each sample holds for dt_s
+    int live_fd;            // Live feed descriptor (-1 for an offline profile)
+    char line[256];         // Partial line carried between live reads
+    int line_len;
+    int have_sample;
+    double t_s, el_deg, margin_db; // Newest live sample
+} elevation_feed_t;
+
+/**
+ * @brief State of the CCSDS TM framing mode for one virtual channel.
+ * WHY: Space packets are laid end to end across fixed-length transfer frames,
+ * so the frame being filled, its first header pointer and the frame counters
+ * have to persist between calls.
+ */
+typedef struct {
+    int depth;      // RS interleave depth I
+    int frame_len;  // Transfer frame length, I * 223 bytes
+    uint8_t frame[CCSDS_MAX_DEPTH * CCSDS_RS_K];
+    int fill;       // Bytes written to the frame so far (header included)
+    int fhp;        // First header pointer of the frame being filled
+    uint8_t mc_count, vc_count;
+    uint16_t packet_count;
+    long frames_written;
+    int convolutional; // Apply the k=7 r=1/2 inner code to every CADU
+    // WHY: The 255-byte randomizer period is unrolled over the longest
+    // codeblock (+8 spare bytes) so it can be applied a 64-bit word at a time.
+    uint8_t pn[CCSDS_MAX_DEPTH * CCSDS_RS_N + 8];
+} ccsds_tm_t;
+
+/**
+ * @brief Downlink priority classes, highest priority first.
+ * WHY: The beacon proves the satellite is alive and must go out every pass;
+ * housekeeping is small and mission critical; payload fills what is left.
+ */
+typedef enum {
+    PRIO_BEACON = 0,
+    PRIO_HOUSEKEEPING,
+    PRIO_PAYLOAD,
+    PRIO_COUNT
+} frame_priority_t;
+
+/**
+ * @brief One row of the pass schedule produced by adcs_skissue.py.
+ */
+typedef struct {
+    int index;          // Pass number (1-indexed)
+    double start_s;     // AOS, seconds from epoch
+    double end_s;       // LOS, seconds from epoch
+    double max_el_deg;  // Peak elevation
+    double budget_s;    // Downlink airtime available in this pass
+    int sf;             // LoRa spreading factor used to cost each frame
+    double bw_khz;      // LoRa bandwidth
+    int cr;             // LoRa coding rate index (1=4/5 ... 4=4/8)
+} pass_window_t;
+
 
 // =============================================================================
 // Low-Level Utility Functions
@@ -119,68 +299,135 @@ uint16_t calculate_crc(const uint8_t* data, int length) {
     return crc ^ 0xFFFF;
 }
 
+/**
+ * @brief LoRa Time-on-Air of a single packet, in seconds.
+ * Same SX127x formula as lora_toa() in adcs_skissue.py (explicit header,
+ * 8 preamble symbols, CRC on, and LDRO by the Arduino LoRa library's
+ * integer rule: on when 1000 / (bw_hz / 2^sf) ms is above 16, so off for
+ * SF11/125 kHz and SF12/250 kHz).
+ */
+double lora_packet_toa(int n_bytes, int sf, double bw_khz, int cr) {
+    double t_sym = (double)(1 << sf) / (bw_khz * 1e3);
+    long bw_hz = (long)(bw_khz * 1e3);
+    int de = (1000 / (bw_hz >> sf) > 16) ? 2 : 0;
+    int num = 8 * n_bytes - 4 * sf + 28 + 16;
+    int den = 4 * (sf - de);
+    // WHY: Integer ceil() keeps libm out of the build for the embedded target.
+    int n_blocks = (num > 0) ? (num + den - 1) / den : 0;
+    int n_sym_payload = 8 + n_blocks * (cr + 4);
+    return (8 + 4.25) * t_sym + n_sym_payload * t_sym;
+}
+
+/**
+ * @brief Airtime of a complete frame, split into as many LoRa packets as needed.
+ */
+double frame_airtime(int frame_len, const pass_window_t* pass) {
+    double t = 0.0;
+    while (frame_len > 0) {
+        int chunk = (frame_len > LORA_MAX_PACKET) ? LORA_MAX_PACKET : frame_len;
+        t += lora_packet_toa(chunk, pass->sf, pass->bw_khz, pass->cr);
+        frame_len -= chunk;
+    }
+    return t;
+}
+
 
 // =============================================================================
 // FX.25 Module (FEC Encoding)
 // =============================================================================
 
 /**
- * @brief Initializes the Reed-Solomon encoder.
+ * @brief Frees all resources used by the encoder.
+ */
+void fx25_cleanup(fx25_encoder_t* encoder) {
+    if (encoder) {
+        for (int i = 0; i < FX25_NUM_CODES; i++) {
+            if (encoder->rs_handle[i]) {
+                free_rs_char(encoder->rs_handle[i]);
+            }
+        }
+        free(encoder);
+    }
+}
+
+/**
+ * @brief Initializes the Reed-Solomon encoders for every FX.25 code.
  * @return Pointer to an allocated fx25_encoder_t, or NULL on failure.
  */
 fx25_encoder_t* fx25_init() {
-    fx25_encoder_t* encoder = malloc(sizeof(fx25_encoder_t));
+    fx25_encoder_t* encoder = calloc(1, sizeof(fx25_encoder_t));
     if (!encoder) return NULL; // WHY: Always check malloc results on embedded systems.
 
-    // Initialize RS(255, 223), the standard for FX.25
-    encoder->rs_handle = init_rs_char(8, 0x187, 112, 11, 32, 0);
-    if (!encoder->rs_handle) {
-        free(encoder);
-        return NULL;
+    // Initialize RS(255, 255 - nroots) for every code. The generator roots are
+    // kept symmetric about alpha^128 (fcr = 128 - nroots/2), which gives the
+    // usual RS(255, 223) parameters (fcr = 112) for 32 check bytes. Shortened
+    // codes are the same code with the leading 255 - n data bytes fixed at zero.
+    for (int i = 0; i < FX25_NUM_CODES; i++) {
+        int nroots = FX25_CODES[i].nroots;
+        int pad = FX25_N - FX25_CODES[i].n;
+        encoder->rs_handle[i] = init_rs_char(8, 0x187, 128 - nroots / 2, 11, nroots, pad);
+        if (!encoder->rs_handle[i]) {
+            fx25_cleanup(encoder);
+            return NULL;
+        }
     }
     return encoder;
 }
 
 /**
- * @brief Frees all resources used by the encoder.
+ * @brief Largest payload whose AX.25 frame fits the data part of an FX.25 code.
  */
-void fx25_cleanup(fx25_encoder_t* encoder) {
-    if (encoder) {
-        if (encoder->rs_handle) {
-            free_rs_char(encoder->rs_handle);
-        }
-        free(encoder);
-    }
+int fx25_payload_capacity(int code) {
+    return FX25_CODES[code].n - FX25_CODES[code].nroots - AX25_OVERHEAD;
+}
+
+/**
+ * @brief Bytes sent on air per frame of one FX.25 code (tag + codeword, inner code included).
+ */
+int fx25_code_onair_len(const fx25_encoder_t* encoder, int code) {
+    int len = 8 + FX25_CODES[code].n;
+    return encoder->convolutional ? CONV_ENCODED_LEN(len) : len;
+}
+
+/**
+ * @brief Bytes sent on air per full-length FX.25 frame, or per LDPC frame.
+ */
+int fx25_onair_len(const fx25_encoder_t* encoder) {
+    if (encoder->ldpc) return LDPC_FRAME_LEN(encoder->ldpc);
+    return fx25_code_onair_len(encoder, FX25_CODE_DEFAULT);
 }
 
 /**
  * @brief Encodes a complete AX.25 frame with FX.25 FEC.
+ * @param code Index into FX25_CODES selecting the number of RS check bytes.
  * @param ax25_frame The raw AX.25 frame (address, control, pid, payload, fcs).
  * @param ax25_len Length of the raw AX.25 frame.
  * @param fx25_frame_out Buffer to store the resulting FX.25 frame.
- * @return The total length of the FX.25 frame (8-byte tag + 255-byte codeword), or 0 on error.
+ * @return The total length of the FX.25 frame (8-byte tag + n-byte codeword), or 0 on error.
  */
-int fx25_encode_frame(fx25_encoder_t* encoder, const uint8_t* ax25_frame, int ax25_len, uint8_t* fx25_frame_out) {
-    if (ax25_len > FX25_K) {
-        fprintf(stderr, "Error: AX.25 frame too large for FX.25 (%d > %d)\n", ax25_len, FX25_K);
+int fx25_encode_frame(fx25_encoder_t* encoder, int code, const uint8_t* ax25_frame, int ax25_len, uint8_t* fx25_frame_out) {
+    int n = FX25_CODES[code].n;
+    int k = n - FX25_CODES[code].nroots;
+    if (ax25_len > k) {
+        fprintf(stderr, "Error: AX.25 frame too large for FX.25 (%d > %d)\n", ax25_len, k);
         return 0;
     }
 
     // 1. Prepend the 8-byte Correlation Tag for modem synchronization.
-    memcpy(fx25_frame_out, CORR_TAG, 8);
+    memcpy(fx25_frame_out, FX25_CODES[code].tag, 8);
 
     // 2. Prepare the Reed-Solomon block.
     uint8_t rs_block[FX25_N];
-    memset(rs_block, 0, FX25_N); // WHY: Zero-pad the data portion. libfec requires the full block.
+    memset(rs_block, 0, n); // WHY: Zero-pad the data portion. libfec requires the full block.
     memcpy(rs_block, ax25_frame, ax25_len);
 
-    // 3. Calculate and add the 32 parity bytes to the end of the block.
-    encode_rs_char(encoder->rs_handle, rs_block, rs_block + FX25_K);
+    // 3. Calculate and add the parity bytes to the end of the block.
+    encode_rs_char(encoder->rs_handle[code], rs_block, rs_block + k);
 
-    // 4. Copy the full 255-byte codeword to the output frame.
-    memcpy(fx25_frame_out + 8, rs_block, FX25_N);
+    // 4. Copy the full codeword to the output frame.
+    memcpy(fx25_frame_out + 8, rs_block, n);
 
-    return 8 + FX25_N;
+    return 8 + n;
 }
 
 
@@ -248,17 +495,1263 @@ void write_kiss_frame(FILE* stream, const uint8_t* frame, int length) {
     fputc(KISS_FEND, stream);
 }
 
+/**
+ * @brief Reads the next data frame from a KISS stream, undoing the escaping.
+ * Non-data frames (other KISS commands) and frames longer than max_len are
+ * skipped.
+ * @return The frame length, or -1 at the end of the stream.
+ */
+int read_kiss_frame(FILE* stream, uint8_t* frame, int max_len) {
+    int c;
+    do { c = fgetc(stream); } while (c == KISS_FEND); // Back-to-back FENDs are allowed
+    while (c != EOF) {
+        int command = c;
+        int length = 0, escaped = 0, overflow = 0;
+        while ((c = fgetc(stream)) != EOF && c != KISS_FEND) {
+            if (c == KISS_FESC) {
+                escaped = 1;
+                continue;
+            }
+            if (escaped) {
+                c = (c == KISS_TFEND) ? KISS_FEND : (c == KISS_TFESC) ? KISS_FESC : c;
+                escaped = 0;
+            }
+            if (length < max_len) {
+                frame[length++] = c;
+            } else {
+                overflow = 1;
+            }
+        }
+        if (c == EOF) {
+            return -1; // Truncated final frame
+        }
+        if ((command & 0x0F) == KISS_CMD_DATA && !overflow) {
+            return length;
+        }
+        do { c = fgetc(stream); } while (c == KISS_FEND);
+    }
+    return -1;
+}
+
+
+// =============================================================================
+// Convolutional Inner Code Module
+// =============================================================================
+
+/**
+ * @brief Encodes a frame with the CCSDS k=7 r=1/2 convolutional code.
+ *
+ * Bits are taken MSB first; each input bit produces a G1 and an (inverted) G2
+ * symbol, packed MSB first. The encoder starts in state 0 and is flushed with
+ * CONV_TAIL_BITS zero bits, so every frame can be decoded on its own.
+ *
+ * WHY: Concatenating the convolutional code inside the RS code gains several
+ * dB with soft-decision decoding, which buys a faster LoRa/FSK rate. The RS
+ * stage then cleans up the short error bursts the Viterbi decoder leaves.
+ *
+ * @param out Buffer of at least CONV_ENCODED_LEN(length) bytes.
+ * @return The encoded length in bytes.
+ */
+int conv_encode(const uint8_t* in, int length, uint8_t* out) {
+    int out_len = CONV_ENCODED_LEN(length);
+    int n_bits = 8 * length + CONV_TAIL_BITS;
+    uint32_t sr = 0; // Last 7 input bits, newest in bit 0
+    memset(out, 0, out_len);
+    for (int i = 0, pos = 0; i < n_bits; i++, pos += 2) {
+        int bit = (i < 8 * length) ? (in[i >> 3] >> (7 - (i & 7))) & 1 : 0;
+        sr = ((sr << 1) | bit) & 0x7F;
+        int g1 = __builtin_parity(sr & CONV_POLY_G1);
+        int g2 = !__builtin_parity(sr & CONV_POLY_G2);
+        // WHY: pos is even, so both symbols always land in the same byte.
+        out[pos >> 3] |= ((g1 << 1) | g2) << (6 - (pos & 7));
+    }
+    return out_len;
+}
+
+/**
+ * @brief Writes an FEC-encoded frame in KISS format, through the inner code if enabled.
+ * @param length Frame length, at most one CCSDS CADU (4 + 5 * 255 bytes).
+ */
+void write_coded_frame(FILE* stream, int convolutional, const uint8_t* frame, int length) {
+    if (!convolutional) {
+        write_kiss_frame(stream, frame, length);
+        return;
+    }
+    uint8_t coded[CONV_ENCODED_LEN(4 + CCSDS_MAX_DEPTH * CCSDS_RS_N)];
+    write_kiss_frame(stream, coded, conv_encode(frame, length, coded));
+}
+
+
+// =============================================================================
+// LDPC Module (Alternative Frame Format)
+// =============================================================================
+
+/**
+ * @brief Checks that block column c closes no 4-cycle with any other column.
+ * WHY: Two checks sharing two bits make min-sum decoding feed a message back
+ * to its source after one iteration; excluding them gives girth >= 6.
+ */
+int ldpc_column_is_4cycle_free(const ldpc_code_t* code, int c) {
+    for (int other = 0; other < code->nb; other++) {
+        if (other == c) continue;
+        for (int r1 = 0; r1 < code->mb; r1++) {
+            for (int r2 = r1 + 1; r2 < code->mb; r2++) {
+                const int16_t* a = code->shift[r1];
+                const int16_t* b = code->shift[r2];
+                if (a[c] < 0 || b[c] < 0 || a[other] < 0 || b[other] < 0) continue;
+                if ((a[c] - b[c] - a[other] + b[other] + 2 * LDPC_Z) % LDPC_Z == 0) {
+                    return 0;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Builds the base matrix of the rate 1/2 (8 block rows) or rate 2/3
+ * (4 block rows) code.
+ *
+ * The parity part is dual-diagonal, as in IEEE 802.11n: a weight-3 column with
+ * shifts 1/0/1 followed by an identity staircase, so the encoder runs directly
+ * on the sparse parity-check matrix in linear time. The information columns
+ * have weight 3 on the least used rows, with circulant shifts drawn from a
+ * fixed-seed generator until no 4-cycle remains. The construction is
+ * deterministic, so the packetizer and the ground decoder agree on the code.
+ *
+ * @return 1 on success, 0 for an unsupported number of rows.
+ */
+int ldpc_build(ldpc_code_t* code, int mb) {
+    if (mb != 4 && mb != LDPC_MAX_ROWS) {
+        fprintf(stderr, "Error: LDPC codes have 4 (rate 2/3) or 8 (rate 1/2) block rows\n");
+        return 0;
+    }
+    code->mb = mb;
+    code->nb = LDPC_INFO_BLOCKS + mb;
+    for (int r = 0; r < LDPC_MAX_ROWS; r++) {
+        for (int c = 0; c < LDPC_MAX_COLS; c++) {
+            code->shift[r][c] = -1;
+        }
+    }
+
+    int kb = LDPC_INFO_BLOCKS;
+    code->shift[0][kb] = 1;
+    code->shift[mb / 2][kb] = 0;
+    code->shift[mb - 1][kb] = 1;
+    for (int i = 1; i < mb; i++) {
+        code->shift[i - 1][kb + i] = 0;
+        code->shift[i][kb + i] = 0;
+    }
+
+    int row_degree[LDPC_MAX_ROWS] = { 0 };
+    uint32_t seed = 0x4C445043u + mb; // "LDPC"
+    for (int c = 0; c < kb; c++) {
+        // Pick the least used rows, breaking ties at random.
+        int rows[LDPC_COL_WEIGHT];
+        for (int w = 0; w < LDPC_COL_WEIGHT; w++) {
+            int best = -1;
+            uint32_t best_key = UINT32_MAX;
+            for (int r = 0; r < mb; r++) {
+                if (code->shift[r][c] >= 0) continue;
+                seed = seed * 1664525u + 1013904223u;
+                uint32_t key = ((uint32_t)row_degree[r] << 24) | (seed >> 8);
+                if (key < best_key) {
+                    best_key = key;
+                    best = r;
+                }
+            }
+            rows[w] = best;
+            code->shift[best][c] = 0;
+            row_degree[best]++;
+        }
+        do {
+            for (int w = 0; w < LDPC_COL_WEIGHT; w++) {
+                seed = seed * 1664525u + 1013904223u;
+                code->shift[rows[w]][c] = (seed >> 16) % LDPC_Z;
+            }
+        } while (!ldpc_column_is_4cycle_free(code, c));
+    }
+    return 1;
+}
+
+/**
+ * @brief Largest payload carried by one LDPC frame.
+ */
+int ldpc_payload_capacity(void) {
+    return LDPC_INFO_BYTES - 1 - AX25_OVERHEAD;
+}
+
+/**
+ * @brief XORs P^shift x into acc, where x and acc hold one bit per byte.
+ */
+static void ldpc_add_shifted(uint8_t* acc, const uint8_t* x, int shift) {
+    for (int z = 0; z < LDPC_Z; z++) {
+        acc[z] ^= x[(z + shift) % LDPC_Z];
+    }
+}
+
+/**
+ * @brief Systematic encoding of LDPC_INFO_BYTES into a codeword of nb * Z bits.
+ *
+ * With lambda_r the contribution of the information bits to block row r:
+ * p0 = sum of all lambda_r (the 1/0/1 column sums to the identity), then the
+ * staircase gives p1 = lambda_0 + P^1 p0 and p(i+1) = lambda_i + p_i (+ p0 in
+ * the middle row). Bits are packed MSB first, information blocks first.
+ */
+void ldpc_encode(const ldpc_code_t* code, const uint8_t* info, uint8_t* codeword) {
+    uint8_t bits[LDPC_MAX_COLS][LDPC_Z];
+    uint8_t lambda[LDPC_MAX_ROWS][LDPC_Z];
+    int kb = LDPC_INFO_BLOCKS;
+    int mb = code->mb;
+
+    for (int i = 0; i < kb * LDPC_Z; i++) {
+        bits[i / LDPC_Z][i % LDPC_Z] = (info[i >> 3] >> (7 - (i & 7))) & 1;
+    }
+    memset(lambda, 0, sizeof(lambda));
+    for (int r = 0; r < mb; r++) {
+        for (int c = 0; c < kb; c++) {
+            if (code->shift[r][c] >= 0) {
+                ldpc_add_shifted(lambda[r], bits[c], code->shift[r][c]);
+            }
+        }
+    }
+
+    uint8_t* p0 = bits[kb];
+    memset(p0, 0, LDPC_Z);
+    for (int r = 0; r < mb; r++) {
+        for (int z = 0; z < LDPC_Z; z++) p0[z] ^= lambda[r][z];
+    }
+    memcpy(bits[kb + 1], lambda[0], LDPC_Z);
+    ldpc_add_shifted(bits[kb + 1], p0, 1);
+    for (int i = 1; i < mb - 1; i++) {
+        for (int z = 0; z < LDPC_Z; z++) {
+            bits[kb + i + 1][z] = lambda[i][z] ^ bits[kb + i][z] ^ ((i == mb / 2) ? p0[z] : 0);
+        }
+    }
+
+    memcpy(codeword, info, LDPC_INFO_BYTES);
+    memset(codeword + LDPC_INFO_BYTES, 0, mb * LDPC_Z / 8);
+    for (int i = kb * LDPC_Z; i < code->nb * LDPC_Z; i++) {
+        codeword[i >> 3] |= bits[i / LDPC_Z][i % LDPC_Z] << (7 - (i & 7));
+    }
+}
+
+/**
+ * @brief Builds one LDPC frame: ASM, then the codeword whose information part
+ * is a length byte, the AX.25 frame and zero padding.
+ * WHY: The ASM is the CCSDS marker, which CCSDS also puts in front of LDPC
+ * codeblocks; the length byte removes the padding without guessing.
+ * @return The frame length, or 0 if the AX.25 frame does not fit.
+ */
+int ldpc_encode_frame(const ldpc_code_t* code, const uint8_t* ax25_frame, int ax25_len, uint8_t* out) {
+    if (ax25_len > LDPC_INFO_BYTES - 1) {
+        fprintf(stderr, "Error: AX.25 frame too large for an LDPC frame.\n");
+        return 0;
+    }
+    uint8_t info[LDPC_INFO_BYTES] = { 0 };
+    info[0] = ax25_len;
+    memcpy(info + 1, ax25_frame, ax25_len);
+    memcpy(out, CCSDS_ASM, 4);
+    ldpc_encode(code, info, out + 4);
+    return LDPC_FRAME_LEN(code);
+}
+
+
+// =============================================================================
+// CCSDS TM Module (Alternative Framing)
+// =============================================================================
+
+/**
+ * @brief Initializes the CCSDS framer and its pseudo-randomizer table.
+ * The randomizer is the CCSDS LFSR h(x) = x^8 + x^7 + x^5 + x^3 + 1, seeded
+ * with all ones at the start of every codeblock (FF 48 0E C0 9A ...).
+ * @return 1 on success, 0 if the depth is out of range.
+ */
+int ccsds_init(ccsds_tm_t* tm, int depth) {
+    if (depth < 1 || depth > CCSDS_MAX_DEPTH) {
+        fprintf(stderr, "Error: CCSDS interleave depth must be 1-%d\n", CCSDS_MAX_DEPTH);
+        return 0;
+    }
+    memset(tm, 0, sizeof(*tm));
+    tm->depth = depth;
+    tm->frame_len = depth * CCSDS_RS_K;
+    tm->fill = CCSDS_TF_HEADER;
+    tm->fhp = CCSDS_FHP_NONE;
+
+    uint8_t sr = 0xFF;
+    for (int i = 0; i < CCSDS_RS_N; i++) {
+        uint8_t byte = 0;
+        for (int bit = 0; bit < 8; bit++) {
+            byte = (byte << 1) | (sr & 1);
+            uint8_t feedback = (sr ^ (sr >> 3) ^ (sr >> 5) ^ (sr >> 7)) & 1;
+            sr = (sr >> 1) | (feedback << 7);
+        }
+        tm->pn[i] = byte;
+    }
+    for (int i = CCSDS_RS_N; i < (int)sizeof(tm->pn); i++) {
+        tm->pn[i] = tm->pn[i - CCSDS_RS_N];
+    }
+    return 1;
+}
+
+/**
+ * @brief XORs the randomizer sequence over a codeblock, 8 bytes per step.
+ */
+void ccsds_randomize(const ccsds_tm_t* tm, uint8_t* block, int length) {
+    int i = 0;
+    // WHY: memcpy keeps the 64-bit loads legal on unaligned buffers; compilers
+    // turn it into a single load/store on ARM and x86.
+    for (; i + 8 <= length; i += 8) {
+        uint64_t data, pn;
+        memcpy(&data, block + i, 8);
+        memcpy(&pn, tm->pn + i, 8);
+        data ^= pn;
+        memcpy(block + i, &data, 8);
+    }
+    for (; i < length; i++) {
+        block[i] ^= tm->pn[i];
+    }
+}
+
+/**
+ * @brief Finishes the current transfer frame and writes it as one CADU.
+ *
+ * 1. Primary header (version 0, SCID, VC 0, frame counts, first header pointer).
+ * 2. RS(255, 223) in the CCSDS dual-basis representation, interleaved to depth I:
+ *    frame byte j belongs to codeword j mod I, and the check bytes follow the
+ *    data in the same interleaved order.
+ * 3. Pseudo-randomization of the whole codeblock, then the ASM in front.
+ */
+void ccsds_write_frame(ccsds_tm_t* tm, FILE* output) {
+    uint8_t* f = tm->frame;
+    f[0] = (CCSDS_SCID >> 4) & 0x3F;                // Version 00, SCID high bits
+    f[1] = ((CCSDS_SCID & 0x0F) << 4) | (0 << 1);   // SCID low bits, VCID 0, no OCF
+    f[2] = tm->mc_count++;
+    f[3] = tm->vc_count++;
+    uint16_t status = (0x3 << 11) | (tm->fhp & 0x7FF); // Packets in order, segment length id 11
+    f[4] = status >> 8;
+    f[5] = status & 0xFF;
+
+    uint8_t cadu[4 + CCSDS_MAX_DEPTH * CCSDS_RS_N];
+    uint8_t* block = cadu + 4;
+    int depth = tm->depth;
+    memcpy(cadu, CCSDS_ASM, 4);
+    memcpy(block, f, tm->frame_len);
+
+    for (int i = 0; i < depth; i++) {
+        uint8_t codeword[CCSDS_RS_K];
+        uint8_t parity[CCSDS_RS_N - CCSDS_RS_K];
+        for (int k = 0; k < CCSDS_RS_K; k++) {
+            codeword[k] = f[i + k * depth];
+        }
+        encode_rs_ccsds(codeword, parity, 0);
+        for (int p = 0; p < CCSDS_RS_N - CCSDS_RS_K; p++) {
+            block[tm->frame_len + i + p * depth] = parity[p];
+        }
+    }
+
+    ccsds_randomize(tm, block, depth * CCSDS_RS_N);
+    write_coded_frame(output, tm->convolutional, cadu, 4 + depth * CCSDS_RS_N);
+
+    tm->frames_written++;
+    tm->fill = CCSDS_TF_HEADER;
+    tm->fhp = CCSDS_FHP_NONE;
+}
+
+/**
+ * @brief Appends bytes to the data field, emitting frames as they fill up.
+ */
+void ccsds_put_bytes(ccsds_tm_t* tm, const uint8_t* data, int length, FILE* output) {
+    while (length > 0) {
+        int space = tm->frame_len - tm->fill;
+        int n = (length < space) ? length : space;
+        memcpy(tm->frame + tm->fill, data, n);
+        tm->fill += n;
+        data += n;
+        length -= n;
+        if (tm->fill == tm->frame_len) {
+            ccsds_write_frame(tm, output);
+        }
+    }
+}
+
+/**
+ * @brief Wraps data in a CCSDS space packet and multiplexes it into frames.
+ * @param apid Application process ID; CCSDS_IDLE_APID for fill.
+ * @param data Packet data, or NULL for the 0x55 idle pattern.
+ */
+void ccsds_put_packet(ccsds_tm_t* tm, uint16_t apid, const uint8_t* data, int length, FILE* output) {
+    uint8_t header[CCSDS_SP_HEADER];
+    uint16_t count = (apid == CCSDS_IDLE_APID) ? 0 : (tm->packet_count++ & 0x3FFF);
+    header[0] = (apid >> 8) & 0x07;             // Version 0, TM, no secondary header
+    header[1] = apid & 0xFF;
+    header[2] = 0xC0 | (count >> 8);            // Unsegmented packet
+    header[3] = count & 0xFF;
+    header[4] = ((length - 1) >> 8) & 0xFF;     // Packet data length - 1
+    header[5] = (length - 1) & 0xFF;
+
+    if (tm->fhp == CCSDS_FHP_NONE) {
+        tm->fhp = tm->fill - CCSDS_TF_HEADER;   // First packet to start in this frame
+    }
+    ccsds_put_bytes(tm, header, CCSDS_SP_HEADER, output);
+
+    if (data) {
+        ccsds_put_bytes(tm, data, length, output);
+        return;
+    }
+    uint8_t idle[64];
+    memset(idle, 0x55, sizeof(idle));
+    while (length > 0) {
+        int n = (length < (int)sizeof(idle)) ? length : (int)sizeof(idle);
+        ccsds_put_bytes(tm, idle, n, output);
+        length -= n;
+    }
+}
+
+/**
+ * @brief Pads the last partial frame with an idle packet and writes it.
+ */
+void ccsds_flush(ccsds_tm_t* tm, FILE* output) {
+    if (tm->fill == CCSDS_TF_HEADER) return;
+    int space = tm->frame_len - tm->fill;
+    // WHY: An idle packet needs at least 7 bytes. If less is left, it runs
+    // on through the whole of the next frame, which then carries no header.
+    int idle_len = space - CCSDS_SP_HEADER;
+    if (idle_len < 1) {
+        idle_len += tm->frame_len - CCSDS_TF_HEADER;
+    }
+    ccsds_put_packet(tm, CCSDS_IDLE_APID, NULL, idle_len, output);
+}
+
+/**
+ * @brief File data bytes carried by one space packet.
+ * WHY: Sized so that one packet fills one frame's data field, so in steady
+ * state each frame carries exactly one packet header.
+ */
+int ccsds_packet_data_len(const ccsds_tm_t* tm) {
+    return tm->frame_len - CCSDS_TF_HEADER - CCSDS_SP_HEADER;
+}
+
+
+// =============================================================================
+// Pipeline Helper
+// =============================================================================
+
+/**
+ * @brief Runs one payload through AX.25 framing, FX.25 encoding and KISS output.
+ * @param code Index into FX25_CODES for the FEC stage (ignored for LDPC frames).
+ * @return The length of the FX.25 (or LDPC) frame written, or 0 on error.
+ */
+int packetize_payload(fx25_encoder_t* encoder, int code, ax25_address_t dest, ax25_address_t src,
+                      const uint8_t* payload, int payload_len, FILE* output) {
+    uint8_t ax25_buffer[512]; // Buffer for the AX.25 frame
+    uint8_t fx25_buffer[512]; // Buffer for the final FX.25 frame
+
+    // Step A: Generate the raw AX.25 frame in memory
+    int ax25_len = ax25_generate_ui_frame(ax25_buffer, dest, src, payload, payload_len);
+    if (ax25_len == 0) {
+        return 0;
+    }
+
+    // Step B: Encode the AX.25 frame with FX.25 FEC, or as an LDPC frame
+    if (encoder->ldpc) {
+        uint8_t ldpc_frame[4 + LDPC_MAX_CODEWORD];
+        int ldpc_len = ldpc_encode_frame(encoder->ldpc, ax25_buffer, ax25_len, ldpc_frame);
+        if (ldpc_len > 0) {
+            write_kiss_frame(output, ldpc_frame, ldpc_len);
+        }
+        return ldpc_len;
+    }
+    int fx25_len = fx25_encode_frame(encoder, code, ax25_buffer, ax25_len, fx25_buffer);
+    if (fx25_len == 0) {
+        return 0;
+    }
+
+    // Step C: Write the final, robust frame to the output in KISS format
+    write_coded_frame(output, encoder->convolutional, fx25_buffer, fx25_len);
+    return fx25_len;
+}
+
+
+// =============================================================================
+// Elevation Feed Module (Adaptive FEC)
+// =============================================================================
+
+/**
+ * @brief Parses one "t_s,el_deg,margin_db" profile line.
+ * @return 1 on success, 0 for comments, headers and malformed lines.
+ */
+int parse_profile_line(const char* line, double* t_s, double* el_deg, double* margin_db) {
+    if (line[0] == '#') return 0;
+    return sscanf(line, "%lf,%lf,%lf", t_s, el_deg, margin_db) == 3;
+}
+
+/**
+ * @brief Drains every complete line waiting on the live feed, keeping the newest.
+ * @param block Wait for data if no sample has been received yet.
+ */
+void feed_poll_live(elevation_feed_t* feed, int block) {
+    struct pollfd pfd = { .fd = feed->live_fd, .events = POLLIN };
+    // WHY: Never wait once a sample is known; a stale margin is better than
+    // a missed transmit slot. Only the very first frame waits for the tracker.
+    while (poll(&pfd, 1, (block && !feed->have_sample) ? -1 : 0) > 0) {
+        int space = (int)sizeof(feed->line) - 1 - feed->line_len;
+        ssize_t n = read(feed->live_fd, feed->line + feed->line_len, space);
+        if (n <= 0) {
+            feed->live_fd = -1; // Feed closed; keep using the last sample
+            return;
+        }
+        feed->line_len += n;
+        feed->line[feed->line_len] = '\0';
+
+        char* start = feed->line;
+        char* newline;
+        while ((newline = strchr(start, '\n')) != NULL) {
+            *newline = '\0';
+            double t, el, margin;
+            if (parse_profile_line(start, &t, &el, &margin)) {
+                feed->t_s = t;
+                feed->el_deg = el;
+                feed->margin_db = margin;
+                feed->have_sample = 1;
+            }
+            start = newline + 1;
+        }
+        feed->line_len = (int)strlen(start);
+        if (feed->line_len == (int)sizeof(feed->line) - 1) {
+            feed->line_len = 0; // WHY: Drop an over-long line rather than stall the feed.
+        }
+        memmove(feed->line, start, feed->line_len + 1);
+    }
+}
+
+/**
+ * @brief Opens an elevation feed: a profile file, or "-" for a live feed on stdin.
+ * WHY: An offline profile is loaded whole so the pass scheduler can look ahead
+ * to find when the link is open; a week of 1 s samples is only a few MB.
+ * @return 1 on success, 0 on error.
+ */
+int feed_open(elevation_feed_t* feed, const char* filename) {
+    memset(feed, 0, sizeof(*feed));
+    feed->live_fd = -1;
+    if (strcmp(filename, "-") == 0) {
+        feed->live_fd = STDIN_FILENO;
+        return 1;
+    }
+    FILE* f = fopen(filename, "r");
+    if (!f) {
+        perror("Error opening elevation profile");
+        return 0;
+    }
+
+    char line[256];
+    int capacity = 0;
+    feed_sample_t sample;
+    while (fgets(line, sizeof(line), f)) {
+        if (!parse_profile_line(line, &sample.t_s, &sample.el_deg, &sample.margin_db)) continue;
+        if (feed->n_samples == capacity) {
+            capacity = capacity ? 2 * capacity : 4096;
+            feed_sample_t* grown = realloc(feed->samples, capacity * sizeof(*grown));
+            if (!grown) {
+                fprintf(stderr, "Error: Out of memory reading elevation profile\n");
+                free(feed->samples);
+                fclose(f);
+                return 0;
+            }
+            feed->samples = grown;
+        }
+        feed->samples[feed->n_samples++] = sample;
+    }
+    fclose(f);
+    if (feed->n_samples == 0) {
+        fprintf(stderr, "Error: No samples in elevation profile %s\n", filename);
+        free(feed->samples);
+        feed->samples = NULL;
+        return 0;
+    }
+
+    // WHY: The profile only covers the passes, so the gaps between them are not
+    // sample intervals. The smallest step is the sampling interval of a pass.
+    feed->dt_s = 1.0;
+    for (int i = 1; i < feed->n_samples; i++) {
+        double step = feed->samples[i].t_s - feed->samples[i - 1].t_s;
+        if (step > 0.0 && (i == 1 || step < feed->dt_s)) feed->dt_s = step;
+    }
+    return 1;
+}
+
+void feed_close(elevation_feed_t* feed) {
+    free(feed->samples);
+    feed->samples = NULL;
+}
+
+/**
+ * @brief Time of the first sample, used as the transmit clock origin.
+ */
+double feed_start_time(elevation_feed_t* feed) {
+    return feed->samples ? feed->samples[0].t_s : 0.0;
+}
+
+/**
+ * @brief Link margin in effect at time t_s.
+ * Offline: the last sample at or before t_s (the first sample before that).
+ * Live: the newest sample received, regardless of t_s.
+ */
+double feed_margin_at(elevation_feed_t* feed, double t_s) {
+    if (!feed->samples) {
+        if (feed->live_fd >= 0) feed_poll_live(feed, 1);
+        return feed->have_sample ? feed->margin_db : -1e9;
+    }
+    while (feed->cursor + 1 < feed->n_samples && feed->samples[feed->cursor + 1].t_s <= t_s) {
+        feed->cursor++;
+    }
+    return feed->samples[feed->cursor].margin_db;
+}
+
+/**
+ * @brief Index of the first offline sample still in effect after t_s.
+ */
+int feed_first_sample_after(const elevation_feed_t* feed, double t_s) {
+    int lo = 0, hi = feed->n_samples;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (feed->samples[mid].t_s + feed->dt_s <= t_s) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * @brief Link-open time (margin >= 0) of an offline profile within [start_s, end_s).
+ * @return Seconds, or -1 for a live feed, which cannot be looked ahead.
+ */
+double feed_open_time(const elevation_feed_t* feed, double start_s, double end_s) {
+    if (!feed->samples) return -1.0;
+    double open_s = 0.0;
+    for (int i = feed_first_sample_after(feed, start_s);
+         i < feed->n_samples && feed->samples[i].t_s < end_s; i++) {
+        const feed_sample_t* s = &feed->samples[i];
+        if (s->margin_db < 0.0) continue;
+        double a = s->t_s > start_s ? s->t_s : start_s;
+        double b = s->t_s + feed->dt_s < end_s ? s->t_s + feed->dt_s : end_s;
+        if (b > a) open_s += b - a;
+    }
+    return open_s;
+}
+
+/**
+ * @brief Moves t_s forward by open_s seconds of link-open time.
+ * Closed samples are skipped, so open_s = 0 moves t_s to the next open instant.
+ * Past the last open sample the remaining time is added as is.
+ */
+double feed_advance_open(const elevation_feed_t* feed, double t_s, double open_s) {
+    for (int i = feed_first_sample_after(feed, t_s); i < feed->n_samples; i++) {
+        const feed_sample_t* s = &feed->samples[i];
+        double end = s->t_s + feed->dt_s;
+        if (s->margin_db < 0.0) continue;
+        if (t_s < s->t_s) t_s = s->t_s;
+        if (t_s + open_s < end) return t_s + open_s;
+        open_s -= end - t_s;
+        t_s = end;
+    }
+    return t_s + open_s;
+}
+
+/**
+ * @brief Picks the FX.25 code for a frame sent at time t_s.
+ * @param feed Elevation feed, or NULL for the fixed RS(255, 223) code.
+ * @return Index into FX25_CODES.
+ */
+int select_fx25_code(elevation_feed_t* feed, double t_s) {
+    if (!feed) return FX25_CODE_DEFAULT;
+    double margin = feed_margin_at(feed, t_s);
+    if (margin >= FEC_LIGHT_MARGIN_DB) return 0;  // 16 check bytes
+    if (margin >= FEC_STRONG_MARGIN_DB) return 1; // 32 check bytes
+    return 2;                                     // 64 check bytes
+}
+
+/**
+ * @brief Payload bytes to read for a frame using the given code.
+ * WHY: Without a feed the historical MAX_PAYLOAD chunking is kept; with a feed
+ * each chunk fills the codeword so lighter codes carry more payload. LDPC
+ * frames have a single fixed size, so their chunks always fill the block.
+ */
+int frame_chunk_size(const fx25_encoder_t* encoder, elevation_feed_t* feed, int code) {
+    if (encoder->ldpc) return ldpc_payload_capacity();
+    return feed ? fx25_payload_capacity(code) : MAX_PAYLOAD;
+}
+
+
+// =============================================================================
+// Pass Scheduler Module
+// =============================================================================
+
+/**
+ * @brief Reads a pass schedule CSV written by adcs_skissue.py --schedule.
+ * Columns: pass,start_s,end_s,max_el_deg,budget_s,sf,bw_khz,cr
+ * Lines starting with '#' and the header row are skipped.
+ * @return Number of passes read, or -1 on error.
+ */
+int read_pass_schedule(const char* filename, pass_window_t* passes, int max_passes) {
+    FILE* f = fopen(filename, "r");
+    if (!f) {
+        perror("Error opening schedule file");
+        return -1;
+    }
+
+    char line[256];
+    int count = 0;
+    while (fgets(line, sizeof(line), f) && count < max_passes) {
+        pass_window_t* p = &passes[count];
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%d,%lf,%lf,%lf,%lf,%d,%lf,%d", &p->index, &p->start_s, &p->end_s,
+                   &p->max_el_deg, &p->budget_s, &p->sf, &p->bw_khz, &p->cr) != 8) {
+            continue; // WHY: Header row or malformed line; a partial row must never be scheduled.
+        }
+        if (p->sf < 6 || p->sf > 12 || p->bw_khz <= 0.0 || p->cr < 1 || p->cr > 4) {
+            fprintf(stderr, "Warning: Skipping pass %d with invalid LoRa settings\n", p->index);
+            continue;
+        }
+        count++;
+    }
+    fclose(f);
+    return count;
+}
+
+/**
+ * @brief Transmit time of the next frame slot in a pass.
+ * @param open_only Step in link-open time of the offline profile, skipping
+ *                  the parts of the pass where the margin is negative.
+ */
+double next_slot_time(const elevation_feed_t* feed, int open_only, double t_clock, double step) {
+    return open_only ? feed_advance_open(feed, t_clock, step) : t_clock + step;
+}
+
+/**
+ * @brief Packs frames into every pass of the schedule, highest priority first.
+ *
+ * For each pass the budget is spent on: the beacon (re-sent every pass), then
+ * housekeeping, then payload. Housekeeping and payload are consumed in order
+ * across passes so the ground station can reassemble them. A frame that does
+ * not fit the remaining budget is left in its queue for the next pass.
+ *
+ * WHY: Every FX.25 frame is a full 255-byte codeword, so a frame's airtime does
+ * not depend on how much payload it carries. Reading full MAX_PAYLOAD chunks
+ * and never splitting a frame across a pass boundary is what maximises the
+ * useful bytes per window.
+ *
+ * With an elevation feed the frames are spread evenly over each pass (the
+ * budget is a share of the pass, interleaved with RX windows) and each one
+ * gets the RS code matching the link margin at its transmit time. An offline
+ * profile spreads them over the link-open part only (margin >= 0), which is
+ * what the budget was computed from; a live feed spreads them over the pass.
+ *
+ * The prediction is the chunk size of each frame slot's code summed over the
+ * slots that fit, so it is the most the pass could carry: Eff% <= 100.
+ *
+ * @param sources File streams per priority class; NULL if the class is unused.
+ * @param feed Elevation feed for adaptive FEC, or NULL for fixed RS(255, 223).
+ * @return Total number of frames written, or -1 on error.
+ */
+int run_pass_schedule(fx25_encoder_t* encoder, ax25_address_t dest, ax25_address_t src,
+                      const pass_window_t* passes, int n_passes,
+                      FILE* sources[PRIO_COUNT], elevation_feed_t* feed,
+                      const char* output_prefix) {
+    static const char* prio_names[PRIO_COUNT] = { "beacon", "housekeeping", "payload" };
+    uint8_t payload_buffer[FX25_N];
+    long sent_bytes[PRIO_COUNT] = { 0 };
+    int code_frames[FX25_NUM_CODES] = { 0 };
+    int total_frames = 0;
+    double total_budget = 0.0, total_used = 0.0;
+    long total_useful = 0, total_predicted = 0;
+
+    // WHY: The beacon is a single frame; it is read once and repeated every pass.
+    int beacon_len = 0;
+    uint8_t beacon[MAX_PAYLOAD];
+    if (sources[PRIO_BEACON]) {
+        beacon_len = fread(beacon, 1, MAX_PAYLOAD, sources[PRIO_BEACON]);
+    }
+
+    printf("\n  %4s %9s %9s %6s %4s %4s %4s %8s %6s %9s %9s %6s\n",
+           "Pass", "Start(s)", "Budget(s)", "MaxEl", "Bcn", "HK", "Pay",
+           "Used(s)", "Util%", "Useful(B)", "Pred(B)", "Eff%");
+
+    for (int i = 0; i < n_passes; i++) {
+        const pass_window_t* pass = &passes[i];
+        // All frames have the same on-air length (tag + full RS codeword).
+        double t_frame = frame_airtime(fx25_onair_len(encoder), pass);
+        long predicted = 0;
+        double remaining = pass->budget_s;
+        double open_s = feed ? feed_open_time(feed, pass->start_s, pass->end_s) : -1.0;
+        int open_only = open_s > 0.0;
+        double span_s = open_only ? open_s : pass->end_s - pass->start_s;
+        double t_clock = open_only ? feed_advance_open(feed, pass->start_s, 0.0) : pass->start_s;
+        double clock_step = (pass->budget_s > 0.0) ? t_frame * span_s / pass->budget_s : 0.0;
+        int frames[PRIO_COUNT] = { 0 };
+        long useful = 0;
+
+        // WHY: Passes too short (or too low) for a single frame get no output file.
+        FILE* out = NULL;
+        if (remaining >= t_frame) {
+            char out_name[1024];
+            snprintf(out_name, sizeof(out_name), "%s.%03d", output_prefix, pass->index);
+            out = fopen(out_name, "wb");
+            if (!out) {
+                perror("Error creating pass output file");
+                return -1;
+            }
+        }
+
+        for (int prio = 0; prio < PRIO_COUNT && remaining >= t_frame; prio++) {
+            if (prio == PRIO_BEACON) {
+                int code = select_fx25_code(feed, t_clock);
+                if (beacon_len > 0 &&
+                    packetize_payload(encoder, code, dest, src, beacon, beacon_len, out) > 0) {
+                    remaining -= t_frame;
+                    t_clock = next_slot_time(feed, open_only, t_clock, clock_step);
+                    frames[prio]++;
+                    code_frames[code]++;
+                    useful += beacon_len;
+                    predicted += frame_chunk_size(encoder, feed, code);
+                }
+                continue;
+            }
+            if (!sources[prio]) continue;
+
+            while (remaining >= t_frame) {
+                // WHY: Only read a chunk once it is known to fit, so nothing
+                // has to be pushed back into the stream at a pass boundary.
+                int code = select_fx25_code(feed, t_clock);
+                int len = fread(payload_buffer, 1, frame_chunk_size(encoder, feed, code), sources[prio]);
+                if (len == 0) break; // Queue drained; fall through to next class
+                if (packetize_payload(encoder, code, dest, src, payload_buffer, len, out) == 0) {
+                    fprintf(stderr, "Warning: Failed to packetize %s chunk in pass %d\n",
+                            prio_names[prio], pass->index);
+                    continue;
+                }
+                remaining -= t_frame;
+                t_clock = next_slot_time(feed, open_only, t_clock, clock_step);
+                frames[prio]++;
+                code_frames[code]++;
+                useful += len;
+                predicted += frame_chunk_size(encoder, feed, code);
+                sent_bytes[prio] += len;
+            }
+        }
+        if (out) fclose(out);
+
+        // WHY: Slots left over once the queues drain still count towards the
+        // prediction, with the code their transmit time would have used.
+        for (double spare = remaining; spare >= t_frame; spare -= t_frame) {
+            predicted += frame_chunk_size(encoder, feed, select_fx25_code(feed, t_clock));
+            t_clock = next_slot_time(feed, open_only, t_clock, clock_step);
+        }
+        if (useful > predicted) {
+            fprintf(stderr, "Warning: Pass %d sent %ld useful bytes, more than the %ld predicted\n",
+                    pass->index, useful, predicted);
+        }
+
+        double used = pass->budget_s - remaining;
+        int n_frames = frames[PRIO_BEACON] + frames[PRIO_HOUSEKEEPING] + frames[PRIO_PAYLOAD];
+        total_frames += n_frames;
+        total_budget += pass->budget_s;
+        total_used += used;
+        total_useful += useful;
+        total_predicted += predicted;
+
+        printf("  %4d %9.0f %9.1f %6.1f %4d %4d %4d %8.1f %6.1f %9ld %9ld %6.1f\n",
+               pass->index, pass->start_s, pass->budget_s, pass->max_el_deg,
+               frames[PRIO_BEACON], frames[PRIO_HOUSEKEEPING], frames[PRIO_PAYLOAD],
+               used, pass->budget_s > 0 ? 100.0 * used / pass->budget_s : 0.0,
+               useful, predicted, predicted > 0 ? 100.0 * useful / predicted : 0.0);
+    }
+
+    printf("\n  Airtime utilization : %.1f of %.1f s (%.1f%%)\n", total_used, total_budget,
+           total_budget > 0 ? 100.0 * total_used / total_budget : 0.0);
+    printf("  Useful bytes        : %ld achieved vs %ld predicted (%.1f%%)\n", total_useful,
+           total_predicted, total_predicted > 0 ? 100.0 * total_useful / total_predicted : 0.0);
+    printf("  Housekeeping sent   : %ld bytes\n", sent_bytes[PRIO_HOUSEKEEPING]);
+    printf("  Payload sent        : %ld bytes\n", sent_bytes[PRIO_PAYLOAD]);
+    if (feed) {
+        printf("  RS check bytes      : 16 x %d, 32 x %d, 64 x %d frames\n",
+               code_frames[0], code_frames[1], code_frames[2]);
+    }
+    for (int prio = PRIO_HOUSEKEEPING; prio < PRIO_COUNT; prio++) {
+        if (!sources[prio]) continue;
+        int next = fgetc(sources[prio]);
+        if (next != EOF) {
+            ungetc(next, sources[prio]);
+            printf("  NOTE: %s queue not drained; extend the schedule to send the rest.\n",
+                   prio_names[prio]);
+        }
+    }
+    return total_frames;
+}
+
+
+// =============================================================================
+// Benchmark Module
+// =============================================================================
+
+#define BENCH_BYTES (4 * 1024 * 1024) // Synthetic input pushed through every path
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Times the FX.25 and CCSDS encode paths on the same synthetic input.
+ *
+ * Reports encoder throughput (input MB/s, KISS output to /dev/null included)
+ * and on-air efficiency: input bytes / transmitted bytes, tags, ASMs and
+ * parity included.
+ * @return 0 on success, 1 on error.
+ */
+int run_benchmark(fx25_encoder_t* encoder, ax25_address_t dest, ax25_address_t src) {
+    uint8_t* data = malloc(BENCH_BYTES);
+    FILE* sink = fopen("/dev/null", "wb");
+    if (!data || !sink) {
+        free(data);
+        if (sink) fclose(sink);
+        return 1;
+    }
+    srand(1);
+    for (int i = 0; i < BENCH_BYTES; i++) data[i] = rand() & 0xFF;
+
+    printf("\n  %-26s %8s %12s %8s %10s\n", "Mode", "Frames", "OnAir(B)", "Eff%", "MB/s");
+
+    // FX.25 with the default chunking, with chunks filling the codeword, and
+    // the latter through the convolutional inner code
+    int fx25_chunks[3] = { MAX_PAYLOAD, fx25_payload_capacity(FX25_CODE_DEFAULT),
+                           fx25_payload_capacity(FX25_CODE_DEFAULT) };
+    for (int c = 0; c < 3; c++) {
+        encoder->convolutional = (c == 2);
+        long frames = 0;
+        double t0 = now_seconds();
+        for (int pos = 0; pos < BENCH_BYTES; pos += fx25_chunks[c]) {
+            int len = (BENCH_BYTES - pos < fx25_chunks[c]) ? BENCH_BYTES - pos : fx25_chunks[c];
+            frames += packetize_payload(encoder, FX25_CODE_DEFAULT, dest, src, data + pos, len, sink) > 0;
+        }
+        double dt = now_seconds() - t0;
+        long on_air = frames * fx25_onair_len(encoder);
+        char label[48];
+        snprintf(label, sizeof(label), "FX.25 RS(255,223) %3dB%s", fx25_chunks[c],
+                 encoder->convolutional ? " +CC" : "");
+        printf("  %-26s %8ld %12ld %8.1f %10.1f\n", label, frames, on_air,
+               100.0 * BENCH_BYTES / on_air, BENCH_BYTES / dt / 1e6);
+    }
+    encoder->convolutional = 0;
+
+    // LDPC frames at both rates, each chunk filling the information block
+    for (int rows = LDPC_MAX_ROWS; rows >= 4; rows -= 4) {
+        ldpc_code_t ldpc;
+        ldpc_build(&ldpc, rows);
+        encoder->ldpc = &ldpc;
+        int chunk = ldpc_payload_capacity();
+        long frames = 0;
+        double t0 = now_seconds();
+        for (int pos = 0; pos < BENCH_BYTES; pos += chunk) {
+            int len = (BENCH_BYTES - pos < chunk) ? BENCH_BYTES - pos : chunk;
+            frames += packetize_payload(encoder, 0, dest, src, data + pos, len, sink) > 0;
+        }
+        double dt = now_seconds() - t0;
+        long on_air = frames * fx25_onair_len(encoder);
+        printf("  %-26s %8ld %12ld %8.1f %10.1f\n", rows == LDPC_MAX_ROWS ? "LDPC rate 1/2" : "LDPC rate 2/3",
+               frames, on_air, 100.0 * BENCH_BYTES / on_air, BENCH_BYTES / dt / 1e6);
+    }
+    encoder->ldpc = NULL;
+
+    for (int depth = 1; depth <= CCSDS_MAX_DEPTH; depth++) {
+        ccsds_tm_t tm;
+        ccsds_init(&tm, depth);
+        int chunk = ccsds_packet_data_len(&tm);
+        double t0 = now_seconds();
+        for (int pos = 0; pos < BENCH_BYTES; pos += chunk) {
+            int len = (BENCH_BYTES - pos < chunk) ? BENCH_BYTES - pos : chunk;
+            ccsds_put_packet(&tm, CCSDS_APID, data + pos, len, sink);
+        }
+        ccsds_flush(&tm, sink);
+        double dt = now_seconds() - t0;
+        long on_air = tm.frames_written * (4 + depth * CCSDS_RS_N);
+        char label[48];
+        snprintf(label, sizeof(label), "CCSDS TM RS(255,223) I=%d", depth);
+        printf("  %-26s %8ld %12ld %8.1f %10.1f\n", label, tm.frames_written, on_air,
+               100.0 * BENCH_BYTES / on_air, BENCH_BYTES / dt / 1e6);
+    }
+
+    fclose(sink);
+    free(data);
+    return 0;
+}
+
+
+// =============================================================================
+// Voice Stream Module (Low-Latency FX.25)
+// =============================================================================
+
+#define VOICE_DEFAULT_SOURCE_BPS 8750 // ADPCM 4 kHz mode: a 32-byte codec frame per 29.25 ms
+#define VOICE_DEFAULT_DEADLINE_MS 60
+#define VOICE_READ_CHUNK 256
+
+/**
+ * @brief State of the voice mode: the frame being filled and the transmitter clock.
+ * WHY: Voice is only useful if it is on time, so every frame is costed
+ * against a modelled transmitter as it is cut, instead of being queued
+ * behind whatever the link has not sent yet.
+ */
+typedef struct {
+    double t_air;        // Airtime of one frame at the link rate
+    double deadline_s;   // First byte captured -> last bit on air
+    uint8_t pending[FX25_N];
+    int pending_len;
+    int capacity;        // Payload bytes per frame
+    double t_first;      // Arrival of the first pending byte
+    double t_free;       // When the transmitter finishes its current frame
+    long frames, dropped, dropped_bytes;
+    double latency_sum, latency_min, latency_max, fill_sum, wait_sum;
+} voice_stream_t;
+
+/**
+ * @brief Latest time the pending bytes can be cut and still make the deadline.
+ */
+double voice_cut_by(const voice_stream_t* v) {
+    return v->t_first + v->deadline_s - v->t_air;
+}
+
+/**
+ * @brief Frames the pending bytes at t_cut, or drops them if they would be late.
+ * WHY: At most one frame may wait for the transmitter. If the frame on air
+ * ends more than one frame time after t_cut, another frame is already
+ * waiting, the link has fallen behind, and dropping this one is what lets it
+ * catch up. Sending late voice would only delay every frame behind it.
+ */
+void voice_cut(voice_stream_t* v, double t_cut, fx25_encoder_t* encoder, ax25_address_t dest,
+               ax25_address_t src, FILE* output) {
+    if (v->pending_len == 0) return;
+    double t_start = (v->t_free > t_cut) ? v->t_free : t_cut;
+    double latency = t_start + v->t_air - v->t_first;
+    if (t_start - t_cut > v->t_air || latency > v->deadline_s) {
+        v->dropped++;
+        v->dropped_bytes += v->pending_len;
+    } else if (packetize_payload(encoder, FX25_CODE_VOICE, dest, src, v->pending, v->pending_len, output) > 0) {
+        fflush(output); // WHY: The TNC must get the frame now, not when the stdio buffer fills.
+        v->t_free = t_start + v->t_air;
+        v->frames++;
+        v->latency_sum += latency;
+        v->fill_sum += t_cut - v->t_first;
+        v->wait_sum += t_start - t_cut;
+        if (v->frames == 1 || latency < v->latency_min) v->latency_min = latency;
+        if (latency > v->latency_max) v->latency_max = latency;
+    }
+    v->pending_len = 0;
+}
+
+/**
+ * @brief Adds one stream byte that arrived at time t; a full frame is cut at once.
+ */
+void voice_push(voice_stream_t* v, uint8_t byte, double t, fx25_encoder_t* encoder,
+                ax25_address_t dest, ax25_address_t src, FILE* output) {
+    if (v->pending_len == 0) v->t_first = t;
+    v->pending[v->pending_len++] = byte;
+    if (v->pending_len == v->capacity) voice_cut(v, t, encoder, dest, src, output);
+}
+
+/**
+ * @brief Cuts a continuous stream into RS(48, 32) FX.25 frames under a deadline.
+ *
+ * A frame is cut when it is full, or earlier if waiting for more bytes would
+ * make its first byte miss the deadline (a slow or bursty source). Latency
+ * runs from the arrival of a frame's first byte to the last bit of the frame
+ * on air: fill time, wait for the transmitter and airtime. Decoding on the
+ * ground adds well under a millisecond.
+ *
+ * @param live_fd Descriptor of a live stream (arrival times are measured),
+ * or -1 to replay input at source_bps.
+ * @return 0 on success, 1 on error.
+ */
+int run_voice_stream(fx25_encoder_t* encoder, ax25_address_t dest, ax25_address_t src,
+                     FILE* input, int live_fd, FILE* output,
+                     double source_bps, double air_bps, double deadline_s) {
+    voice_stream_t v;
+    memset(&v, 0, sizeof(v));
+    int onair = fx25_code_onair_len(encoder, FX25_CODE_VOICE);
+    v.capacity = fx25_payload_capacity(FX25_CODE_VOICE);
+    v.t_air = 8.0 * onair / air_bps;
+    v.deadline_s = deadline_s;
+    if (v.t_air >= deadline_s) {
+        fprintf(stderr, "Error: A %d-byte frame takes %.1f ms at %.0f bit/s, more than the %.0f ms deadline\n",
+                onair, v.t_air * 1e3, air_bps, deadline_s * 1e3);
+        return 1;
+    }
+
+    // WHY: AX.25 addressing and FCS take 18 of the 32 data bytes, so the link
+    // has to run at four times the source rate (eight with -V) to keep up.
+    double needed_bps = source_bps * onair / v.capacity;
+    printf("  Voice frames: RS(48, 32), %d payload bytes, %d bytes / %.1f ms on air\n",
+           v.capacity, onair, v.t_air * 1e3);
+    if (live_fd < 0) {
+        printf("  Source: %.0f bit/s, needs %.0f bit/s on air (link: %.0f bit/s)\n",
+               source_bps, needed_bps, air_bps);
+        if (needed_bps > air_bps) {
+            printf("  WARNING: The link is too slow for this source; frames will be dropped.\n");
+        }
+    }
+
+    uint8_t chunk[VOICE_READ_CHUNK];
+    if (live_fd < 0) {
+        long index = 0;
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), input)) > 0) {
+            for (size_t i = 0; i < n; i++, index++) {
+                double t = index * 8.0 / source_bps;
+                if (v.pending_len > 0 && t > voice_cut_by(&v)) {
+                    voice_cut(&v, voice_cut_by(&v), encoder, dest, src, output);
+                }
+                voice_push(&v, chunk[i], t, encoder, dest, src, output);
+            }
+        }
+        double t_end = index * 8.0 / source_bps;
+        voice_cut(&v, (t_end < voice_cut_by(&v)) ? t_end : voice_cut_by(&v), encoder, dest, src, output);
+    } else {
+        double t0 = now_seconds();
+        struct pollfd pfd = { .fd = live_fd, .events = POLLIN };
+        while (1) {
+            // WHY: Block only while nothing is pending; otherwise wake up in
+            // time to cut the partial frame before its deadline.
+            int timeout_ms = -1;
+            if (v.pending_len > 0) {
+                double wait = voice_cut_by(&v) - (now_seconds() - t0);
+                timeout_ms = (wait > 0.0) ? (int)(wait * 1e3) : 0;
+            }
+            int ready = poll(&pfd, 1, timeout_ms);
+            double t = now_seconds() - t0;
+            if (ready == 0) {
+                voice_cut(&v, t, encoder, dest, src, output);
+                continue;
+            }
+            ssize_t n = read(live_fd, chunk, sizeof(chunk));
+            if (n <= 0) break; // End of stream
+            for (ssize_t i = 0; i < n; i++) {
+                voice_push(&v, chunk[i], t, encoder, dest, src, output);
+            }
+        }
+        voice_cut(&v, now_seconds() - t0, encoder, dest, src, output);
+    }
+
+    printf("\n  Frames sent       : %ld\n", v.frames);
+    printf("  Dropped (late)    : %ld frame(s), %ld byte(s)\n", v.dropped, v.dropped_bytes);
+    if (v.frames > 0) {
+        printf("  Latency           : %.1f / %.1f / %.1f ms (min / mean / max), deadline %.0f ms\n",
+               v.latency_min * 1e3, v.latency_sum / v.frames * 1e3, v.latency_max * 1e3, deadline_s * 1e3);
+        printf("  Mean breakdown    : fill %.1f ms + queue %.1f ms + air %.1f ms\n",
+               v.fill_sum / v.frames * 1e3, v.wait_sum / v.frames * 1e3, v.t_air * 1e3);
+    }
+    return 0;
+}
+
 
 // =============================================================================
 // Main Application
 // =============================================================================
 
+// WHY: The ground-station tools build this file into themselves with
+// PACKETIZER_LIBRARY defined, so they share the framing and FEC code above.
+#ifndef PACKETIZER_LIBRARY
+
+void print_usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [-s schedule.csv] [-B beacon_file] [-H hk_file] [-e profile.csv|-] "
+                    "[-C depth] [-L 1/2|2/3] [-V] <source_call> <dest_call> <input_file> <output_kiss_file>\n"
+                    "       %s -A air_bps [-D ms] [-R bps] [-V] <source_call> <dest_call> <input_file|-> <output_kiss_file>\n"
+                    "       %s -b\n", prog, prog, prog);
+}
+
 int main(int argc, char* argv[]) {
     // --- 1. Argument Parsing ---
-    if (argc < 5) {
-        fprintf(stderr, "Usage: %s <source_call> <dest_call> <input_file> <output_kiss_file>\n", argv[0]);
+    const char* schedule_filename = NULL;
+    const char* profile_filename = NULL;
+    const char* class_filenames[PRIO_COUNT] = { NULL };
+    int ccsds_depth = 0; // 0 = AX.25/FX.25
+    int convolutional = 0;
+    int ldpc_rows = 0; // 0 = FX.25 Reed-Solomon
+    int benchmark = 0;
+    double air_bps = 0.0; // 0 = bulk mode, not voice
+    double deadline_ms = VOICE_DEFAULT_DEADLINE_MS;
+    double source_bps = VOICE_DEFAULT_SOURCE_BPS;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:B:H:e:C:L:VbA:D:R:")) != -1) {
+        switch (opt) {
+        case 's': schedule_filename = optarg; break;
+        case 'B': class_filenames[PRIO_BEACON] = optarg; break;
+        case 'H': class_filenames[PRIO_HOUSEKEEPING] = optarg; break;
+        case 'e': profile_filename = optarg; break;
+        case 'C': ccsds_depth = atoi(optarg) ? atoi(optarg) : -1; break; // -1: rejected below
+        case 'L': ldpc_rows = !strcmp(optarg, "1/2") ? 8 : !strcmp(optarg, "2/3") ? 4 : -1; break;
+        case 'V': convolutional = 1; break;
+        case 'b': benchmark = 1; break;
+        case 'A': air_bps = atof(optarg) > 0.0 ? atof(optarg) : -1.0; break; // -1: rejected below
+        case 'D': deadline_ms = atof(optarg); break;
+        case 'R': source_bps = atof(optarg); break;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (benchmark) {
+        ax25_address_t bench_src = { .call = "N0CALL", .ssid = 1 };
+        ax25_address_t bench_dest = { .call = "CQ", .ssid = 0 };
+        fx25_encoder_t* encoder = fx25_init();
+        if (!encoder) {
+            fprintf(stderr, "Error: Failed to initialize FX.25 encoder.\n");
+            return 1;
+        }
+        int status = run_benchmark(encoder, bench_dest, bench_src);
+        fx25_cleanup(encoder);
+        return status;
+    }
+    if (ccsds_depth && (schedule_filename || profile_filename)) {
+        // WHY: The scheduler and adaptive FEC cost and tag FX.25 frames; CCSDS
+        // frames have a different length and a fixed code.
+        fprintf(stderr, "Error: -C cannot be combined with -s or -e\n");
+        return 1;
+    }
+    if (ldpc_rows && (ccsds_depth || profile_filename || convolutional)) {
+        // WHY: LDPC is a frame format of its own, with a fixed code rate and
+        // soft decoding built in.
+        fprintf(stderr, "Error: -L cannot be combined with -C, -e or -V\n");
+        return 1;
+    }
+    if (air_bps && (schedule_filename || profile_filename || ccsds_depth || ldpc_rows)) {
+        // WHY: Voice mode always sends the short RS(48, 32) frames as soon as
+        // they are cut; the schedulers and the other frame formats would hold
+        // them back or lengthen them.
+        fprintf(stderr, "Error: -A cannot be combined with -s, -e, -C or -L\n");
+        return 1;
+    }
+    if (air_bps < 0.0 || deadline_ms <= 0.0 || source_bps <= 0.0) {
+        fprintf(stderr, "Error: -A, -D and -R take positive rates and times\n");
+        return 1;
+    }
+    if (ldpc_rows < 0) {
+        fprintf(stderr, "Error: -L takes a code rate of 1/2 or 2/3\n");
+        return 1;
+    }
+    ldpc_code_t ldpc;
+    if (ldpc_rows && !ldpc_build(&ldpc, ldpc_rows)) {
+        return 1;
+    }
+    ccsds_tm_t ccsds = {0};
+    if (ccsds_depth && !ccsds_init(&ccsds, ccsds_depth)) {
+        return 1;
+    }
+    ccsds.convolutional = convolutional;
+    if (argc - optind < 4) {
+        print_usage(argv[0]);
         return 1;
     }
+    argv += optind - 1; // WHY: Keep the positional arguments at argv[1..4] as before.
 
     // Simple parsing of callsign and SSID
     ax25_address_t src_addr = { .ssid = 0 };
@@ -267,6 +1760,7 @@ int main(int argc, char* argv[]) {
     sscanf(argv[2], "%7[^-]-%hhu", dest_addr.call, &dest_addr.ssid);
     const char* input_filename = argv[3];
     const char* output_filename = argv[4];
+    class_filenames[PRIO_PAYLOAD] = input_filename;
 
     printf("Packetizer starting...\n");
     printf("  Source: %s-%d\n", src_addr.call, src_addr.ssid);
@@ -280,10 +1774,77 @@ int main(int argc, char* argv[]) {
         fprintf(stderr, "Error: Failed to initialize FX.25 encoder.\n");
         return 1;
     }
+    encoder->convolutional = convolutional;
+    if (ldpc_rows) {
+        encoder->ldpc = &ldpc;
+        printf("  Frame format: LDPC rate %s, %d-bit codeword\n", ldpc_rows == 8 ? "1/2" : "2/3",
+               ldpc.nb * LDPC_Z);
+    }
+    if (convolutional) {
+        printf("  Inner code: convolutional k=7 r=1/2\n");
+    }
+
+    elevation_feed_t feed_storage;
+    elevation_feed_t* feed = NULL;
+    if (profile_filename) {
+        printf("  Elevation feed: %s\n", strcmp(profile_filename, "-") ? profile_filename : "stdin (live)");
+        if (!feed_open(&feed_storage, profile_filename)) {
+            fx25_cleanup(encoder);
+            return 1;
+        }
+        feed = &feed_storage;
+    }
+
+    // --- 2a. Pass-Scheduled Mode ---
+    if (schedule_filename) {
+        printf("  Schedule: %s\n", schedule_filename);
+        pass_window_t* passes = malloc(MAX_PASSES * sizeof(pass_window_t));
+        if (!passes) {
+            if (feed) feed_close(feed);
+            fx25_cleanup(encoder);
+            return 1;
+        }
+        int n_passes = read_pass_schedule(schedule_filename, passes, MAX_PASSES);
+
+        FILE* sources[PRIO_COUNT] = { NULL };
+        int status = (n_passes > 0) ? 0 : 1;
+        for (int prio = 0; prio < PRIO_COUNT && status == 0; prio++) {
+            if (!class_filenames[prio]) continue;
+            sources[prio] = fopen(class_filenames[prio], "rb");
+            if (!sources[prio]) {
+                perror(class_filenames[prio]);
+                status = 1;
+            }
+        }
+
+        if (status == 0) {
+            int frames = run_pass_schedule(encoder, dest_addr, src_addr, passes, n_passes,
+                                           sources, feed, output_filename);
+            if (frames < 0) {
+                status = 1;
+            } else {
+                printf("Successfully created %d packet(s) over %d pass(es).\n", frames, n_passes);
+                printf("Output written to %s.NNN\n", output_filename);
+            }
+        } else if (n_passes == 0) {
+            fprintf(stderr, "Error: No usable passes in %s\n", schedule_filename);
+        }
+
+        for (int prio = 0; prio < PRIO_COUNT; prio++) {
+            if (sources[prio]) fclose(sources[prio]);
+        }
+        free(passes);
+        if (feed) feed_close(feed);
+        fx25_cleanup(encoder);
+        return status;
+    }
 
-    FILE* input_file = fopen(input_filename, "rb"); // WHY: "rb" for binary read.
+    // WHY: A live voice stream comes down a pipe, e.g. from the codec.
+    int live_voice = air_bps > 0.0 && !strcmp(input_filename, "-");
+    FILE* input_file = live_voice ? stdin : fopen(input_filename, "rb"); // WHY: "rb" for binary read.
     if (!input_file) {
         perror("Error opening input file");
+        if (feed) feed_close(feed);
         fx25_cleanup(encoder);
         return 1;
     }
@@ -291,40 +1852,66 @@ int main(int argc, char* argv[]) {
     FILE* output_file = fopen(output_filename, "wb"); // WHY: "wb" for binary write.
     if (!output_file) {
         perror("Error creating output file");
-        fclose(input_file);
+        if (!live_voice) fclose(input_file);
+        if (feed) feed_close(feed);
         fx25_cleanup(encoder);
         return 1;
     }
 
     // --- 3. Main Processing Loop ---
-    uint8_t payload_buffer[MAX_PAYLOAD];
-    uint8_t ax25_buffer[512]; // Buffer for the AX.25 frame
-    uint8_t fx25_buffer[512]; // Buffer for the final FX.25 frame
+    uint8_t payload_buffer[CCSDS_MAX_DEPTH * CCSDS_RS_K];
     size_t bytes_read;
     int packet_count = 0;
 
-    // WHY: Reading in chunks is memory-efficient and crucial for embedded systems.
-    // We avoid loading the entire file into RAM.
-    while ((bytes_read = fread(payload_buffer, 1, MAX_PAYLOAD, input_file)) > 0) {
-
-        // Step A: Generate the raw AX.25 frame in memory
-        int ax25_len = ax25_generate_ui_frame(ax25_buffer, dest_addr, src_addr, payload_buffer, bytes_read);
-        if (ax25_len == 0) {
-            fprintf(stderr, "Warning: Failed to generate AX.25 frame for packet %d\n", packet_count);
-            continue;
+    // --- 3a. CCSDS TM Framing Mode ---
+    if (ccsds_depth) {
+        int chunk = ccsds_packet_data_len(&ccsds);
+        while ((bytes_read = fread(payload_buffer, 1, chunk, input_file)) > 0) {
+            ccsds_put_packet(&ccsds, CCSDS_APID, payload_buffer, bytes_read, output_file);
+            packet_count++;
         }
+        ccsds_flush(&ccsds, output_file);
 
-        // Step B: Encode the AX.25 frame with FX.25 FEC
-        int fx25_len = fx25_encode_frame(encoder, ax25_buffer, ax25_len, fx25_buffer);
-        if (fx25_len == 0) {
-            fprintf(stderr, "Warning: Failed to FEC-encode packet %d\n", packet_count);
-            continue;
-        }
+        fclose(input_file);
+        fclose(output_file);
+        fx25_cleanup(encoder);
 
-        // Step C: Write the final, robust frame to the output in KISS format
-        write_kiss_frame(output_file, fx25_buffer, fx25_len);
+        printf("Successfully created %d space packet(s) in %ld CCSDS frame(s) (RS interleave depth %d).\n",
+               packet_count, ccsds.frames_written, ccsds_depth);
+        printf("Output written to %s\n", output_filename);
+        return 0;
+    }
 
-        packet_count++;
+    // --- 3b. Low-Latency Voice Mode ---
+    if (air_bps) {
+        printf("  Voice stream: %.0f bit/s link, %.0f ms deadline\n", air_bps, deadline_ms);
+        int status = run_voice_stream(encoder, dest_addr, src_addr, input_file,
+                                      live_voice ? fileno(stdin) : -1, output_file,
+                                      source_bps, air_bps, deadline_ms / 1e3);
+        if (!live_voice) fclose(input_file);
+        fclose(output_file);
+        fx25_cleanup(encoder);
+        if (status == 0) printf("Output written to %s\n", output_filename);
+        return status;
+    }
+
+    // WHY: Without a schedule, frames are sent back to back from the start of
+    // the elevation profile, each costing its SF12/125 kHz/CR4-5 airtime.
+    const pass_window_t default_lora = { .sf = 12, .bw_khz = 125.0, .cr = 1 };
+    double t_frame = frame_airtime(fx25_onair_len(encoder), &default_lora);
+    double t_clock = feed ? feed_start_time(feed) : 0.0;
+    int code = select_fx25_code(feed, t_clock);
+
+    // WHY: Reading in chunks is memory-efficient and crucial for embedded systems.
+    // We avoid loading the entire file into RAM.
+    while ((bytes_read = fread(payload_buffer, 1, frame_chunk_size(encoder, feed, code), input_file)) > 0) {
+        if (packetize_payload(encoder, code, dest_addr, src_addr, payload_buffer, bytes_read, output_file) == 0) {
+            fprintf(stderr, "Warning: Failed to packetize packet %d\n", packet_count);
+        } else {
+            packet_count++;
+        }
+        t_clock += t_frame;
+        code = select_fx25_code(feed, t_clock);
     }
 
     // --- 4. Cleanup ---
@@ -332,6 +1919,7 @@ int main(int argc, char* argv[]) {
     // memory leaks or unclosed file handles can lead to system failure.
     fclose(input_file);
     fclose(output_file);
+    if (feed) feed_close(feed);
     fx25_cleanup(encoder);
 
     printf("Successfully created %d packet(s).\n", packet_count);
@@ -339,3 +1927,5 @@ int main(int argc, char* argv[]) {
 
     return 0;
 }
+
+#endif // PACKETIZER_LIBRARY
@@ -0,0 +1,291 @@
+/**
+ * @file uplink_encoder.c
+ * @brief Ground encoder for authenticated uplink command frames.
+ *
+ * Builds the compact command frames that lora_depacket.ino verifies: a 1-byte
+ * opcode, a varint sequence number, up to 8 argument bytes and a truncated
+ * SipHash-2-4 tag. The frame format and the MAC live in one header,
+ * "ttc 25 testing/uplink_command.h", compiled into both the sketch and this
+ * tool, so the two ends cannot drift apart.
+ *
+ * WHY THIS STRUCTURE:
+ * - Shared Code: The packetizer is built in with PACKETIZER_LIBRARY defined
+ * for lora_packet_toa(), so the reported airtime uses the same formula as the
+ * scheduler and adcs_skissue.py.
+ * - Sequence Numbers: The operator passes every command's sequence number
+ * with -q and must increase it each time; this tool stores nothing. The
+ * spacecraft rejects anything not newer, so each frame works exactly once.
+ * - Key Header: The sketch's key comes from uplink_key.h, written from the
+ * same key file with -H and kept out of git, so no key is ever committed.
+ *
+ * Compile with:
+ * gcc -O2 -Wall uplink_encoder.c -o uplink_encoder -lfec -lm
+ *
+ * Run with:
+ * ./uplink_encoder -k key.hex -q seq [-o frame.bin] <opcode> [args_hex]
+ * ./uplink_encoder -k key.hex -q last_seq -v <frame_hex>
+ * ./uplink_encoder -k key.hex -H "../ttc 25 testing/uplink_key.h"
+ * ./uplink_encoder -b
+ *
+ * Options:
+ * -k   Key file holding the 128-bit key as 32 hex digits.
+ * -q   Sequence number of the command (with -v: the last accepted one).
+ * -o   Also write the frame as binary, ready to hand to the LoRa radio.
+ * -v   Verify a frame instead of building one.
+ * -H   Write the key as the uplink_key.h header for lora_depacket.ino.
+ * -b   Measure verification time and compare command airtime.
+ *
+ * Opcodes: ping, arm (argument: 2-byte pass number), end, kill, or a number.
+ */
+
+#define PACKETIZER_LIBRARY
+#include "satellite_packetizer.c"
+#include "../ttc 25 testing/uplink_command.h"
+
+// =============================================================================
+// Constants
+// =============================================================================
+
+#define BENCH_VERIFY_ROUNDS 1000000
+#define UPLINK_SF 12          // Smallest-airtime comparison at the beacon settings
+#define UPLINK_BW_KHZ 125.0
+#define UPLINK_CR 1
+#define LEGACY_UL_BYTES 51    // ul_bytes assumed by beacon_optimiser()
+
+static const struct {
+    const char* name;
+    uint8_t opcode;
+} UPLINK_OPCODES[] = {
+    { "ping", UPLINK_OP_PING },
+    { "arm",  UPLINK_OP_ARM_RATES },
+    { "end",  UPLINK_OP_END_UPLINK },
+    { "kill", UPLINK_OP_KILL },
+};
+
+
+// =============================================================================
+// Helper Functions
+// =============================================================================
+
+/**
+ * @brief Parses a string of hex digit pairs.
+ * @return The number of bytes, or -1 if the string is not hex or too long.
+ */
+int parse_hex(const char* hex, uint8_t* out, int max_len) {
+    int len = strlen(hex);
+    if (len % 2 != 0 || len / 2 > max_len) return -1;
+    for (int i = 0; i < len / 2; i++) {
+        unsigned int byte;
+        if (sscanf(hex + 2 * i, "%2x", &byte) != 1) return -1;
+        out[i] = byte;
+    }
+    return len / 2;
+}
+
+/**
+ * @brief Reads a 128-bit key written as 32 hex digits.
+ * @return 0 on success, -1 on error.
+ */
+int read_key_file(const char* filename, uint8_t* key) {
+    FILE* f = fopen(filename, "r");
+    if (!f) {
+        perror("Error opening key file");
+        return -1;
+    }
+    char hex[2 * UPLINK_KEY_LEN + 2];
+    int ok = fscanf(f, "%33s", hex) == 1 && parse_hex(hex, key, UPLINK_KEY_LEN) == UPLINK_KEY_LEN;
+    fclose(f);
+    if (!ok) {
+        fprintf(stderr, "Error: %s must hold the key as %d hex digits\n", filename, 2 * UPLINK_KEY_LEN);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Looks up an opcode by name or number.
+ * @return The opcode, or -1 if unknown.
+ */
+int parse_opcode(const char* text) {
+    for (size_t i = 0; i < sizeof(UPLINK_OPCODES) / sizeof(UPLINK_OPCODES[0]); i++) {
+        if (strcmp(text, UPLINK_OPCODES[i].name) == 0) return UPLINK_OPCODES[i].opcode;
+    }
+    char* end;
+    long value = strtol(text, &end, 0);
+    return (*end == '\0' && value >= 0 && value <= 0xFF) ? (int)value : -1;
+}
+
+/**
+ * @brief Writes the key as the C header included by lora_depacket.ino.
+ * @return 0 on success, -1 on error.
+ */
+int write_key_header(const char* filename, const uint8_t* key) {
+    FILE* f = fopen(filename, "w");
+    if (!f) {
+        perror("Error creating key header");
+        return -1;
+    }
+    fprintf(f, "// Uplink key -- generated by uplink_encoder -H from the ground key file.\n");
+    fprintf(f, "// Secret: never commit this file (it is git-ignored).\n");
+    fprintf(f, "#ifndef UPLINK_KEY_H\n#define UPLINK_KEY_H\n\n");
+    fprintf(f, "const uint8_t UPLINK_KEY[UPLINK_KEY_LEN] = {");
+    for (int i = 0; i < UPLINK_KEY_LEN; i++) {
+        fprintf(f, "%s%s0x%02X", i ? "," : "", (i % 8 == 0) ? "\n  " : " ", key[i]);
+    }
+    fprintf(f, "\n};\n\n#endif\n");
+    fclose(f);
+    return 0;
+}
+
+void print_frame_airtime(int length) {
+    printf("Airtime at SF%d/%g kHz/CR4/%d: %.0f ms (a %d-byte uplink takes %.0f ms)\n",
+           UPLINK_SF, UPLINK_BW_KHZ, UPLINK_CR + 4,
+           1e3 * lora_packet_toa(length, UPLINK_SF, UPLINK_BW_KHZ, UPLINK_CR),
+           LEGACY_UL_BYTES, 1e3 * lora_packet_toa(LEGACY_UL_BYTES, UPLINK_SF, UPLINK_BW_KHZ, UPLINK_CR));
+}
+
+
+// =============================================================================
+// Benchmark Module
+// =============================================================================
+
+/**
+ * @brief Times uplink_verify() and lists command airtime by frame length.
+ * @return 0 on success.
+ */
+int run_uplink_benchmark(void) {
+    uint8_t key[UPLINK_KEY_LEN], frame[UPLINK_MAX_FRAME];
+    for (int i = 0; i < UPLINK_KEY_LEN; i++) key[i] = i * 17 + 3;
+    uplink_command_t cmd = { .opcode = UPLINK_OP_ARM_RATES, .seq = 1000, .n_args = 2, .args = { 0, 42 } };
+    int length = uplink_encode(&cmd, key, frame);
+
+    uplink_command_t out;
+    volatile int accepted = 0;
+    double t0 = now_seconds();
+    for (int i = 0; i < BENCH_VERIFY_ROUNDS; i++) {
+        frame[length - 1] ^= (i & 1); // Alternate valid and forged frames
+        accepted += uplink_verify(frame, length, key, 999, &out) == UPLINK_OK;
+        frame[length - 1] ^= (i & 1);
+    }
+    double dt = now_seconds() - t0;
+    printf("\n  uplink_verify(): %d-byte frame, %d-byte tag, %.0f ns per frame (%d of %d accepted)\n",
+           length, UPLINK_TAG_LEN, dt / BENCH_VERIFY_ROUNDS * 1e9, accepted, BENCH_VERIFY_ROUNDS);
+
+    printf("\n  %-28s %6s %10s\n", "Uplink", "Bytes", "SF12 ToA");
+    const struct { const char* label; int bytes; } rows[] = {
+        { "ping / end / kill", 1 + 1 + UPLINK_TAG_LEN },
+        { "arm pass (2 args)", 1 + 2 + 2 + UPLINK_TAG_LEN },
+        { "largest command", UPLINK_MAX_FRAME },
+        { "beacon_optimiser() default", LEGACY_UL_BYTES },
+    };
+    for (size_t i = 0; i < sizeof(rows) / sizeof(rows[0]); i++) {
+        printf("  %-28s %6d %8.0f ms\n", rows[i].label, rows[i].bytes,
+               1e3 * lora_packet_toa(rows[i].bytes, UPLINK_SF, UPLINK_BW_KHZ, UPLINK_CR));
+    }
+    return 0;
+}
+
+
+// =============================================================================
+// Main Application
+// =============================================================================
+
+void print_uplink_usage(const char* prog) {
+    fprintf(stderr, "Usage: %s -k key.hex -q seq [-o frame.bin] <opcode> [args_hex]\n"
+                    "       %s -k key.hex -q last_seq -v <frame_hex>\n"
+                    "       %s -k key.hex -H uplink_key.h\n"
+                    "       %s -b\n", prog, prog, prog, prog);
+}
+
+int main(int argc, char* argv[]) {
+    // --- 1. Argument Parsing ---
+    const char* key_filename = NULL;
+    const char* output_filename = NULL;
+    const char* header_filename = NULL;
+    long long seq = -1;
+    int verify = 0, benchmark = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "k:q:o:H:vb")) != -1) {
+        switch (opt) {
+        case 'k': key_filename = optarg; break;
+        case 'q': seq = atoll(optarg); break;
+        case 'o': output_filename = optarg; break;
+        case 'H': header_filename = optarg; break;
+        case 'v': verify = 1; break;
+        case 'b': benchmark = 1; break;
+        default:
+            print_uplink_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (benchmark) {
+        return run_uplink_benchmark();
+    }
+    if (header_filename && key_filename) {
+        uint8_t key[UPLINK_KEY_LEN];
+        if (read_key_file(key_filename, key) != 0 || write_key_header(header_filename, key) != 0) {
+            return 1;
+        }
+        printf("Key header written to %s\n", header_filename);
+        return 0;
+    }
+    if (!key_filename || seq < 0 || seq > UINT32_MAX || argc - optind < 1) {
+        print_uplink_usage(argv[0]);
+        return 1;
+    }
+    uint8_t key[UPLINK_KEY_LEN];
+    if (read_key_file(key_filename, key) != 0) {
+        return 1;
+    }
+
+    // --- 2. Verify a Received Frame ---
+    uplink_command_t cmd;
+    uint8_t frame[UPLINK_MAX_FRAME];
+    if (verify) {
+        int length = parse_hex(argv[optind], frame, UPLINK_MAX_FRAME);
+        int status = (length < 0) ? UPLINK_ERR_FORMAT : uplink_verify(frame, length, key, (uint32_t)seq, &cmd);
+        switch (status) {
+        case UPLINK_OK:
+            printf("Valid: opcode 0x%02X, sequence %u, %d argument byte(s)\n", cmd.opcode, cmd.seq, cmd.n_args);
+            return 0;
+        case UPLINK_ERR_TAG:    printf("Rejected: tag mismatch\n"); break;
+        case UPLINK_ERR_REPLAY: printf("Rejected: sequence number not newer than %lld\n", seq); break;
+        default:                printf("Rejected: malformed frame\n"); break;
+        }
+        return 1;
+    }
+
+    // --- 3. Build a Command Frame ---
+    int opcode = parse_opcode(argv[optind]);
+    if (opcode < 0) {
+        fprintf(stderr, "Error: Unknown opcode \"%s\"\n", argv[optind]);
+        return 1;
+    }
+    cmd.opcode = opcode;
+    cmd.seq = (uint32_t)seq;
+    cmd.n_args = 0;
+    if (argc - optind > 1) {
+        int n_args = parse_hex(argv[optind + 1], cmd.args, UPLINK_MAX_ARGS);
+        if (n_args < 0) {
+            fprintf(stderr, "Error: Arguments must be at most %d bytes of hex\n", UPLINK_MAX_ARGS);
+            return 1;
+        }
+        cmd.n_args = n_args;
+    }
+    int length = uplink_encode(&cmd, key, frame);
+    for (int i = 0; i < length; i++) printf("%02X", frame[i]);
+    printf("\n%d bytes. ", length);
+    print_frame_airtime(length);
+
+    if (output_filename) {
+        FILE* output_file = fopen(output_filename, "wb");
+        if (!output_file) {
+            perror("Error creating output file");
+            return 1;
+        }
+        fwrite(frame, 1, length, output_file);
+        fclose(output_file);
+        printf("Frame written to %s\n", output_filename);
+    }
+    return 0;
+}
@@ -0,0 +1,633 @@
+/**
+ * @file viterbi_decoder.c
+ * @brief Ground-station decoder for the convolutional inner code (packetizer -V).
+ *
+ * Reads the KISS stream of a -V downlink, runs a soft-decision Viterbi decoder
+ * over every frame and writes the recovered FX.25 frames (or CCSDS CADUs) as a
+ * KISS stream for the Reed-Solomon stage.
+ *
+ * WHY THIS STRUCTURE:
+ * - Shared Code: The packetizer is built in with PACKETIZER_LIBRARY defined,
+ * so the code polynomials, KISS framing and encoder are the same on both ends.
+ * - Vectorized ACS: The add-compare-select step updates all 64 trellis states
+ * at once with 8-bit saturating path metrics (2 AVX2 registers, 4 SSE2/NEON
+ * registers), which is what keeps a single core well above the link rate.
+ * - Scalar Reference: A portable decoder with identical arithmetic is always
+ * built. It is used where no SIMD unit is available and cross-checks the SIMD
+ * path in the benchmark.
+ *
+ * Compile with:
+ * gcc -O3 -march=native -Wall viterbi_decoder.c -o viterbi_decoder -lfec -lm
+ *
+ * Run with:
+ * ./viterbi_decoder [-S] <input_kiss_file> <output_kiss_file>
+ * ./viterbi_decoder -b
+ *
+ * Options:
+ * -S   Input frames carry one soft symbol per byte (0 = confident 0,
+ *      255 = confident 1, 128 = no information) instead of packed hard bits.
+ * -b   Benchmark decoder throughput and BER versus Eb/N0 on an AWGN channel.
+ */
+
+#define PACKETIZER_LIBRARY
+#include "satellite_packetizer.c"
+
+#include <math.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VITERBI_SIMD "AVX2"
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define VITERBI_SIMD "SSE2"
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define VITERBI_SIMD "NEON"
+#endif
+
+// =============================================================================
+// Constants
+// =============================================================================
+
+#define VITERBI_STATES 64
+#define VITERBI_START_METRIC 100 // Initial handicap of every state but 0
+#define VITERBI_RENORM 150       // Rescale once state 0's path metric passes this
+#define SOFT_ERASURE 128         // Soft symbol carrying no information
+
+// WHY: Branch metrics are 0..63, so a path metric grows by at most 63 per
+// step; rescaling above 150 keeps the best path clear of the 255 saturation.
+
+#define MAX_DECODED_FRAME (4 + CCSDS_MAX_DEPTH * CCSDS_RS_N)      // One CADU
+#define MAX_CODED_FRAME CONV_ENCODED_LEN(MAX_DECODED_FRAME)
+#define MAX_SYMBOLS (8 * MAX_CODED_FRAME)
+
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief Decoder tables and the survivor memory for one frame.
+ * WHY: Butterfly i joins old states i and i+32 to new states 2i and 2i+1. Both
+ * generators tap the oldest and newest bit, so its four branches only use one
+ * symbol pair and its complement; the tables hold that pair for input 0.
+ */
+typedef struct {
+    uint8_t branch_g1[VITERBI_STATES / 2];
+    uint8_t branch_g2[VITERBI_STATES / 2];
+    uint64_t* decisions; // Bit s of step t: state s was reached from the upper state
+    int max_steps;
+} viterbi_t;
+
+
+// =============================================================================
+// Viterbi Module
+// =============================================================================
+
+/**
+ * @brief Cleans up the decoder resources.
+ */
+void viterbi_cleanup(viterbi_t* v) {
+    if (v) {
+        free(v->decisions);
+        free(v);
+    }
+}
+
+/**
+ * @brief Allocates a decoder for frames of up to max_bytes decoded bytes.
+ * @return A pointer to the decoder, or NULL on failure.
+ */
+viterbi_t* viterbi_init(int max_bytes) {
+    viterbi_t* v = calloc(1, sizeof(viterbi_t));
+    if (!v) {
+        return NULL;
+    }
+    v->max_steps = 8 * max_bytes + CONV_TAIL_BITS;
+    v->decisions = malloc(v->max_steps * sizeof(uint64_t));
+    if (!v->decisions) {
+        viterbi_cleanup(v);
+        return NULL;
+    }
+    for (int i = 0; i < VITERBI_STATES / 2; i++) {
+        int sr = i << 1; // Old state i, input bit 0
+        v->branch_g1[i] = __builtin_parity(sr & CONV_POLY_G1) ? 255 : 0;
+        v->branch_g2[i] = __builtin_parity(sr & CONV_POLY_G2) ? 0 : 255;
+    }
+    return v;
+}
+
+/**
+ * @brief Path metrics at the start of a frame: the encoder is in state 0.
+ */
+void viterbi_start_metrics(uint8_t* metric) {
+    memset(metric, VITERBI_START_METRIC, VITERBI_STATES);
+    metric[0] = 0;
+}
+
+/**
+ * @brief Portable add-compare-select over the whole frame.
+ * Branch metric: the mean distance of the two soft symbols from the expected
+ * ones, scaled to 0..63. Path metrics are 8-bit and saturate.
+ */
+void viterbi_forward_scalar(viterbi_t* v, const uint8_t* symbols, int n_steps) {
+    uint8_t metric[VITERBI_STATES], next[VITERBI_STATES];
+    viterbi_start_metrics(metric);
+
+    for (int t = 0; t < n_steps; t++) {
+        uint8_t s0 = symbols[2 * t], s1 = symbols[2 * t + 1];
+        uint32_t dec_even = 0, dec_odd = 0;
+        for (int i = 0; i < VITERBI_STATES / 2; i++) {
+            int bm = ((v->branch_g1[i] ^ s0) + (v->branch_g2[i] ^ s1) + 1) >> 3;
+            int mbm = 63 - bm;
+            int a = metric[i] + bm, b = metric[i + 32] + mbm;
+            a = (a > 255) ? 255 : a;
+            b = (b > 255) ? 255 : b;
+            next[2 * i] = (b < a) ? b : a;
+            dec_even |= (uint32_t)(b < a) << i;
+
+            a = metric[i] + mbm;
+            b = metric[i + 32] + bm;
+            a = (a > 255) ? 255 : a;
+            b = (b > 255) ? 255 : b;
+            next[2 * i + 1] = (b < a) ? b : a;
+            dec_odd |= (uint32_t)(b < a) << i;
+        }
+        v->decisions[t] = dec_even | ((uint64_t)dec_odd << 32);
+
+        if (next[0] > VITERBI_RENORM) {
+            uint8_t min = next[0];
+            for (int s = 1; s < VITERBI_STATES; s++) {
+                if (next[s] < min) min = next[s];
+            }
+            for (int s = 0; s < VITERBI_STATES; s++) {
+                next[s] -= min;
+            }
+        }
+        memcpy(metric, next, sizeof(metric));
+    }
+}
+
+#if defined(__AVX2__)
+/**
+ * @brief AVX2 add-compare-select: 32 butterflies per instruction.
+ * Register m0 holds states 0-31 and m1 states 32-63.
+ */
+void viterbi_forward_simd(viterbi_t* v, const uint8_t* symbols, int n_steps) {
+    const __m256i g1 = _mm256_loadu_si256((const __m256i*)v->branch_g1);
+    const __m256i g2 = _mm256_loadu_si256((const __m256i*)v->branch_g2);
+    const __m256i low6 = _mm256_set1_epi8(0x3F);
+    const __m256i max_bm = _mm256_set1_epi8(63);
+    uint8_t start[VITERBI_STATES];
+    viterbi_start_metrics(start);
+    __m256i m0 = _mm256_loadu_si256((const __m256i*)start);
+    __m256i m1 = _mm256_loadu_si256((const __m256i*)(start + 32));
+
+    for (int t = 0; t < n_steps; t++) {
+        __m256i s0 = _mm256_set1_epi8(symbols[2 * t]);
+        __m256i s1 = _mm256_set1_epi8(symbols[2 * t + 1]);
+        // WHY: There is no 8-bit shift; shift 16-bit lanes and mask the spill.
+        __m256i bm = _mm256_avg_epu8(_mm256_xor_si256(g1, s0), _mm256_xor_si256(g2, s1));
+        bm = _mm256_and_si256(_mm256_srli_epi16(bm, 2), low6);
+        __m256i mbm = _mm256_sub_epi8(max_bm, bm);
+
+        __m256i a = _mm256_adds_epu8(m0, bm);
+        __m256i even = _mm256_min_epu8(a, _mm256_adds_epu8(m1, mbm));
+        uint32_t dec_even = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(even, a));
+        a = _mm256_adds_epu8(m0, mbm);
+        __m256i odd = _mm256_min_epu8(a, _mm256_adds_epu8(m1, bm));
+        uint32_t dec_odd = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(odd, a));
+        v->decisions[t] = dec_even | ((uint64_t)dec_odd << 32);
+
+        // New state 2i is even[i], 2i+1 is odd[i]; unpack works per 128-bit lane.
+        __m256i lo = _mm256_unpacklo_epi8(even, odd);
+        __m256i hi = _mm256_unpackhi_epi8(even, odd);
+        m0 = _mm256_permute2x128_si256(lo, hi, 0x20);
+        m1 = _mm256_permute2x128_si256(lo, hi, 0x31);
+
+        if ((_mm_cvtsi128_si32(_mm256_castsi256_si128(m0)) & 0xFF) > VITERBI_RENORM) {
+            __m256i m = _mm256_min_epu8(m0, m1);
+            __m128i x = _mm_min_epu8(_mm256_castsi256_si128(m), _mm256_extracti128_si256(m, 1));
+            x = _mm_min_epu8(x, _mm_srli_si128(x, 8));
+            x = _mm_min_epu8(x, _mm_srli_si128(x, 4));
+            x = _mm_min_epu8(x, _mm_srli_si128(x, 2));
+            x = _mm_min_epu8(x, _mm_srli_si128(x, 1));
+            __m256i min = _mm256_broadcastb_epi8(x);
+            m0 = _mm256_subs_epu8(m0, min);
+            m1 = _mm256_subs_epu8(m1, min);
+        }
+    }
+}
+
+#elif defined(__SSE2__)
+/**
+ * @brief SSE2 butterflies for 16 consecutive old-state pairs.
+ */
+static inline void acs_sse2(__m128i m_upper, __m128i m_lower, __m128i bm, __m128i mbm,
+                            __m128i* even, __m128i* odd, uint32_t* dec_even, uint32_t* dec_odd) {
+    __m128i a = _mm_adds_epu8(m_upper, bm);
+    *even = _mm_min_epu8(a, _mm_adds_epu8(m_lower, mbm));
+    *dec_even = ~_mm_movemask_epi8(_mm_cmpeq_epi8(*even, a)) & 0xFFFF;
+    a = _mm_adds_epu8(m_upper, mbm);
+    *odd = _mm_min_epu8(a, _mm_adds_epu8(m_lower, bm));
+    *dec_odd = ~_mm_movemask_epi8(_mm_cmpeq_epi8(*odd, a)) & 0xFFFF;
+}
+
+/**
+ * @brief SSE2 add-compare-select: m[k] holds states 16k..16k+15.
+ */
+void viterbi_forward_simd(viterbi_t* v, const uint8_t* symbols, int n_steps) {
+    __m128i g1[2], g2[2], m[4];
+    uint8_t start[VITERBI_STATES];
+    viterbi_start_metrics(start);
+    for (int k = 0; k < 2; k++) {
+        g1[k] = _mm_loadu_si128((const __m128i*)(v->branch_g1 + 16 * k));
+        g2[k] = _mm_loadu_si128((const __m128i*)(v->branch_g2 + 16 * k));
+    }
+    for (int k = 0; k < 4; k++) {
+        m[k] = _mm_loadu_si128((const __m128i*)(start + 16 * k));
+    }
+    const __m128i low6 = _mm_set1_epi8(0x3F);
+    const __m128i max_bm = _mm_set1_epi8(63);
+
+    for (int t = 0; t < n_steps; t++) {
+        __m128i s0 = _mm_set1_epi8(symbols[2 * t]);
+        __m128i s1 = _mm_set1_epi8(symbols[2 * t + 1]);
+        __m128i even[2], odd[2];
+        uint32_t de[2], dd[2];
+        for (int k = 0; k < 2; k++) {
+            __m128i bm = _mm_avg_epu8(_mm_xor_si128(g1[k], s0), _mm_xor_si128(g2[k], s1));
+            bm = _mm_and_si128(_mm_srli_epi16(bm, 2), low6);
+            acs_sse2(m[k], m[k + 2], bm, _mm_sub_epi8(max_bm, bm), &even[k], &odd[k], &de[k], &dd[k]);
+        }
+        v->decisions[t] = (de[0] | (de[1] << 16)) | ((uint64_t)(dd[0] | (dd[1] << 16)) << 32);
+        for (int k = 0; k < 2; k++) {
+            m[2 * k] = _mm_unpacklo_epi8(even[k], odd[k]);
+            m[2 * k + 1] = _mm_unpackhi_epi8(even[k], odd[k]);
+        }
+
+        if ((_mm_cvtsi128_si32(m[0]) & 0xFF) > VITERBI_RENORM) {
+            __m128i x = _mm_min_epu8(_mm_min_epu8(m[0], m[1]), _mm_min_epu8(m[2], m[3]));
+            x = _mm_min_epu8(x, _mm_srli_si128(x, 8));
+            x = _mm_min_epu8(x, _mm_srli_si128(x, 4));
+            x = _mm_min_epu8(x, _mm_srli_si128(x, 2));
+            x = _mm_min_epu8(x, _mm_srli_si128(x, 1));
+            __m128i min = _mm_set1_epi8(_mm_cvtsi128_si32(x) & 0xFF);
+            for (int k = 0; k < 4; k++) {
+                m[k] = _mm_subs_epu8(m[k], min);
+            }
+        }
+    }
+}
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+/**
+ * @brief Packs the top bit of every byte lane into a 16-bit mask.
+ */
+static inline uint32_t neon_movemask(uint8x16_t mask) {
+    static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t bits = vandq_u8(mask, vld1q_u8(weights));
+    return vaddv_u8(vget_low_u8(bits)) | ((uint32_t)vaddv_u8(vget_high_u8(bits)) << 8);
+}
+
+/**
+ * @brief NEON add-compare-select: m[k] holds states 16k..16k+15.
+ */
+void viterbi_forward_simd(viterbi_t* v, const uint8_t* symbols, int n_steps) {
+    uint8x16_t g1[2], g2[2], m[4];
+    uint8_t start[VITERBI_STATES];
+    viterbi_start_metrics(start);
+    for (int k = 0; k < 2; k++) {
+        g1[k] = vld1q_u8(v->branch_g1 + 16 * k);
+        g2[k] = vld1q_u8(v->branch_g2 + 16 * k);
+    }
+    for (int k = 0; k < 4; k++) {
+        m[k] = vld1q_u8(start + 16 * k);
+    }
+    const uint8x16_t max_bm = vdupq_n_u8(63);
+
+    for (int t = 0; t < n_steps; t++) {
+        uint8x16_t s0 = vdupq_n_u8(symbols[2 * t]);
+        uint8x16_t s1 = vdupq_n_u8(symbols[2 * t + 1]);
+        uint32_t de[2], dd[2];
+        uint8x16x2_t next[2];
+        for (int k = 0; k < 2; k++) {
+            uint8x16_t bm = vshrq_n_u8(vrhaddq_u8(veorq_u8(g1[k], s0), veorq_u8(g2[k], s1)), 2);
+            uint8x16_t mbm = vsubq_u8(max_bm, bm);
+            uint8x16_t a = vqaddq_u8(m[k], bm), b = vqaddq_u8(m[k + 2], mbm);
+            uint8x16_t even = vminq_u8(a, b);
+            de[k] = neon_movemask(vcltq_u8(b, a));
+            a = vqaddq_u8(m[k], mbm);
+            b = vqaddq_u8(m[k + 2], bm);
+            uint8x16_t odd = vminq_u8(a, b);
+            dd[k] = neon_movemask(vcltq_u8(b, a));
+            next[k] = vzipq_u8(even, odd);
+        }
+        v->decisions[t] = (de[0] | (de[1] << 16)) | ((uint64_t)(dd[0] | (dd[1] << 16)) << 32);
+        for (int k = 0; k < 2; k++) {
+            m[2 * k] = next[k].val[0];
+            m[2 * k + 1] = next[k].val[1];
+        }
+
+        if (vgetq_lane_u8(m[0], 0) > VITERBI_RENORM) {
+            uint8x16_t min = vdupq_n_u8(vminvq_u8(vminq_u8(vminq_u8(m[0], m[1]), vminq_u8(m[2], m[3]))));
+            for (int k = 0; k < 4; k++) {
+                m[k] = vqsubq_u8(m[k], min);
+            }
+        }
+    }
+}
+
+#else
+void viterbi_forward_simd(viterbi_t* v, const uint8_t* symbols, int n_steps) {
+    viterbi_forward_scalar(v, symbols, n_steps);
+}
+#endif
+
+/**
+ * @brief Follows the survivor path back from state 0 and packs the data bits.
+ */
+void viterbi_traceback(const viterbi_t* v, int n_steps, uint8_t* out) {
+    int n_bits = n_steps - CONV_TAIL_BITS;
+    int state = 0; // The tail bits drive the encoder back to state 0
+    memset(out, 0, n_bits / 8);
+    for (int t = n_steps - 1; t >= 0; t--) {
+        int from_upper = (v->decisions[t] >> (32 * (state & 1) + (state >> 1))) & 1;
+        if (t < n_bits) {
+            out[t >> 3] |= (state & 1) << (7 - (t & 7));
+        }
+        state = (state >> 1) | (from_upper << 5);
+    }
+}
+
+/**
+ * @brief Decodes one terminated frame of soft symbols.
+ * @param symbols Two soft symbols (G1, G2) per trellis step; trailing padding
+ * symbols are ignored.
+ * @param use_simd 0 forces the scalar decoder.
+ * @return The decoded length in bytes, or -1 if the frame is too short or too long.
+ */
+int viterbi_decode(viterbi_t* v, const uint8_t* symbols, int n_symbols, uint8_t* out, int use_simd) {
+    int length = (n_symbols / 2 - CONV_TAIL_BITS) / 8;
+    int n_steps = 8 * length + CONV_TAIL_BITS;
+    if (length <= 0 || n_steps > v->max_steps) {
+        return -1;
+    }
+    if (use_simd) {
+        viterbi_forward_simd(v, symbols, n_steps);
+    } else {
+        viterbi_forward_scalar(v, symbols, n_steps);
+    }
+    viterbi_traceback(v, n_steps, out);
+    return length;
+}
+
+/**
+ * @brief Expands packed hard bits into soft symbols (0 or 255).
+ */
+void hard_to_soft(const uint8_t* packed, int n_bytes, uint8_t* symbols) {
+    for (int i = 0; i < 8 * n_bytes; i++) {
+        symbols[i] = ((packed[i >> 3] >> (7 - (i & 7))) & 1) ? 255 : 0;
+    }
+}
+
+/**
+ * @brief Counts channel symbols that disagree with the re-encoded decoder output.
+ * WHY: The count of corrected symbols is the cheapest channel-quality
+ * estimate the ground station gets for free from every frame.
+ */
+int count_symbol_errors(const uint8_t* symbols, const uint8_t* decoded, int length) {
+    uint8_t coded[MAX_CODED_FRAME];
+    conv_encode(decoded, length, coded);
+    int errors = 0;
+    for (int i = 0; i < 2 * (8 * length + CONV_TAIL_BITS); i++) {
+        int bit = (coded[i >> 3] >> (7 - (i & 7))) & 1;
+        errors += bit != (symbols[i] >= SOFT_ERASURE);
+    }
+    return errors;
+}
+
+
+// =============================================================================
+// Benchmark Module
+// =============================================================================
+
+#define BENCH_FRAME_LEN (8 + FX25_N) // One FX.25 frame (tag + codeword)
+#define BENCH_FRAMES 400
+#define SOFT_SCALE 32.0              // Soft units per unit of BPSK amplitude
+
+/**
+ * @brief xorshift64* generator; rand() is far too slow to feed the noise model.
+ */
+static uint64_t bench_rng = 0x9E3779B97F4A7C15ULL;
+
+double bench_uniform(void) {
+    bench_rng ^= bench_rng >> 12;
+    bench_rng ^= bench_rng << 25;
+    bench_rng ^= bench_rng >> 27;
+    return ((bench_rng * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double bench_gaussian(void) {
+    double u = bench_uniform();
+    return sqrt(-2.0 * log(u > 0.0 ? u : 1e-300)) * cos(2.0 * M_PI * bench_uniform());
+}
+
+/**
+ * @brief Sends coded frames over BPSK/AWGN and quantizes the receiver output.
+ * @param ebn0_db Eb/N0 per information bit (the code rate is 1/2).
+ */
+void bench_channel(const uint8_t* coded, int coded_len, double ebn0_db, uint8_t* symbols) {
+    double sigma = sqrt(1.0 / pow(10.0, ebn0_db / 10.0)); // Es/N0 = Eb/N0 / 2
+    for (int i = 0; i < 8 * coded_len; i++) {
+        double x = ((coded[i >> 3] >> (7 - (i & 7))) & 1) ? 1.0 : -1.0;
+        double soft = SOFT_ERASURE + SOFT_SCALE * (x + sigma * bench_gaussian());
+        symbols[i] = (soft < 0.0) ? 0 : (soft > 255.0) ? 255 : (uint8_t)lrint(soft);
+    }
+}
+
+int count_bit_errors(const uint8_t* a, const uint8_t* b, int length) {
+    int errors = 0;
+    for (int i = 0; i < length; i++) {
+        errors += __builtin_popcount(a[i] ^ b[i]);
+    }
+    return errors;
+}
+
+/**
+ * @brief Measures decoder throughput (scalar and SIMD) and BER versus Eb/N0.
+ * @return 0 on success, 1 on error.
+ */
+int run_viterbi_benchmark(void) {
+    const int coded_len = CONV_ENCODED_LEN(BENCH_FRAME_LEN);
+    const int n_symbols = 8 * coded_len;
+    uint8_t* data = malloc(BENCH_FRAMES * BENCH_FRAME_LEN);
+    uint8_t* symbols = malloc((size_t)BENCH_FRAMES * n_symbols);
+    uint8_t* hard = malloc(n_symbols);
+    uint8_t decoded[2][BENCH_FRAME_LEN];
+    uint8_t coded[MAX_CODED_FRAME];
+    viterbi_t* v = viterbi_init(BENCH_FRAME_LEN);
+    if (!data || !symbols || !hard || !v) {
+        free(data);
+        free(symbols);
+        free(hard);
+        viterbi_cleanup(v);
+        return 1;
+    }
+    for (int i = 0; i < BENCH_FRAMES * BENCH_FRAME_LEN; i++) {
+        data[i] = bench_uniform() * 256.0;
+    }
+
+    // --- Throughput at an operating point where the decoder is busy ---
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        conv_encode(data + f * BENCH_FRAME_LEN, BENCH_FRAME_LEN, coded);
+        bench_channel(coded, coded_len, 3.0, symbols + (size_t)f * n_symbols);
+    }
+    printf("\n  %-22s %10s %12s\n", "Decoder", "Mbit/s", "Frames/s");
+    int mismatches = 0;
+    for (int use_simd = 0; use_simd <= 1; use_simd++) {
+        int rounds = use_simd ? 20 : 4;
+        double t0 = now_seconds();
+        for (int r = 0; r < rounds; r++) {
+            for (int f = 0; f < BENCH_FRAMES; f++) {
+                viterbi_decode(v, symbols + (size_t)f * n_symbols, n_symbols, decoded[use_simd], use_simd);
+            }
+        }
+        double dt = now_seconds() - t0;
+        double frames = (double)rounds * BENCH_FRAMES;
+#ifdef VITERBI_SIMD
+        const char* name = use_simd ? VITERBI_SIMD : "scalar";
+#else
+        const char* name = use_simd ? "scalar (no SIMD build)" : "scalar";
+#endif
+        printf("  %-22s %10.1f %12.0f\n", name, frames * 8 * BENCH_FRAME_LEN / dt / 1e6, frames / dt);
+    }
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        const uint8_t* s = symbols + (size_t)f * n_symbols;
+        viterbi_decode(v, s, n_symbols, decoded[0], 0);
+        viterbi_decode(v, s, n_symbols, decoded[1], 1);
+        mismatches += memcmp(decoded[0], decoded[1], BENCH_FRAME_LEN) != 0;
+    }
+    printf("  SIMD vs scalar output: %s\n", mismatches ? "MISMATCH" : "identical");
+
+    // --- BER versus Eb/N0 ---
+    printf("\n  %8s %12s %12s %12s %10s\n", "Eb/N0", "Uncoded", "Hard VA", "Soft VA", "Soft FER");
+    for (double ebn0 = 0.0; ebn0 <= 7.0; ebn0 += 1.0) {
+        long hard_errors = 0, soft_errors = 0, frame_errors = 0;
+        for (int f = 0; f < BENCH_FRAMES; f++) {
+            const uint8_t* frame = data + f * BENCH_FRAME_LEN;
+            conv_encode(frame, BENCH_FRAME_LEN, coded);
+            bench_channel(coded, coded_len, ebn0, symbols);
+            for (int i = 0; i < n_symbols; i++) {
+                hard[i] = (symbols[i] >= SOFT_ERASURE) ? 255 : 0;
+            }
+            viterbi_decode(v, symbols, n_symbols, decoded[1], 1);
+            int errors = count_bit_errors(frame, decoded[1], BENCH_FRAME_LEN);
+            soft_errors += errors;
+            frame_errors += errors > 0;
+            viterbi_decode(v, hard, n_symbols, decoded[1], 1);
+            hard_errors += count_bit_errors(frame, decoded[1], BENCH_FRAME_LEN);
+        }
+        double n_bits = 8.0 * BENCH_FRAME_LEN * BENCH_FRAMES;
+        double uncoded = 0.5 * erfc(sqrt(pow(10.0, ebn0 / 10.0)));
+        printf("  %6.1fdB %12.2e %12.2e %12.2e %10.3f\n", ebn0, uncoded,
+               hard_errors / n_bits, soft_errors / n_bits, (double)frame_errors / BENCH_FRAMES);
+    }
+    printf("  (%d frames of %d bytes per point, BPSK/AWGN, 8-bit soft symbols)\n",
+           BENCH_FRAMES, BENCH_FRAME_LEN);
+
+    free(data);
+    free(symbols);
+    free(hard);
+    viterbi_cleanup(v);
+    return mismatches ? 1 : 0;
+}
+
+
+// =============================================================================
+// Main Application
+// =============================================================================
+
+void print_viterbi_usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [-S] <input_kiss_file> <output_kiss_file>\n"
+                    "       %s -b\n", prog, prog);
+}
+
+int main(int argc, char* argv[]) {
+    // --- 1. Argument Parsing ---
+    int soft_input = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "Sb")) != -1) {
+        switch (opt) {
+        case 'S': soft_input = 1; break;
+        case 'b': return run_viterbi_benchmark();
+        default:
+            print_viterbi_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (argc - optind < 2) {
+        print_viterbi_usage(argv[0]);
+        return 1;
+    }
+    const char* input_filename = argv[optind];
+    const char* output_filename = argv[optind + 1];
+
+    // --- 2. Initialization ---
+    viterbi_t* v = viterbi_init(MAX_DECODED_FRAME);
+    if (!v) {
+        fprintf(stderr, "Error: Failed to initialize Viterbi decoder.\n");
+        return 1;
+    }
+    FILE* input_file = fopen(input_filename, "rb");
+    if (!input_file) {
+        perror("Error opening input file");
+        viterbi_cleanup(v);
+        return 1;
+    }
+    FILE* output_file = fopen(output_filename, "wb");
+    if (!output_file) {
+        perror("Error creating output file");
+        fclose(input_file);
+        viterbi_cleanup(v);
+        return 1;
+    }
+
+    // --- 3. Decode Loop ---
+    static uint8_t frame[MAX_SYMBOLS];
+    static uint8_t symbols[MAX_SYMBOLS];
+    uint8_t decoded[MAX_DECODED_FRAME];
+    int frame_count = 0, skipped = 0;
+    long symbol_count = 0, symbol_errors = 0;
+    int length;
+    while ((length = read_kiss_frame(input_file, frame, soft_input ? MAX_SYMBOLS : MAX_CODED_FRAME)) >= 0) {
+        int n_symbols = soft_input ? length : 8 * length;
+        const uint8_t* s = frame;
+        if (!soft_input) {
+            hard_to_soft(frame, length, symbols);
+            s = symbols;
+        }
+        int decoded_len = viterbi_decode(v, s, n_symbols, decoded, 1);
+        if (decoded_len <= 0) {
+            fprintf(stderr, "Warning: Skipping %d-byte frame %d\n", length, frame_count + skipped);
+            skipped++;
+            continue;
+        }
+        write_kiss_frame(output_file, decoded, decoded_len);
+        symbol_errors += count_symbol_errors(s, decoded, decoded_len);
+        symbol_count += 2 * (8 * decoded_len + CONV_TAIL_BITS);
+        frame_count++;
+    }
+
+    // --- 4. Cleanup ---
+    fclose(input_file);
+    fclose(output_file);
+    viterbi_cleanup(v);
+
+    printf("Decoded %d frame(s)", frame_count);
+    if (skipped) printf(", skipped %d", skipped);
+    printf("; %ld of %ld channel symbols corrected (BER ~%.1e)\n", symbol_errors, symbol_count,
+           symbol_count ? (double)symbol_errors / symbol_count : 0.0);
+    printf("Output written to %s\n", output_filename);
+    return 0;
+}
@@ -33,9 +33,43 @@ Assumptions / limitations:
 
 Dependency : numpy only   ->   pip install numpy
 Run         : python cubesat_propagator.py
+Schedule    : python cubesat_propagator.py --schedule passes.csv [--ic N]
+              (writes the pass schedule read by the packetizer's -s option)
+Profile     : python cubesat_propagator.py --profile margin.csv [--ic N]
+              (writes the elevation / link-margin profile for its -e option)
+Rates       : python cubesat_propagator.py --rate-schedule rates.csv
+                  --rate-header "ttc 25 testing/lora_rate_schedule.h" [--ic N]
+              (per-pass SF/BW/CR switching schedule for both LoRa sketches)
+Replay      : python cubesat_propagator.py --replay downlink.kiss [--replay-csv replay.csv]
+              (bytes of a packetizer output delivered per pass, all five ICs)
+Doppler     : python cubesat_propagator.py --doppler doppler.csv [--doppler-rate HZ] [--ic N]
+              python cubesat_propagator.py --rigctld localhost:4532 [--start ...]
+              (1-10 Hz Doppler table per pass / live tuning through rigctld;
+               --rigctld-stub runs a stand-in rigctld; also works with --tle)
+Rotor       : python cubesat_propagator.py --rotctld localhost:4533 [--rotor-rate HZ] [--start ...]
+              (steers the antenna over the passes; --rotctld-stub simulates a
+               rotor; can run together with --rigctld; also works with --tle)
+Beacon      : python cubesat_propagator.py --beacon-sweep [--beacon-csv sweep.csv] [--ic N]
+              (Pareto front of uplink bytes / hit probability / energy over
+               every SF, BW, CR, payload size and guard time)
+TLE         : python cubesat_propagator.py --tle amateur.txt [--start 2026-03-24T00:00] [--days N]
+                  [--stations stations.csv] [--contacts contacts.csv] [--workers N]
+              (SGP4 contacts of every satellite in a TLE file with every ground
+               station; build sgp4_kernel.c as sgp4_kernel.so next to this
+               script for the fast path)
 ================================================================================
 """
 
+import argparse
+import concurrent.futures
+import ctypes
+import datetime
+import math
+import os
+import socket
+import threading
+import time
+
 import numpy as np
 
 
@@ -304,8 +338,8 @@ def elevation_azimuth_range(sat, gs):
       4. elevation = arcsin(up / |delta|)
       5. azimuth   = arctan2(east, north)  -- 0 = North, increases clockwise.
 
-    The ENU frame uses the epoch GS longitude (a valid approximation within
-    any single pass lasting a few minutes).
+    The ENU frame is built at the GS's own ECI longitude, taken from gs, so
+    it turns with the Earth (gs_enu_series() for arrays of times).
 
     ENU unit vectors in ECI:
       e_hat = [-sin(lon),  cos(lon),  0]
@@ -327,7 +361,7 @@ def elevation_azimuth_range(sat, gs):
     rng_m = float(np.linalg.norm(delta))
 
     lat = GS_LAT
-    lon = GS_LON
+    lon = np.arctan2(gs[1], gs[0])
 
     e_hat = np.array([-np.sin(lon),
                        np.cos(lon),
@@ -387,25 +421,279 @@ def doppler_shift_hz(t, ic):
     return -FREQ * vr / C_LIGHT               # Doppler shift [Hz]
 
 
+def sat_eci_series(t, ic):
+    """
+    Satellite ECI positions for an array of times.
+
+    Same model as sat_eci_at_t(), with the rotations of keplerian_to_eci()
+    written out so that every time is propagated in one numpy expression.
+
+    Returns
+    -------
+    np.ndarray, shape (3, len(t))
+        Satellite ECI positions [m].
+    """
+    h_m   = ic["h_km"] * 1e3
+    omega = 2.0 * PI / orbital_period(h_m)
+    u     = np.radians(ic["aop_deg"] + ic["ta_deg"]) + omega * t
+    inc   = np.radians(ic["inc_deg"])
+    raan  = np.radians(ic["raan_deg"])
+
+    # Rz(-RAAN).T @ Rx(-inc).T applied to the perifocal position (r cos u, r sin u, 0)
+    r = R_E + h_m
+    x_p, y_p = r * np.cos(u), r * np.sin(u)
+    y_i, z_i = np.cos(inc) * y_p, -np.sin(inc) * y_p
+    return np.stack([np.cos(raan) * x_p - np.sin(raan) * y_i,
+                     np.sin(raan) * x_p + np.cos(raan) * y_i,
+                     z_i])
+
+
+def gs_eci_series(t):
+    """Ground station ECI positions for an array of times, as gs_eci_at_t()."""
+    lon = GS_LON + OMEGA_E * t
+    r   = R_E + GS_ALT_M
+    return r * np.stack([np.cos(GS_LAT) * np.cos(lon),
+                         np.cos(GS_LAT) * np.sin(lon),
+                         np.full_like(lon, np.sin(GS_LAT))])
+
+
+def gs_enu_series(t):
+    """
+    ENU unit vectors of the GS in ECI for an array of times, as in
+    elevation_azimuth_range(), at the ECI longitude GS_LON + OMEGA_E * t.
+
+    Returns
+    -------
+    e_hat, n_hat, u_hat : np.ndarray, each (3, len(t))
+    """
+    lon = GS_LON + OMEGA_E * t
+    e_hat = np.stack([-np.sin(lon), np.cos(lon), np.zeros_like(lon)])
+    n_hat = np.stack([-np.sin(GS_LAT) * np.cos(lon),
+                      -np.sin(GS_LAT) * np.sin(lon),
+                      np.full_like(lon, np.cos(GS_LAT))])
+    u_hat = np.stack([ np.cos(GS_LAT) * np.cos(lon),
+                       np.cos(GS_LAT) * np.sin(lon),
+                       np.full_like(lon, np.sin(GS_LAT))])
+    return e_hat, n_hat, u_hat
+
+
+def elevation_series(t, ic):
+    """
+    Elevation of the satellite over the GS for an array of times.
+
+    Same model as sat_eci_at_t(), gs_eci_at_t() and elevation_azimuth_range(),
+    evaluated for all times at once.
+
+    Parameters
+    ----------
+    t  : np.ndarray  times from epoch [s]
+    ic : dict        one entry from INITIAL_CONDITIONS
+
+    Returns
+    -------
+    np.ndarray
+        Elevation [deg].
+    """
+    t     = np.asarray(t, dtype=float)
+    delta = sat_eci_series(t, ic) - gs_eci_series(t)
+    up    = np.sum(gs_enu_series(t)[2] * delta, axis=0)
+    return np.degrees(np.arcsin(np.clip(up / np.linalg.norm(delta, axis=0), -1.0, 1.0)))
+
+
+def look_angles_series(t, ic):
+    """
+    Elevation, azimuth, slant range and Doppler shift for an array of times.
+
+    Vectorised elevation_azimuth_range() and doppler_shift_hz(): the same
+    rotating ENU frame and the same 0.5 s finite-difference velocity.
+
+    Returns
+    -------
+    el_deg, az_deg, rng_m, doppler_hz : np.ndarray
+    """
+    t     = np.asarray(t, dtype=float)
+    sat   = sat_eci_series(t, ic)
+    delta = sat - gs_eci_series(t)
+    rng_m = np.linalg.norm(delta, axis=0)
+
+    east, north, up = (np.sum(axis * delta, axis=0) for axis in gs_enu_series(t))
+    el_deg = np.degrees(np.arcsin(np.clip(up / rng_m, -1.0, 1.0)))
+    az_deg = np.degrees(np.arctan2(east, north) % (2.0 * PI))
+
+    v_sat = (sat_eci_series(t + 0.5, ic) - sat) / 0.5
+    vr    = np.sum(v_sat * delta, axis=0) / rng_m     # positive = receding
+    return el_deg, az_deg, rng_m, -FREQ * vr / C_LIGHT
+
+
 # ==============================================================================
 # SECTION 6 -- PASS FINDER
 # ==============================================================================
 
+PASS_TOL_S = 1e-3    # AOS / LOS / peak time accuracy of find_passes    [s]
+GRAZE_RATE_DEG_S = 0.5  # Bound on the elevation rate below MIN_ELEV for orbits
+                        # above 200 km (slant range > 1100 km)        [deg/s]
+
+
+def refine_crossings(elev, rows, lo, hi, rising):
+    """
+    Bisect brackets [lo, hi] down to the time the elevation crosses
+    MIN_ELEV_DEG, all brackets at once.
+
+    elev   : callable  elev(rows, t) -> elevation [deg], elementwise
+    rows   : np.ndarray  satellite of each bracket (passed through to elev)
+    rising : bool  True for AOS brackets (below at lo, above at hi),
+                   False for LOS brackets (above at lo, below at hi)
+    """
+    lo, hi = np.array(lo, dtype=float), np.array(hi, dtype=float)
+    if lo.size == 0:
+        return lo
+    n_iter = int(np.ceil(np.log2(max(np.max(hi - lo), PASS_TOL_S) / PASS_TOL_S)))
+    for _ in range(n_iter):
+        mid   = 0.5 * (lo + hi)
+        after = (elev(rows, mid) >= MIN_ELEV_DEG) == rising
+        hi    = np.where(after, mid, hi)
+        lo    = np.where(after, lo, mid)
+    return 0.5 * (lo + hi)
+
+
+def refine_peaks(elev, rows, lo, hi):
+    """
+    Bisect brackets [lo, hi] that each hold one elevation maximum down to the
+    time of the maximum, on the sign of the elevation slope.
+    """
+    lo, hi = np.array(lo, dtype=float), np.array(hi, dtype=float)
+    if lo.size == 0:
+        return lo
+    h      = 0.25 * PASS_TOL_S
+    n_iter = int(np.ceil(np.log2(max(np.max(hi - lo), PASS_TOL_S) / PASS_TOL_S)))
+    both   = np.concatenate([rows, rows])
+    for _ in range(n_iter):
+        mid    = 0.5 * (lo + hi)
+        el     = elev(both, np.concatenate([mid - h, mid + h]))
+        rising = el[lo.size:] > el[:lo.size]
+        lo     = np.where(rising, mid, lo)
+        hi     = np.where(rising, hi, mid)
+    return 0.5 * (lo + hi)
+
+
+def find_pass_edges(t, el, elev):
+    """
+    AOS, LOS and peak times of every pass in a coarse elevation sweep.
+
+    Algorithm:
+      1. Every run of samples above MIN_ELEV is a pass.  A local maximum
+         below MIN_ELEV may still hide a short pass between two samples, so
+         its peak is refined too and kept if it clears MIN_ELEV.
+      2. Bisect the peak of every pass, then AOS between the last sample
+         below and the peak, and LOS between the peak and the first sample
+         below, to PASS_TOL_S.
+    A pass already in progress at t[0] starts there; one still in progress
+    at t[-1] is dropped.
+
+    Parameters
+    ----------
+    t    : np.ndarray (n_t,)          sweep times [s]
+    el   : np.ndarray (n_sat, n_t)    elevation at the sweep times [deg]
+    elev : callable  elev(rows, t) -> elevation [deg] of satellite rows[i]
+           at t[i]
+
+    Returns
+    -------
+    rows, aos, los, t_peak : np.ndarray, one entry per pass, ordered by
+    satellite and then by AOS
+    """
+    n_t   = len(t)
+    above = el >= MIN_ELEV_DEG
+
+    # Runs of samples above MIN_ELEV: padding with "below" on both sides pairs
+    # every rise with the set of the same run, row by row
+    step        = np.diff(np.pad(above, ((0, 0), (1, 1))).astype(np.int8), axis=1)
+    rows, first = np.nonzero(step == 1)
+    last        = np.nonzero(step == -1)[1] - 1
+    closed      = last < n_t - 1
+    rows, first, last = rows[closed], first[closed], last[closed]
+    peak = np.array([f + np.argmax(el[r, f:l + 1]) for r, f, l in zip(rows, first, last)],
+                    dtype=int)
+
+    # Local maxima below MIN_ELEV: passes shorter than one sweep step.  The
+    # peak is within one step of the sample, so lower maxima cannot clear it.
+    mid = el[:, 1:-1]
+    dt  = t[1] - t[0] if n_t > 1 else 0.0
+    g_rows, g = np.nonzero((mid >= el[:, :-2]) & (mid > el[:, 2:]) & ~above[:, 1:-1]
+                           & (mid >= MIN_ELEV_DEG - GRAZE_RATE_DEG_S * dt))
+    g += 1
+
+    n_runs = len(rows)
+    rows   = np.concatenate([rows, g_rows])
+    t_peak = refine_peaks(elev, rows, t[np.maximum(np.concatenate([peak, g]) - 1, 0)],
+                          t[np.minimum(np.concatenate([peak, g]) + 1, n_t - 1)])
+    keep   = np.concatenate([np.ones(n_runs, dtype=bool),
+                             elev(g_rows, t_peak[n_runs:]) >= MIN_ELEV_DEG])
+    rows, t_peak = rows[keep], t_peak[keep]
+    first  = np.concatenate([first, g[keep[n_runs:]]])
+    last   = np.concatenate([last, g[keep[n_runs:]]])
+
+    at_start = (first == 0) & above[rows, 0]
+    aos = refine_crossings(elev, rows, t[np.maximum(first - 1, 0)], t_peak, rising=True)
+    aos = np.where(at_start, t[0], aos)
+    los = refine_crossings(elev, rows, t_peak, t[last + 1], rising=False)
+
+    order = np.lexsort((aos, rows))
+    return rows[order], aos[order], los[order], t_peak[order]
+
+
+def pass_records(rows, aos, los, t_peak, dt_s, look, day0_s=0.0):
+    """
+    Build the pass records of find_passes() from the pass edges.
+
+    The look angles of all profile samples and pass edges of all passes come
+    from a single look(rows, t) -> (el_deg, az_deg, rng_m, doppler_hz) call.
+    day0_s is the time of midnight on day 1.
+    """
+    t_prof = [np.arange(a, b, dt_s) for a, b in zip(aos, los)]
+    n_prof = [len(tp) for tp in t_prof]
+    n      = len(aos)
+    t_all  = np.concatenate(t_prof + [aos, los, t_peak])
+    r_all  = np.concatenate([np.repeat(rows, n_prof), rows, rows, rows])
+    el_all, az_all, rng_all, dop_all = look(r_all, t_all)
+    m       = sum(n_prof)
+    az_edge = az_all[m:]
+    el_peak = el_all[m + 2 * n:]
+
+    passes = []
+    offset = 0
+    for j in range(n):
+        sl = slice(offset, offset + n_prof[j])
+        offset = sl.stop
+        passes.append({
+            "start_s"   : float(aos[j]),
+            "end_s"     : float(los[j]),
+            "dur_s"     : float(los[j] - aos[j]),
+            "max_el_deg": float(el_peak[j]),
+            "az_rise"   : float(az_edge[j]),
+            "az_set"    : float(az_edge[n + j]),
+            "t_peak_s"  : float(t_peak[j]),
+            "day"       : int((aos[j] - day0_s) // 86400) + 1,
+            "profile"   : list(zip(t_all[sl].tolist(), el_all[sl].tolist(), az_all[sl].tolist(),
+                                   rng_all[sl].tolist(), dop_all[sl].tolist())),
+        })
+    return passes
+
+
 def find_passes(ic, sim_days=7, dt_s=10.0):
     """
     Find all satellite passes above MIN_ELEV_DEG over the Pilani GS.
 
-    Algorithm:
-      Step through time at dt_s intervals.  When elevation first exceeds
-      MIN_ELEV (AOS), begin recording the pass.  When it drops back below
-      MIN_ELEV (LOS), close and store the pass record.
-      Contacts shorter than 30 s are discarded as step-size artefacts.
+    The elevation is swept over the whole window at dt_s intervals as one
+    array (elevation_series), the pass edges and peaks are bisected from the
+    sweep (find_pass_edges), and the profiles are evaluated in one batch
+    (look_angles_series).
 
     Parameters
     ----------
     ic       : dict   one entry from INITIAL_CONDITIONS
     sim_days : int    number of days to simulate           (default 7)
-    dt_s     : float  propagation time step [s]            (default 10)
+    dt_s     : float  sweep and profile time step [s]      (default 10)
 
     Returns
     -------
@@ -419,60 +707,1382 @@ def find_passes(ic, sim_days=7, dt_s=10.0):
       t_peak_s   : epoch time of peak elevation           [s]
       day        : calendar day number (1-indexed)
       profile    : list of (t, el_deg, az_deg, range_m, doppler_hz)
-                   sampled at every dt_s step during the pass
-    """
-    T_MAX   = sim_days * 86400.0
-    passes  = []
-    in_pass = False
-    t_start = 0.0
-    max_el  = 0.0
-    t_peak  = 0.0
-    az_rise = 0.0
-    profile = []
-
-    for t in np.arange(0.0, T_MAX + dt_s, dt_s):
-        sat         = sat_eci_at_t(t, ic)
-        gs          = gs_eci_at_t(t)
-        el, az, rng = elevation_azimuth_range(sat, gs)
-
-        if el >= MIN_ELEV:
-            if not in_pass:
-                # --- AOS ---
-                in_pass = True
-                t_start = t
-                max_el  = el
-                t_peak  = t
-                az_rise = np.degrees(az)
-                profile = []
-            if el > max_el:
-                max_el = el
-                t_peak = t
-            dop = doppler_shift_hz(t, ic)
-            profile.append((t, np.degrees(el), np.degrees(az), rng, dop))
+                   sampled every dt_s from AOS
+    """
+    t     = np.arange(0.0, sim_days * 86400.0 + dt_s, dt_s)
+    el    = elevation_series(t, ic)[None, :]
+    edges = find_pass_edges(t, el, lambda rows, tt: elevation_series(tt, ic))
+    return pass_records(*edges, dt_s, lambda rows, tt: look_angles_series(tt, ic))
 
-        else:
-            if in_pass:
-                # --- LOS ---
-                in_pass = False
-                dur_s   = t - t_start
-                if dur_s > 30.0:
-                    az_set = profile[-1][2] if profile else 0.0
-                    passes.append({
-                        "start_s"   : t_start,
-                        "end_s"     : t - dt_s,
-                        "dur_s"     : dur_s,
-                        "max_el_deg": float(np.degrees(max_el)),
-                        "az_rise"   : az_rise,
-                        "az_set"    : az_set,
-                        "t_peak_s"  : t_peak,
-                        "day"       : int(t_start // 86400) + 1,
-                        "profile"   : profile,
-                    })
+
+# ==============================================================================
+# SECTION 7 -- TLE PROPAGATION  (SGP4)
+#
+# The Keplerian ICs above are for planning.  Live tracking of real spacecraft
+# uses their NORAD two-line elements and SGP4 (Hoots & Roehrich, Spacetrack
+# Report #3, as revised by Vallado et al. 2006, AIAA 2006-6753), which models
+# J2-J4 and drag.  Positions come out in the TEME frame and are rotated into
+# the Earth-fixed frame with the GMST angle; the GS is a WGS-84 point.
+#
+# Every satellite x every time is one numpy expression.  sgp4_kernel.c does
+# the same propagation in C and is used when it has been built:
+#
+#   gcc -O3 -shared -fPIC sgp4_kernel.c -o sgp4_kernel.so -lm
+#
+# Only near-Earth orbits (period < 225 min) are supported.  Deep-space
+# objects need SDP4 (lunar/solar terms and resonances) and are skipped.
+# ==============================================================================
+
+# WGS-72 constants: TLE mean elements are fitted with these, not with WGS-84
+SGP4_MU     = 398600.8         # [km^3/s^2]
+SGP4_RE_KM  = 6378.135         # [km]
+SGP4_XKE    = 60.0 / np.sqrt(SGP4_RE_KM**3 / SGP4_MU)    # [Earth radii^1.5 / min]
+SGP4_J2     = 0.001082616
+SGP4_J3     = -0.00000253881
+SGP4_J4     = -0.00000165597
+SGP4_J3OJ2  = SGP4_J3 / SGP4_J2
+SGP4_DEEP_SPACE_MIN = 225.0    # Orbital period from which SDP4 is needed   [min]
+
+WGS84_A_M = 6378137.0          # GS ellipsoid semi-major axis               [m]
+WGS84_F   = 1.0 / 298.257223563
+JD_J2000  = 2451545.0
+
+SGP4_KERNEL_PATH = os.path.join(os.path.dirname(os.path.abspath(__file__)), "sgp4_kernel.so")
+SGP4_CHUNK = 2_000_000         # Satellite x time samples per propagation call
+
+# Per-satellite coefficients from sgp4_init(), in the column order that
+# sgp4_kernel.c reads them
+SGP4_FIELDS = ("no", "ao", "ecco", "inclo", "mo", "argpo", "nodeo", "bstar",
+               "mdot", "argpdot", "nodedot", "nodecf", "cc1", "cc4", "cc5",
+               "t2cof", "t3cof", "t4cof", "t5cof", "d2", "d3", "d4",
+               "omgcof", "xmcof", "eta", "delmo", "sinmao",
+               "aycof", "xlcof", "con41", "x1mth2", "x7thm1")
+
+
+def jd_from_datetime(dt):
+    """Julian date of a naive UTC datetime."""
+    return JD_J2000 + (dt - datetime.datetime(2000, 1, 1, 12)).total_seconds() / 86400.0
+
+
+def datetime_from_jd(jd):
+    """Naive UTC datetime of a Julian date."""
+    return datetime.datetime(2000, 1, 1, 12) + datetime.timedelta(days=jd - JD_J2000)
+
+
+def utc_datetime(text=None):
+    """Naive UTC datetime of an ISO-8601 string (naive = UTC), or of now."""
+    dt = (datetime.datetime.fromisoformat(text) if text
+          else datetime.datetime.now(datetime.timezone.utc))
+    if dt.tzinfo is not None:
+        dt = dt.astimezone(datetime.timezone.utc).replace(tzinfo=None)
+    return dt
+
+
+def tle_checksum(line):
+    """Modulo-10 checksum of a TLE line: digits count their value, '-' counts 1."""
+    return sum(int(c) if c.isdigit() else (c == "-") for c in line[:68]) % 10
+
+
+def tle_exponent(field):
+    """Decodes the assumed-decimal TLE notation, e.g. ' 28098-4' -> 0.28098e-4."""
+    field = field.strip()
+    if not field:
+        return 0.0
+    sign = -1.0 if field[0] == "-" else 1.0
+    field = field.lstrip("+-")
+    return sign * float("0." + field[:-2]) * 10.0 ** int(field[-2:])
+
+
+def read_tle_file(path):
+    """
+    Read a file of two-line element sets, with or without name lines
+    (the CelesTrak 3-line format).
+
+    Returns
+    -------
+    list of dicts with keys
+      name, norad, epoch_jd, inc_deg, raan_deg, ecc, aop_deg, ma_deg,
+      n_rev_day, bstar
+    """
+    with open(path) as f:
+        lines = [ln.rstrip() for ln in f if ln.strip()]
+    tles = []
+    name = None
+    i = 0
+    while i < len(lines):
+        ln = lines[i]
+        if not (ln.startswith("1 ") and i + 1 < len(lines) and lines[i + 1].startswith("2 ")):
+            name = ln.strip()
+            i += 1
+            continue
+        l1, l2 = lines[i], lines[i + 1]
+        for k, l in ((i + 1, l1), (i + 2, l2)):
+            if len(l) < 69 or tle_checksum(l) != int(l[68]):
+                raise ValueError(f"{path}:{k}: bad TLE line (length or checksum)")
+        yy  = int(l1[18:20])
+        doy = float(l1[20:32])
+        year = 2000 + yy if yy < 57 else 1900 + yy
+        tles.append({
+            "name"     : name or l1[2:7].strip(),
+            "norad"    : int(l1[2:7]),
+            "epoch_jd" : jd_from_datetime(datetime.datetime(year, 1, 1)) + doy - 1.0,
+            "inc_deg"  : float(l2[8:16]),
+            "raan_deg" : float(l2[17:25]),
+            "ecc"      : float("0." + l2[26:33].strip()),
+            "aop_deg"  : float(l2[34:42]),
+            "ma_deg"   : float(l2[43:51]),
+            "n_rev_day": float(l2[52:63]),
+            "bstar"    : tle_exponent(l1[53:61]),
+        })
+        name = None
+        i += 2
+    return tles
+
+
+def sgp4_init(tles):
+    """
+    SGP4 initialisation (Vallado's sgp4init, near-Earth branch) for many
+    satellites at once.
+
+    Returns
+    -------
+    coef     : np.ndarray (n_sat, len(SGP4_FIELDS))  propagation coefficients
+    epoch_jd : np.ndarray (n_sat,)                   TLE epochs
+    deep     : np.ndarray (n_sat,) bool              period >= 225 min (needs SDP4)
+    """
+    def col(key, scale=1.0):
+        return np.array([tle[key] for tle in tles], dtype=float) * scale
+
+    deg   = PI / 180.0
+    ecco  = col("ecc")
+    inclo = col("inc_deg", deg)
+    nodeo = col("raan_deg", deg)
+    argpo = col("aop_deg", deg)
+    mo    = col("ma_deg", deg)
+    bstar = col("bstar")
+    no_kozai = col("n_rev_day", 2.0 * PI / 1440.0)        # [rad/min]
+
+    # --- initl: un-Kozai the mean motion ---
+    x2o3    = 2.0 / 3.0
+    eccsq   = ecco * ecco
+    omeosq  = 1.0 - eccsq
+    rteosq  = np.sqrt(omeosq)
+    cosio   = np.cos(inclo)
+    cosio2  = cosio * cosio
+    ak      = (SGP4_XKE / no_kozai) ** x2o3
+    d1      = 0.75 * SGP4_J2 * (3.0 * cosio2 - 1.0) / (rteosq * omeosq)
+    del_    = d1 / (ak * ak)
+    adel    = ak * (1.0 - del_ * del_ - del_ * (1.0 / 3.0 + 134.0 * del_ * del_ / 81.0))
+    del_    = d1 / (adel * adel)
+    no      = no_kozai / (1.0 + del_)
+    ao      = (SGP4_XKE / no) ** x2o3
+    sinio   = np.sin(inclo)
+    po      = ao * omeosq
+    con42   = 1.0 - 5.0 * cosio2
+    con41   = -con42 - cosio2 - cosio2
+    posq    = po * po
+    rp      = ao * (1.0 - ecco)
+
+    # --- drag: perigees below 156 km use a lower density reference s ---
+    isimp  = rp < 220.0 / SGP4_RE_KM + 1.0
+    perige = (rp - 1.0) * SGP4_RE_KM
+    sfour  = np.where(perige < 156.0, np.where(perige < 98.0, 20.0, perige - 78.0), 78.0)
+    qzms24 = ((120.0 - sfour) / SGP4_RE_KM) ** 4
+    sfour  = sfour / SGP4_RE_KM + 1.0
+
+    pinvsq = 1.0 / posq
+    tsi    = 1.0 / (ao - sfour)
+    eta    = ao * ecco * tsi
+    etasq  = eta * eta
+    eeta   = ecco * eta
+    psisq  = np.abs(1.0 - etasq)
+    coef   = qzms24 * tsi ** 4
+    coef1  = coef / psisq ** 3.5
+    cc2    = coef1 * no * (ao * (1.0 + 1.5 * etasq + eeta * (4.0 + etasq))
+                           + 0.375 * SGP4_J2 * tsi / psisq * con41
+                           * (8.0 + 3.0 * etasq * (8.0 + etasq)))
+    cc1    = bstar * cc2
+    with np.errstate(divide="ignore", invalid="ignore"):
+        cc3   = np.where(ecco > 1e-4, -2.0 * coef * tsi * SGP4_J3OJ2 * no * sinio / ecco, 0.0)
+        xmcof = np.where(ecco > 1e-4, -x2o3 * coef * bstar / eeta, 0.0)
+    x1mth2 = 1.0 - cosio2
+    cc4    = 2.0 * no * coef1 * ao * omeosq * (
+        eta * (2.0 + 0.5 * etasq) + ecco * (0.5 + 2.0 * etasq)
+        - SGP4_J2 * tsi / (ao * psisq) * (
+            -3.0 * con41 * (1.0 - 2.0 * eeta + etasq * (1.5 - 0.5 * eeta))
+            + 0.75 * x1mth2 * (2.0 * etasq - eeta * (1.0 + etasq)) * np.cos(2.0 * argpo)))
+    cc5    = 2.0 * coef1 * ao * omeosq * (1.0 + 2.75 * (etasq + eeta) + eeta * etasq)
+
+    # --- secular rates from J2 and J4 ---
+    cosio4  = cosio2 * cosio2
+    temp1   = 1.5 * SGP4_J2 * pinvsq * no
+    temp2   = 0.5 * temp1 * SGP4_J2 * pinvsq
+    temp3   = -0.46875 * SGP4_J4 * pinvsq * pinvsq * no
+    mdot    = (no + 0.5 * temp1 * rteosq * con41
+               + 0.0625 * temp2 * rteosq * (13.0 - 78.0 * cosio2 + 137.0 * cosio4))
+    argpdot = (-0.5 * temp1 * con42 + 0.0625 * temp2 * (7.0 - 114.0 * cosio2 + 395.0 * cosio4)
+               + temp3 * (3.0 - 36.0 * cosio2 + 49.0 * cosio4))
+    xhdot1  = -temp1 * cosio
+    nodedot = xhdot1 + (0.5 * temp2 * (4.0 - 19.0 * cosio2) + 2.0 * temp3 * (3.0 - 7.0 * cosio2)) * cosio
+    omgcof  = bstar * cc3 * np.cos(argpo)
+    nodecf  = 3.5 * omeosq * xhdot1 * cc1
+    t2cof   = 1.5 * cc1
+    xlcof   = -0.25 * SGP4_J3OJ2 * sinio * (3.0 + 5.0 * cosio) / np.where(
+        np.abs(cosio + 1.0) > 1.5e-12, 1.0 + cosio, 1.5e-12)
+    aycof   = -0.5 * SGP4_J3OJ2 * sinio
+    delmo   = (1.0 + eta * np.cos(mo)) ** 3
+    sinmao  = np.sin(mo)
+    x7thm1  = 7.0 * cosio2 - 1.0
+
+    # --- higher-order drag terms, left out for low perigees (isimp) ---
+    cc1sq = cc1 * cc1
+    d2    = 4.0 * ao * tsi * cc1sq
+    temp  = d2 * tsi * cc1 / 3.0
+    d3    = (17.0 * ao + sfour) * temp
+    d4    = 0.5 * temp * ao * tsi * (221.0 * ao + 31.0 * sfour) * cc1
+    t3cof = d2 + 2.0 * cc1sq
+    t4cof = 0.25 * (3.0 * d3 + cc1 * (12.0 * d2 + 10.0 * cc1sq))
+    t5cof = 0.2 * (3.0 * d4 + 12.0 * cc1 * d3 + 6.0 * d2 * d2 + 15.0 * cc1sq * (2.0 * d2 + cc1sq))
+    # WHY: With these zeroed the full propagation reduces exactly to the
+    # simplified one, so both cases share one code path.
+    full = ~isimp
+    d2, d3, d4, t3cof, t4cof, t5cof = (x * full for x in (d2, d3, d4, t3cof, t4cof, t5cof))
+    omgcof, xmcof, cc5 = omgcof * full, xmcof * full, cc5 * full
+
+    values = locals()
+    coef_table = np.stack([values[name] for name in SGP4_FIELDS], axis=1)
+    deep = 2.0 * PI / no >= SGP4_DEEP_SPACE_MIN
+    return coef_table, col("epoch_jd"), deep
+
+
+def sgp4_propagate_numpy(coef, tsince):
+    """
+    SGP4 propagation (Vallado's sgp4, near-Earth branch).
+
+    coef   : np.ndarray (n_sat, n_fields)  from sgp4_init()
+    tsince : np.ndarray (n_sat, n_t)       minutes from each TLE epoch
+
+    Returns r [km] and v [km/s] in TEME, each (3, n_sat, n_t).  Decayed or
+    invalid states are NaN.
+    """
+    c = dict(zip(SGP4_FIELDS, coef.T[:, :, None]))
+    t = tsince
+    twopi = 2.0 * PI
+
+    # --- secular gravity and drag ---
+    xmdf   = c["mo"] + c["mdot"] * t
+    argpdf = c["argpo"] + c["argpdot"] * t
+    nodedf = c["nodeo"] + c["nodedot"] * t
+    t2     = t * t
+    nodem  = nodedf + c["nodecf"] * t2
+    delomg = c["omgcof"] * t
+    delm   = c["xmcof"] * ((1.0 + c["eta"] * np.cos(xmdf)) ** 3 - c["delmo"])
+    mm     = xmdf + delomg + delm
+    argpm  = argpdf - delomg - delm
+    t3, t4 = t2 * t, t2 * t2
+    tempa  = 1.0 - c["cc1"] * t - c["d2"] * t2 - c["d3"] * t3 - c["d4"] * t4
+    tempe  = c["bstar"] * c["cc4"] * t + c["bstar"] * c["cc5"] * (np.sin(mm) - c["sinmao"])
+    templ  = c["t2cof"] * t2 + c["t3cof"] * t3 + t4 * (c["t4cof"] + t * c["t5cof"])
+
+    with np.errstate(invalid="ignore", divide="ignore"):
+        am  = c["ao"] * tempa * tempa
+        nm  = c["no"] / (tempa * tempa * tempa)     # = xke / am^1.5
+        em  = c["ecco"] - tempe
+        bad = (em >= 1.0) | (em < -0.001)
+        em  = np.maximum(em, 1e-6)
+        mm  = mm + c["no"] * templ
+        xlm = mm + argpm + nodem
+        nodem = np.fmod(nodem, twopi)
+        argpm = np.fmod(argpm, twopi)
+        xlm   = np.fmod(xlm, twopi)
+        mm    = np.fmod(xlm - argpm - nodem, twopi)
+
+        # --- long-period periodics ---
+        sinip, cosip = np.sin(c["inclo"]), np.cos(c["inclo"])
+        axnl = em * np.cos(argpm)
+        temp = 1.0 / (am * (1.0 - em * em))
+        aynl = em * np.sin(argpm) + temp * c["aycof"]
+        xl   = mm + argpm + nodem + temp * c["xlcof"] * axnl
+
+        # --- Kepler's equation ---
+        u   = np.fmod(xl - nodem, twopi)
+        eo1 = u
+        for _ in range(10):
+            sineo1, coseo1 = np.sin(eo1), np.cos(eo1)
+            tem5 = (u - aynl * coseo1 + axnl * sineo1 - eo1) / (1.0 - coseo1 * axnl - sineo1 * aynl)
+            eo1  = eo1 + np.clip(tem5, -0.95, 0.95)
+        sineo1, coseo1 = np.sin(eo1), np.cos(eo1)
+
+        # --- short-period periodics ---
+        ecose = axnl * coseo1 + aynl * sineo1
+        esine = axnl * sineo1 - aynl * coseo1
+        el2   = axnl * axnl + aynl * aynl
+        pl    = am * (1.0 - el2)
+        rl    = am * (1.0 - ecose)
+        rdotl = np.sqrt(am) * esine / rl
+        rvdotl = np.sqrt(pl) / rl
+        betal = np.sqrt(1.0 - el2)
+        temp  = esine / (1.0 + betal)
+        sinu  = am / rl * (sineo1 - aynl - axnl * temp)
+        cosu  = am / rl * (coseo1 - axnl + aynl * temp)
+        su    = np.arctan2(sinu, cosu)
+        sin2u = (cosu + cosu) * sinu
+        cos2u = 1.0 - 2.0 * sinu * sinu
+        temp  = 1.0 / pl
+        temp1 = 0.5 * SGP4_J2 * temp
+        temp2 = temp1 * temp
+
+        mrt   = (rl * (1.0 - 1.5 * temp2 * betal * c["con41"])
+                 + 0.5 * temp1 * c["x1mth2"] * cos2u)
+        su    = su - 0.25 * temp2 * c["x7thm1"] * sin2u
+        xnode = nodem + 1.5 * temp2 * cosip * sin2u
+        xinc  = c["inclo"] + 1.5 * temp2 * cosip * sinip * cos2u
+        mvt   = rdotl - nm * temp1 * c["x1mth2"] * sin2u / SGP4_XKE
+        rvdot = rvdotl + nm * temp1 * (c["x1mth2"] * cos2u + 1.5 * c["con41"]) / SGP4_XKE
+
+        # --- orientation ---
+        sinsu, cossu = np.sin(su), np.cos(su)
+        snod, cnod   = np.sin(xnode), np.cos(xnode)
+        sini, cosi   = np.sin(xinc), np.cos(xinc)
+        xmx, xmy = -snod * cosi, cnod * cosi
+        ux = np.stack([xmx * sinsu + cnod * cossu, xmy * sinsu + snod * cossu, sini * sinsu])
+        vx = np.stack([xmx * cossu - cnod * sinsu, xmy * cossu - snod * sinsu, sini * cossu])
+
+        bad = bad | (pl < 0.0) | (mrt < 1.0)
+        r = np.where(bad, np.nan, mrt * ux * SGP4_RE_KM)
+        v = np.where(bad, np.nan, (mvt * ux + rvdot * vx) * (SGP4_RE_KM * SGP4_XKE / 60.0))
+    return r, v
+
+
+SGP4_KERNEL = None
+
+
+def sgp4_kernel():
+    """The compiled sgp4_kernel.so, or None when it has not been built."""
+    global SGP4_KERNEL
+    if SGP4_KERNEL is None:
+        SGP4_KERNEL = False
+        if os.path.exists(SGP4_KERNEL_PATH):
+            lib  = ctypes.CDLL(SGP4_KERNEL_PATH)
+            dptr = np.ctypeslib.ndpointer(dtype=np.float64, flags="C_CONTIGUOUS")
+            lib.sgp4_propagate.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_int,
+                                           dptr, dptr, dptr, dptr]
+            lib.sgp4_propagate.restype  = None
+            lib.sgp4_num_fields.restype = ctypes.c_int
+            if lib.sgp4_num_fields() != len(SGP4_FIELDS):
+                raise RuntimeError(f"{SGP4_KERNEL_PATH} does not match SGP4_FIELDS; rebuild it")
+            SGP4_KERNEL = lib
+    return SGP4_KERNEL or None
+
+
+def sgp4_propagate(coef, tsince, use_kernel=True):
+    """
+    Propagate every satellite of coef to its row of tsince [min], with the
+    compiled kernel when available.  Returns r [km], v [km/s], each
+    (3, n_sat, n_t), in TEME.
+    """
+    kernel = sgp4_kernel() if use_kernel else None
+    if kernel is None:
+        return sgp4_propagate_numpy(coef, tsince)
+    coef   = np.ascontiguousarray(coef, dtype=np.float64)
+    tsince = np.ascontiguousarray(tsince, dtype=np.float64)
+    n_sat, n_t = tsince.shape
+    r = np.empty((3, n_sat, n_t))
+    v = np.empty((3, n_sat, n_t))
+    kernel.sgp4_propagate(n_sat, n_t, len(SGP4_FIELDS), coef, tsince, r, v)
+    return r, v
+
+
+def gmst_rad(jd_ut1):
+    """Greenwich mean sidereal time (IAU-82), as used with SGP4 and TEME."""
+    tut1 = (jd_ut1 - JD_J2000) / 36525.0
+    sec  = (-6.2e-6 * tut1**3 + 0.093104 * tut1**2
+            + (876600.0 * 3600.0 + 8640184.812866) * tut1 + 67310.54841)
+    return np.mod(np.radians(sec / 240.0), 2.0 * PI)
+
+
+def ground_station(lat_deg=GS_LAT_DEG, lon_deg=GS_LON_DEG, alt_m=GS_ALT_M, name="Pilani"):
+    """
+    WGS-84 Earth-fixed position [km] and local East/North/Up unit vectors of
+    a ground station.
+    """
+    lat, lon = np.radians(lat_deg), np.radians(lon_deg)
+    e2 = WGS84_F * (2.0 - WGS84_F)
+    n  = WGS84_A_M / np.sqrt(1.0 - e2 * np.sin(lat) ** 2)
+    pos = np.array([(n + alt_m) * np.cos(lat) * np.cos(lon),
+                    (n + alt_m) * np.cos(lat) * np.sin(lon),
+                    (n * (1.0 - e2) + alt_m) * np.sin(lat)]) / 1e3
+    return {
+        "name"   : name,
+        "ecef_km": pos,
+        "e_hat"  : np.array([-np.sin(lon), np.cos(lon), 0.0]),
+        "n_hat"  : np.array([-np.sin(lat) * np.cos(lon), -np.sin(lat) * np.sin(lon), np.cos(lat)]),
+        "u_hat"  : np.array([np.cos(lat) * np.cos(lon), np.cos(lat) * np.sin(lon), np.sin(lat)]),
+    }
+
+
+GS_VECTORS = ("ecef_km", "e_hat", "n_hat", "u_hat")
+
+
+def tle_ecef(coef, epoch_jd, start_jd, t, use_kernel=True):
+    """
+    Earth-fixed position [km] and velocity relative to the Earth [km/s] of
+    many satellites, each (3, n_sat, n_t), at t (n_sat, n_t) seconds from
+    start_jd.
+    """
+    tsince = (start_jd - epoch_jd)[:, None] * 1440.0 + t / 60.0
+    r, v   = sgp4_propagate(coef, tsince, use_kernel)
+    g      = gmst_rad(start_jd + t / 86400.0)
+    cg, sg = np.cos(g), np.sin(g)
+
+    # TEME -> Earth-fixed: rotate by GMST; the velocity also loses the
+    # Earth's rotation (omega x r)
+    x  = cg * r[0] + sg * r[1]
+    y  = -sg * r[0] + cg * r[1]
+    vx = cg * v[0] + sg * v[1] + OMEGA_E * y
+    vy = -sg * v[0] + cg * v[1] - OMEGA_E * x
+    return np.stack([x, y, r[2]]), np.stack([vx, vy, v[2]])
+
+
+def topocentric(pos, vel, ecef_km, e_hat, n_hat, u_hat):
+    """
+    Elevation [deg], azimuth [deg], slant range [m] and Doppler [Hz] of
+    Earth-fixed positions / velocities (3, ...) seen from a GS, whose
+    vectors (from ground_station()) broadcast against them.
+    """
+    d     = pos - ecef_km
+    rng   = np.sqrt(np.sum(d * d, axis=0))
+    up    = np.sum(u_hat * d, axis=0)
+    east  = np.sum(e_hat * d, axis=0)
+    north = np.sum(n_hat * d, axis=0)
+    el    = np.degrees(np.arcsin(np.clip(up / rng, -1.0, 1.0)))
+    az    = np.degrees(np.arctan2(east, north) % (2.0 * PI))
+    vr    = np.sum(d * vel, axis=0) / rng * 1e3          # [m/s], positive = receding
+    return el, az, rng * 1e3, -FREQ * vr / C_LIGHT
+
+
+def tle_look_angles(coef, epoch_jd, start_jd, t, gs, use_kernel=True):
+    """
+    Elevation, azimuth, slant range and Doppler of many satellites over a GS.
+
+    coef, epoch_jd : rows of sgp4_init() output, one per satellite
+    t              : np.ndarray (n_sat, n_t)  seconds from start_jd
+    gs             : dict from ground_station()
+
+    Returns el_deg, az_deg, rng_m, doppler_hz, each (n_sat, n_t).
+    """
+    pos, vel = tle_ecef(coef, epoch_jd, start_jd, t, use_kernel)
+    return topocentric(pos, vel, *(gs[k][:, None, None] for k in GS_VECTORS))
+
+
+# ==============================================================================
+# SECTION 8 -- CONTACT PLANNER  (many ground stations x many satellites)
+#
+# plan_contacts() finds every contact between a list of ground stations and
+# a TLE catalogue.  A satellite is out of sight of a given station most of
+# the time, so two cheap geometric bounds rule out whole spans of time
+# before the fine sweep:
+#
+#   1. Orbital plane: a satellite is only visible from stations within the
+#      coverage half-angle (coverage_half_angle) of its orbital plane.  The
+#      station leaves the plane no faster than the Earth rotates, so one
+#      sample every PLAN_PLANE_STEP_S decides the span to the next.
+#   2. Range cone: inside those spans the satellite must also be within the
+#      same angle of the station's zenith.  That angle changes no faster
+#      than the satellite's angular rate plus the Earth's, sampled every
+#      PLAN_CONE_STEP_S.
+#
+# A span is only dropped when its bound keeps the elevation below
+# MIN_ELEV_DEG throughout, so the contacts are those of a full sweep.
+# Satellites are shared out between worker processes.
+# ==============================================================================
+
+PLAN_PLANE_STEP_S  = 1800.0  # Orbital-plane test step                       [s]
+PLAN_CONE_STEP_S   = 300.0   # Range-cone test step                          [s]
+PLAN_MARGIN_DEG    = 1.0     # Slack on the coverage angle: short-period terms,
+                             # geodetic vs geocentric vertical              [deg]
+PLAN_ALT_MARGIN_KM = 50.0    # Slack on the apogee radius                    [km]
+
+
+def read_station_file(path):
+    """
+    Read a ground station list, one "name,lat_deg,lon_deg,alt_m" line per
+    station.  Blank lines, '#' comments and a header line starting with
+    "name" are skipped.
+
+    Returns
+    -------
+    list of ground_station() dicts
+    """
+    stations = []
+    with open(path) as f:
+        for k, ln in enumerate(f, 1):
+            ln = ln.split("#", 1)[0].strip()
+            if not ln or ln.lower().startswith("name"):
+                continue
+            fields = [x.strip() for x in ln.split(",")]
+            try:
+                lat, lon, alt = (float(x) for x in fields[1:])
+            except ValueError:
+                raise ValueError(f"{path}:{k}: expected name,lat_deg,lon_deg,alt_m") from None
+            if not -90.0 <= lat <= 90.0:
+                raise ValueError(f"{path}:{k}: latitude {lat} out of range")
+            stations.append(ground_station(lat, lon, alt, name=fields[0]))
+    if not stations:
+        raise ValueError(f"{path}: no ground stations")
+    return stations
+
+
+def coverage_half_angle(r_sat_km, r_gs_km):
+    """
+    Largest Earth-central angle [rad] between a station at radius r_gs_km and
+    a satellite at radius r_sat_km that is above MIN_ELEV_DEG, widened by
+    PLAN_MARGIN_DEG.  From the triangle Earth centre / station / satellite:
+    cos(el + lambda) = r_gs / r_sat * cos(el).
+    """
+    el = np.radians(MIN_ELEV_DEG - PLAN_MARGIN_DEG)
+    lam = np.arccos(np.clip(r_gs_km / r_sat_km * np.cos(el), -1.0, 1.0)) - el
+    return lam + np.radians(PLAN_MARGIN_DEG)
+
+
+def tle_ecef_samples(coef, epoch_jd, start_jd, rows, t, use_kernel=True):
+    """
+    tle_ecef() of satellite rows[i] at t[i] [s from start_jd], for scattered
+    samples.  Returns pos [km], vel [km/s], each (3, n).
+    """
+    pos  = np.empty((3, len(rows)))
+    vel  = np.empty((3, len(rows)))
+    step = max(1, SGP4_CHUNK // len(SGP4_FIELDS))    # Bounds the coef[rows] copy
+    for i0 in range(0, len(rows), step):
+        sl = slice(i0, i0 + step)
+        p, v = tle_ecef(coef[rows[sl]], epoch_jd[rows[sl]], start_jd, t[sl, None], use_kernel)
+        pos[:, sl], vel[:, sl] = p[..., 0], v[..., 0]
+    return pos, vel
+
+
+def contact_candidates(coef, epoch_jd, start_jd, n_t, dt_s, stations, use_kernel=True):
+    """
+    Samples of a fine sweep (n_t samples dt_s apart from start_jd) that the
+    orbital-plane and range-cone bounds cannot rule out.
+
+    For a bound f sampled every T with |df/dt| <= L, the minimum over a span
+    is at least (f[k] + f[k+1] - L * T) / 2.  The cone steps are a multiple
+    of dt_s and the plane steps a multiple of the cone steps, so every span
+    maps onto whole spans of the finer grid.
+
+    Returns
+    -------
+    need : np.ndarray (n_gs, n_sat, n_t) bool
+    """
+    n_gs, n_sat = len(stations), len(coef)
+    if n_t < 2:
+        return np.ones((n_gs, n_sat, n_t), dtype=bool)
+    col = {f: coef[:, i] for i, f in enumerate(SGP4_FIELDS)}
+
+    m2 = max(1, int(round(PLAN_CONE_STEP_S / dt_s)))
+    m1 = max(1, int(round(PLAN_PLANE_STEP_S / (m2 * dt_s))))
+    T2, T1 = m2 * dt_s, m1 * m2 * dt_s
+    n2 = -(-(n_t - 1) // m2)                  # Cone spans
+    n1 = -(-n2 // m1)                         # Plane spans
+
+    g_km  = np.stack([gs["ecef_km"] for gs in stations])                 # (n_gs, 3)
+    r_gs  = np.linalg.norm(g_km, axis=1)
+    g_hat = g_km / r_gs[:, None]
+    ecc   = col["ecco"]
+    r_max = col["ao"] * SGP4_RE_KM * (1.0 + ecc) + PLAN_ALT_MARGIN_KM
+    lam   = coverage_half_angle(r_max[None, :], r_gs[:, None])[..., None]  # (n_gs, n_sat, 1)
+
+    # --- 1. Orbital plane: angle of the station out of the plane, in TEME ---
+    t1     = np.arange(n1 + 1) * T1
+    tsince = (start_jd - epoch_jd)[:, None] * 1440.0 + t1 / 60.0
+    r, v   = sgp4_propagate(coef, tsince, use_kernel)
+    h      = np.cross(r, v, axis=0)
+    h     /= np.linalg.norm(h, axis=0)
+    gm     = gmst_rad(start_jd + t1 / 86400.0)
+    cg, sg = np.cos(gm), np.sin(gm)
+    g_teme = np.stack([cg * g_hat[:, 0, None] - sg * g_hat[:, 1, None],
+                       sg * g_hat[:, 0, None] + cg * g_hat[:, 1, None],
+                       np.broadcast_to(g_hat[:, 2, None], (n_gs, n1 + 1))])  # (3, n_gs, n1+1)
+    beta   = np.arcsin(np.abs(np.clip(np.sum(h[:, None] * g_teme[:, :, None], axis=0), -1.0, 1.0)))
+    rate1  = (OMEGA_E + np.abs(col["nodedot"]) / 60.0)[:, None]
+    keep1  = ~((beta[..., :-1] + beta[..., 1:] - rate1 * T1) / 2.0 > lam)  # NaN (decayed) is kept
+    keep1  = keep1[..., np.arange(n2) // m1]                                # On the cone spans
+
+    # --- 2. Range cone: angle of the satellite from the station's zenith ---
+    # Perigee angular rate of the orbit, and of the ground under it
+    rate2 = (col["no"] / 60.0 * np.sqrt((1.0 + ecc) / (1.0 - ecc) ** 3) * 1.05 + OMEGA_E)[:, None]
+    alive = np.any(keep1, axis=0)
+    pts   = np.zeros((n_sat, n2 + 1), dtype=bool)
+    pts[:, :-1] |= alive
+    pts[:, 1:]  |= alive
+    rows, ks = np.nonzero(pts)
+    pos, _   = tle_ecef_samples(coef, epoch_jd, start_jd, rows, ks * T2, use_kernel)
+    pos     /= np.linalg.norm(pos, axis=0)
+    theta    = np.full((n_gs, n_sat, n2 + 1), PI)
+    theta[:, rows, ks] = np.arccos(np.clip(g_hat @ pos, -1.0, 1.0))
+    keep2 = keep1 & ~((theta[..., :-1] + theta[..., 1:] - rate2 * T2) / 2.0 > lam)
+
+    # --- 3. Fine samples of the surviving spans, both ends included ---
+    i    = np.arange(n_t)
+    span = np.minimum(i // m2, n2 - 1)
+    need = keep2[..., span]
+    node = (i % m2 == 0) & (i > 0)
+    need[..., node] |= keep2[..., i[node] // m2 - 1]
+    return need
+
+
+def plan_chunk(job):
+    """
+    Contacts of one slice of the catalogue with every station: one worker's
+    share of plan_contacts().  Records are those of find_passes(), plus gs,
+    sat (index into the slice), name and norad.
+    """
+    tles, stations, start_jd, days, dt_s, use_kernel, prefilter = job
+    coef, epoch_jd, _ = sgp4_init(tles)
+    n_gs, n_sat = len(stations), len(tles)
+    t   = np.arange(0.0, days * 86400.0 + dt_s, dt_s)
+    vec = {k: np.stack([gs[k] for gs in stations], axis=1) for k in GS_VECTORS}  # (3, n_gs)
+
+    if prefilter:
+        need = contact_candidates(coef, epoch_jd, start_jd, len(t), dt_s, stations, use_kernel)
+    else:
+        need = np.ones((n_gs, n_sat, len(t)), dtype=bool)
+
+    # Each sample is propagated once and seen from every station; samples
+    # no station needs stay far below the horizon
+    rows, cols = np.nonzero(np.any(need, axis=0))
+    pos, vel   = tle_ecef_samples(coef, epoch_jd, start_jd, rows, t[cols], use_kernel)
+    el = np.full((n_gs, n_sat, len(t)), -90.0)
+    for g in range(n_gs):
+        el[g, rows, cols] = topocentric(pos, vel, *(vec[k][:, g, None] for k in GS_VECTORS))[0]
+
+    # Pass rows are station-major: row = g * n_sat + sat
+    def look(rr, tt):
+        g, s = np.divmod(rr, n_sat)
+        p, v = tle_ecef_samples(coef, epoch_jd, start_jd, s, tt, use_kernel)
+        return topocentric(p, v, *(vec[k][:, g] for k in GS_VECTORS))
+
+    def elev(rr, tt):
+        return look(rr, tt)[0]
+
+    rr, aos, los, t_peak = find_pass_edges(t, el.reshape(n_gs * n_sat, len(t)), elev)
+    # Midnight UTC before start_jd is day 1
+    day0 = -((start_jd - 0.5) % 1.0) * 86400.0
+    passes = pass_records(rr, aos, los, t_peak, dt_s, look, day0_s=day0)
+    for p, row in zip(passes, rr):
+        g, sat = divmod(int(row), n_sat)
+        p["gs"]    = stations[g]["name"]
+        p["sat"]   = sat
+        p["name"]  = tles[sat]["name"]
+        p["norad"] = tles[sat]["norad"]
     return passes
 
 
+def plan_contacts(tles, stations, start_jd, days=7.0, dt_s=60.0, workers=None,
+                  use_kernel=True, prefilter=True):
+    """
+    Find every contact between many ground stations and many TLE satellites.
+
+    The catalogue is split into slices that are planned in parallel worker
+    processes (plan_chunk).  Within a slice, all stations and satellites
+    share one prefiltered sweep (contact_candidates) and one pass-edge
+    search (find_pass_edges).  dt_s can be coarser than for find_passes():
+    passes shorter than a step are still caught at their peak.
+
+    Parameters
+    ----------
+    tles      : list   from read_tle_file(); deep-space objects are skipped
+    stations  : list   of ground_station() dicts
+    start_jd  : float  start of the window (UTC Julian date)
+    days      : float  window length                        [days]
+    dt_s      : float  sweep and profile time step           [s]
+    workers   : int    worker processes (default: one per core)
+    prefilter : bool   False sweeps every sample (for checking the bounds)
+
+    Returns
+    -------
+    passes  : list of pass records as find_passes(), all stations merged in
+              AOS order, with times in seconds from start_jd and four more
+              keys: gs (station name), sat (index into tles), name, norad
+    skipped : list of the names of the deep-space objects left out
+    """
+    if not tles or not stations:
+        return [], []
+    _, _, deep = sgp4_init(tles)
+    sats    = np.flatnonzero(~deep)
+    skipped = [tles[i]["name"] for i in np.flatnonzero(deep)]
+    if len(sats) == 0:
+        return [], skipped
+
+    # Slices small enough for the sweep arrays, and enough of them to keep
+    # every worker busy
+    workers = max(1, workers or os.cpu_count() or 1)
+    n_t     = int(days * 86400.0 / dt_s) + 2
+    size    = max(1, min(-(-len(sats) // (4 * workers)),
+                         SGP4_CHUNK // (len(stations) * n_t)))
+    slices  = [sats[i:i + size] for i in range(0, len(sats), size)]
+    jobs    = [([tles[i] for i in sl], stations, start_jd, days, dt_s, use_kernel, prefilter)
+               for sl in slices]
+    if workers > 1 and len(jobs) > 1:
+        with concurrent.futures.ProcessPoolExecutor(workers) as pool:
+            results = list(pool.map(plan_chunk, jobs))
+    else:
+        results = [plan_chunk(job) for job in jobs]
+
+    passes = []
+    for sl, chunk in zip(slices, results):
+        for p in chunk:
+            p["sat"] = int(sl[p["sat"]])
+        passes += chunk
+    passes.sort(key=lambda p: (p["start_s"], p["gs"]))
+    return passes, skipped
+
+
+def write_contact_table(passes, path, start_jd):
+    """
+    Write the merged contact table of plan_contacts() for a network scheduler.
+
+    Columns: contact,station,satellite,norad,aos_utc,tca_utc,los_utc,
+             aos_s,los_s,dur_s,max_el_deg,az_aos_deg,az_los_deg,lm_ebno_db
+    Times are ISO-8601 UTC, and seconds from the window start in aos_s /
+    los_s; tca is the time of peak elevation.
+    """
+    def utc(t_s):
+        return f"{datetime_from_jd(start_jd + t_s / 86400.0):%Y-%m-%dT%H:%M:%S.%f}"[:-3] + "Z"
+
+    with open(path, "w") as f:
+        f.write(f"# Contact plan -- generated by adcs_skissue.py, window start "
+                f"{utc(0.0)}\n")
+        f.write("contact,station,satellite,norad,aos_utc,tca_utc,los_utc,"
+                "aos_s,los_s,dur_s,max_el_deg,az_aos_deg,az_los_deg,lm_ebno_db\n")
+        for i, p in enumerate(passes, 1):
+            lb = link_budget(p["max_el_deg"])
+            f.write(f"{i},{p['gs']},{p['name']},{p['norad']},{utc(p['start_s'])},"
+                    f"{utc(p['t_peak_s'])},{utc(p['end_s'])},{p['start_s']:.3f},"
+                    f"{p['end_s']:.3f},{p['dur_s']:.3f},{p['max_el_deg']:.2f},"
+                    f"{p['az_rise']:.1f},{p['az_set']:.1f},{lb['LM_ebno']:.2f}\n")
+
+
+# ==============================================================================
+# SECTION 9 -- DOPPLER PRE-COMPENSATION
+#
+# The ground radio is retuned through the pass: received downlink at
+# FREQ + doppler, uplink transmitted at FREQ - doppler so that the satellite
+# hears FREQ.  doppler_schedule() tabulates range, range rate and Doppler at
+# 1-10 Hz from the analytic relative velocity and acceleration, not from
+# finite differences, so every sample also carries its own Doppler rate.
+#
+# stream_doppler() feeds the table to rigctld (Hamlib's rig-control daemon,
+# "F <Hz>" / "I <Hz>" commands on TCP port 4532).  Each command is
+# interpolated for the moment the rig will have applied it -- the send time
+# plus the measured command latency -- with a cubic Hermite fit through the
+# Doppler and Doppler rate of the neighbouring samples, so the tuning does
+# not trail the pass.  rigctld_stub() is a stand-in daemon for testing.
+# ==============================================================================
+
+DOPPLER_RATE_HZ  = 10.0     # Schedule sample rate                          [Hz]
+DOPPLER_STEP_HZ  = 5.0      # Largest tuning error between retunes         [Hz]
+RIG_SETTLE_S     = 0.05     # Rig time to apply a frequency after the reply  [s]
+RIG_PRE_AOS_S    = 10.0     # Start tuning this long before AOS               [s]
+RIGCTLD_PORT     = 4532
+
+
+def kepler_relative_state(t, ic):
+    """
+    Position [m], velocity [m/s] and acceleration [m/s^2] of the satellite
+    relative to the GS, in ECI, for an array of times.
+
+    Same model as sat_eci_series() and gs_eci_series(), differentiated
+    analytically: on the circular orbit every component is a sinusoid in the
+    argument of latitude u, so d/dt = omega * d/du and the acceleration is
+    -omega^2 times the position.  Unlike doppler_shift_hz(), the velocity of
+    the GS itself (up to 465 m/s) is included.
+
+    Returns
+    -------
+    d, dv, da : np.ndarray, each (3, len(t))
+    """
+    t     = np.asarray(t, dtype=float)
+    omega = 2.0 * PI / orbital_period(ic["h_km"] * 1e3)
+    sat   = sat_eci_series(t, ic)
+    # d/du of the position is the position a quarter orbit ahead
+    v_sat = omega * sat_eci_series(t + 0.25 * 2.0 * PI / omega, ic)
+
+    gs    = gs_eci_series(t)
+    v_gs  = OMEGA_E * np.stack([-gs[1], gs[0], np.zeros_like(t)])
+    a_gs  = -OMEGA_E**2 * np.stack([gs[0], gs[1], np.zeros_like(t)])
+    return sat - gs, v_sat - v_gs, -omega**2 * sat - a_gs
+
+
+def tle_relative_state(coef, epoch_jd, start_jd, rows, t, gs_ecef_km, use_kernel=True):
+    """
+    Position [m], velocity [m/s] and acceleration [m/s^2] of satellite
+    rows[i] at t[i] [s from start_jd] relative to a GS at gs_ecef_km
+    (3, n), in the Earth-fixed frame.
+
+    The velocity comes from SGP4.  The acceleration is two-body gravity
+    plus the Coriolis and centrifugal terms of the rotating frame; J2 and
+    drag change the Doppler rate by less than 0.2 %.
+    """
+    pos, vel = tle_ecef_samples(coef, epoch_jd, start_jd, rows, t, use_kernel)
+    r3  = np.sum(pos * pos, axis=0) ** 1.5
+    acc = (-SGP4_MU * pos / r3
+           - 2.0 * OMEGA_E * np.stack([-vel[1], vel[0], np.zeros_like(t)])
+           + OMEGA_E**2 * np.stack([pos[0], pos[1], np.zeros_like(t)]))
+    return (pos - gs_ecef_km) * 1e3, vel * 1e3, acc * 1e3
+
+
+def range_derivatives(d, dv, da):
+    """
+    Slant range [m], range rate [m/s] and range acceleration [m/s^2] from
+    the relative position, velocity and acceleration (3, n):
+        rdot  = d.dv / r
+        rddot = (|dv|^2 + d.da - rdot^2) / r
+    """
+    rng   = np.sqrt(np.sum(d * d, axis=0))
+    rdot  = np.sum(d * dv, axis=0) / rng
+    rddot = (np.sum(dv * dv, axis=0) + np.sum(d * da, axis=0) - rdot**2) / rng
+    return rng, rdot, rddot
+
+
+def doppler_schedule(passes, state, rate_hz=DOPPLER_RATE_HZ):
+    """
+    Doppler schedule of every pass, sampled at rate_hz on a grid aligned to
+    whole multiples of 1/rate_hz, from one sample before AOS to one after
+    LOS so that interpolation covers the whole pass.
+
+    Parameters
+    ----------
+    passes  : list      pass records (find_passes or plan_contacts)
+    state   : callable  state(idx, t) -> d, dv, da (3, n) of pass idx[i] at
+              t[i], from kepler_relative_state() or tle_relative_state()
+    rate_hz : float     sample rate                              [Hz]
+
+    Returns
+    -------
+    dict of np.ndarray, one entry per sample, ordered by pass and time:
+      pass (index into passes), t_s, range_m, range_rate_m_s, doppler_hz,
+      doppler_rate_hz_s
+    """
+    k0 = [math.floor(p["start_s"] * rate_hz) for p in passes]
+    k1 = [math.ceil(p["end_s"] * rate_hz) for p in passes]
+    idx = np.repeat(np.arange(len(passes)), [b - a + 1 for a, b in zip(k0, k1)])
+    t   = np.concatenate([np.arange(a, b + 1) for a, b in zip(k0, k1)] or [[]]) / rate_hz
+    if len(t) == 0:
+        return {"pass": idx, "t_s": t, "range_m": t, "range_rate_m_s": t,
+                "doppler_hz": t, "doppler_rate_hz_s": t}
+    rng, rdot, rddot = range_derivatives(*state(idx, t))
+    return {
+        "pass"             : idx,
+        "t_s"              : t,
+        "range_m"          : rng,
+        "range_rate_m_s"   : rdot,
+        "doppler_hz"       : -FREQ * rdot / C_LIGHT,
+        "doppler_rate_hz_s": -FREQ * rddot / C_LIGHT,
+    }
+
+
+def write_doppler_schedule(sched, path, start=None):
+    """
+    Write a Doppler schedule as CSV; returns the number of samples.
+
+    Columns: pass,t_s[,utc],range_m,range_rate_m_s,doppler_hz,
+             doppler_rate_hz_s,rx_hz,tx_hz
+    utc is written when the naive UTC datetime of t = 0 is given; rx_hz and
+    tx_hz are the downlink and pre-compensated uplink frequencies.
+    """
+    fd   = sched["doppler_hz"]
+    cols = [(sched["pass"] + 1).tolist(), sched["t_s"].tolist()]
+    fmt  = "%d,%.1f,"
+    if start is not None:
+        utc = np.datetime64(start, "ms") + np.round(sched["t_s"] * 1e3).astype("timedelta64[ms]")
+        cols.append(np.datetime_as_string(utc, unit="ms").tolist())
+        fmt += "%sZ,"
+    fmt  += "%.1f,%.3f,%.2f,%.3f,%.0f,%.0f\n"
+    cols += [sched["range_m"].tolist(), sched["range_rate_m_s"].tolist(), fd.tolist(),
+             sched["doppler_rate_hz_s"].tolist(), (FREQ + fd).tolist(), (FREQ - fd).tolist()]
+
+    with open(path, "w") as f:
+        f.write(f"# Doppler schedule -- generated by adcs_skissue.py, "
+                f"f0 = {FREQ:.0f} Hz\n")
+        f.write("pass,t_s," + ("utc," if start is not None else "")
+                + "range_m,range_rate_m_s,doppler_hz,doppler_rate_hz_s,rx_hz,tx_hz\n")
+        f.writelines(fmt % row for row in zip(*cols))
+    return len(fd)
+
+
+def doppler_at(sched, lo, hi, t):
+    """
+    Doppler [Hz] and Doppler rate [Hz/s] at t [s], by cubic Hermite
+    interpolation between the samples of sched[lo:hi] (one pass) around t.
+    Outside the pass the end samples are held.
+    """
+    ts = sched["t_s"][lo:hi]
+    fd = sched["doppler_hz"][lo:hi]
+    fr = sched["doppler_rate_hz_s"][lo:hi]
+    k  = int(np.clip(np.searchsorted(ts, t) - 1, 0, len(ts) - 2))
+    h  = ts[k + 1] - ts[k]
+    s  = min(max((t - ts[k]) / h, 0.0), 1.0)
+    h00, h10 = 2 * s**3 - 3 * s**2 + 1, s**3 - 2 * s**2 + s
+    h01, h11 = -2 * s**3 + 3 * s**2, s**3 - s**2
+    f = h00 * fd[k] + h10 * h * fr[k] + h01 * fd[k + 1] + h11 * h * fr[k + 1]
+    rate = ((6 * s**2 - 6 * s) * (fd[k] - fd[k + 1]) / h
+            + (3 * s**2 - 4 * s + 1) * fr[k] + (3 * s**2 - 2 * s) * fr[k + 1])
+    return f, rate
+
+
+def rig_command(sock, reader, cmd):
+    """Send one rigctld command; returns the RPRT code (0 = success)."""
+    sock.sendall((cmd + "\n").encode())
+    reply = reader.readline()
+    if not reply:
+        raise ConnectionError("rigctld closed the connection")
+    reply = reply.strip()
+    return int(reply.split()[1]) if reply.startswith("RPRT") else 0
+
+
+def stream_doppler(sched, passes, epoch_unix, host="localhost", port=RIGCTLD_PORT,
+                   names=None):
+    """
+    Track every pass of a Doppler schedule live through rigctld.
+
+    Passes are taken in AOS order; one that starts while another is being
+    tracked is skipped.  From RIG_PRE_AOS_S before AOS to LOS, the RX
+    ("F") and split TX ("I") frequencies are set for the time the rig will
+    apply them: now + smoothed command latency + RIG_SETTLE_S.  A command
+    is sent once the correction has moved by half of DOPPLER_STEP_HZ, and
+    the loop wakes before it can move by another half, so the tuning error
+    stays below DOPPLER_STEP_HZ.  The rig is put back on FREQ after each
+    pass.  If the rig refuses split (no "I"), only RX is tuned.
+
+    Parameters
+    ----------
+    sched      : dict   from doppler_schedule()
+    passes     : list   the pass records the schedule was made from
+    epoch_unix : float  wall-clock time of t = 0 of the passes  [s, Unix]
+    names      : list   optional label of each pass, for the log
+    """
+    bounds = np.searchsorted(sched["pass"], np.arange(len(passes) + 1))
+    sock   = socket.create_connection((host, port))
+    reader = sock.makefile("r")
+    split  = True
+    lat_s  = 0.0
+    busy_until = -np.inf
+    print(f"  rigctld {host}:{port} -- f0 {FREQ/1e6:.3f} MHz, "
+          f"step {DOPPLER_STEP_HZ:g} Hz")
+    try:
+        for i in np.argsort([p["start_s"] for p in passes], kind="stable"):
+            p, lo, hi = passes[i], bounds[i], bounds[i + 1]
+            label = names[i] if names else f"pass {i + 1}"
+            now = time.time() - epoch_unix
+            if p["end_s"] <= now or hi - lo < 2:
+                continue
+            if p["start_s"] < busy_until:
+                print(f"  {label}: skipped, overlaps the pass being tracked")
+                continue
+            busy_until = p["end_s"]
+            wait = p["start_s"] - RIG_PRE_AOS_S - now
+            if wait > 0:
+                print(f"  {label}: AOS in {wait + RIG_PRE_AOS_S:.0f} s")
+                time.sleep(wait)
+            print(f"  {label}: tracking, max el {p['max_el_deg']:.1f} deg")
+
+            sent = None
+            n_cmd = 0
+            worst = 0.0
+            while True:
+                now = time.time() - epoch_unix
+                if now >= p["end_s"]:
+                    break
+                ahead = now + lat_s + RIG_SETTLE_S
+                f, rate = doppler_at(sched, lo, hi, ahead)
+                if sent is None or abs(f - sent) >= 0.5 * DOPPLER_STEP_HZ:
+                    t0 = time.time()
+                    rig_command(sock, reader, f"F {FREQ + f:.0f}")
+                    if split and rig_command(sock, reader, f"I {FREQ - f:.0f}") != 0:
+                        split = False
+                        print("  rig refused split TX: tuning RX only")
+                    lat_s = 0.8 * lat_s + 0.2 * (time.time() - t0)
+                    if sent is not None:
+                        worst = max(worst, abs(f - sent))
+                    sent = f
+                    n_cmd += 1
+                # Wake before the correction can move by another half step
+                time.sleep(min(0.5 * DOPPLER_STEP_HZ / max(abs(rate), 1e-6), 1.0))
+            rig_command(sock, reader, f"F {FREQ:.0f}")
+            if split:
+                rig_command(sock, reader, f"I {FREQ:.0f}")
+            print(f"  {label}: LOS, {n_cmd} updates, latency {lat_s * 1e3:.1f} ms, "
+                  f"largest step {worst:.1f} Hz")
+    finally:
+        reader.close()
+        sock.close()
+
+
+def rigctld_stub(port=RIGCTLD_PORT):
+    """
+    Minimal stand-in for rigctld, for testing stream_doppler() without a
+    radio: answers "F", "I", "f" and "i" on localhost and logs every
+    frequency change with its time.
+    """
+    srv = socket.create_server(("localhost", port))
+    print(f"  rigctld stand-in on localhost:{port} (Ctrl+C to stop)")
+    freq = {"F": FREQ, "I": FREQ}
+    try:
+        while True:
+            conn, _ = srv.accept()
+            with conn, conn.makefile("rw") as rw:
+                for line in rw:
+                    cmd = line.split()
+                    if not cmd:
+                        continue
+                    if cmd[0] in ("F", "I") and len(cmd) == 2:
+                        freq[cmd[0]] = float(cmd[1])
+                        print(f"  {time.time():.3f}  {'RX' if cmd[0] == 'F' else 'TX'} "
+                              f"{freq[cmd[0]]:.0f} Hz  ({freq[cmd[0]] - FREQ:+.0f})", flush=True)
+                        rw.write("RPRT 0\n")
+                    elif cmd[0] in ("f", "i"):
+                        rw.write(f"{freq[cmd[0].upper()]:.0f}\n")
+                    else:
+                        rw.write("RPRT -1\n")
+                    rw.flush()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        srv.close()
+
+
+# ==============================================================================
+# SECTION 10 -- ROTOR TRACKING
+#
+# rotor_ephemeris() precomputes the az/el of every pass at ROTOR_EPHEM_HZ
+# and turns it into a rotor path:
+#   - Azimuth is unwrapped along the pass and shifted by whole turns to fit
+#     between the rotor's stops (most have 450 deg of travel, so a pass
+#     through north needs no unwind).  If it cannot fit, the path is folded
+#     back into range and the rotor swings round at the stop.
+#   - Near-zenith ("key-hole") passes sweep azimuth faster than the rotor
+#     can turn.  The path is rate-limited forwards and backwards in time and
+#     the two averaged, so the swing is centred on the peak instead of
+#     trailing it; at high elevation an azimuth error costs little pointing.
+# Each axis is then a natural cubic spline through the 1 Hz samples.
+#
+# track_rotor() evaluates the splines at ROTOR_LOOP_HZ and sends "P az el"
+# to rotctld (Hamlib's rotor daemon, TCP port 4533).  Ticks are scheduled
+# on absolute monotonic deadlines, so timing errors do not accumulate, and
+# each target is taken at the time the command will be applied.
+# rotctld_stub() is a simulated rotor for testing.
+# ==============================================================================
+
+ROTOR_EPHEM_HZ      = 1.0     # Ephemeris sample rate                        [Hz]
+ROTOR_LOOP_HZ       = 5.0     # Control loop rate                            [Hz]
+ROTOR_AZ_MIN_DEG    = 0.0     # Azimuth stops                                [deg]
+ROTOR_AZ_MAX_DEG    = 450.0
+ROTOR_EL_MAX_DEG    = 90.0
+ROTOR_AZ_RATE_DEG_S = 6.0     # Slew rates (G-5500 class rotor)          [deg/s]
+ROTOR_EL_RATE_DEG_S = 3.0
+ROTOR_LEAD_S        = 0.2     # Mechanical lag of the rotor behind a command [s]
+ROTOR_PRE_AOS_S     = 90.0    # Pre-position this long before AOS            [s]
+ROTCTLD_PORT        = 4533
+
+
+def spline_fit(t, y):
+    """
+    Second derivatives of the natural cubic spline through (t, y), by the
+    Thomas algorithm on its tridiagonal system.
+    """
+    n = len(t)
+    m = np.zeros(n)
+    if n < 3:
+        return m
+    h = np.diff(t)
+    rhs  = 6.0 * np.diff(np.diff(y) / h)
+    diag = 2.0 * (h[:-1] + h[1:])
+    c = np.zeros(n - 2)
+    d = np.zeros(n - 2)
+    for i in range(n - 2):
+        w    = diag[i] - (h[i] * c[i - 1] if i else 0.0)
+        c[i] = h[i + 1] / w
+        d[i] = (rhs[i] - (h[i] * d[i - 1] if i else 0.0)) / w
+    for i in range(n - 3, -1, -1):
+        m[i + 1] = d[i] - (c[i] * m[i + 2] if i < n - 3 else 0.0)
+    return m
+
+
+def spline_eval(t, y, m, x):
+    """Value of the spline (t, y, m) from spline_fit() at x, clamped to [t[0], t[-1]]."""
+    x = min(max(x, t[0]), t[-1])
+    k = int(np.clip(np.searchsorted(t, x) - 1, 0, len(t) - 2))
+    h = t[k + 1] - t[k]
+    a = (t[k + 1] - x) / h
+    b = 1.0 - a
+    return (a * y[k] + b * y[k + 1]
+            + ((a**3 - a) * m[k] + (b**3 - b) * m[k + 1]) * h * h / 6.0)
+
+
+def rate_limit(t, y, rate):
+    """
+    y slowed to |dy/dt| <= rate with the error centred in time: the mean of
+    a forward and a backward rate-limited pass.  Paths within the limit are
+    returned unchanged.
+    """
+    fwd = y.copy()
+    bwd = y.copy()
+    step = rate * np.diff(t)
+    for i in range(1, len(y)):
+        fwd[i] = fwd[i - 1] + np.clip(y[i] - fwd[i - 1], -step[i - 1], step[i - 1])
+    for i in range(len(y) - 2, -1, -1):
+        bwd[i] = bwd[i + 1] + np.clip(y[i] - bwd[i + 1], -step[i], step[i])
+    return 0.5 * (fwd + bwd)
+
+
+def rotor_path(t, az_deg, el_deg):
+    """
+    Rotor path of one pass (see the section notes).
+
+    Returns
+    -------
+    az_cmd, el_cmd : np.ndarray  unwrapped rotor azimuth and elevation [deg]
+    fold           : bool        az_cmd leaves the stops and must be folded
+                                 back into range when evaluated
+    keyhole        : bool        azimuth was rate-limited
+    """
+    az = np.degrees(np.unwrap(np.radians(az_deg)))
+    el = np.clip(el_deg, 0.0, ROTOR_EL_MAX_DEG)
+    keyhole = bool(np.any(np.abs(np.diff(az)) > ROTOR_AZ_RATE_DEG_S * np.diff(t)))
+    az = rate_limit(t, az, ROTOR_AZ_RATE_DEG_S)
+    el = rate_limit(t, el, ROTOR_EL_RATE_DEG_S)
+
+    # Whole turns that fit the stops; keep the one with the most margin
+    lo, hi = az.min(), az.max()
+    turns  = np.arange(np.floor((ROTOR_AZ_MIN_DEG - lo) / 360.0),
+                       np.ceil((ROTOR_AZ_MAX_DEG - hi) / 360.0) + 1)
+    margin = np.minimum(lo + 360.0 * turns - ROTOR_AZ_MIN_DEG,
+                        ROTOR_AZ_MAX_DEG - hi - 360.0 * turns)
+    if len(turns) and margin.max() >= 0.0:
+        return az + 360.0 * turns[np.argmax(margin)], el, False, keyhole
+    return az - 360.0 * np.floor((az[0] - ROTOR_AZ_MIN_DEG) / 360.0), el, True, keyhole
+
+
+def rotor_azimuth(az):
+    """Azimuth of a folded path (rotor_path() fold) brought back within the stops."""
+    return ROTOR_AZ_MIN_DEG + (az - ROTOR_AZ_MIN_DEG) % 360.0
+
+
+def rotor_ephemeris(passes, look, rate_hz=ROTOR_EPHEM_HZ):
+    """
+    Dense az/el ephemeris and rotor path of every pass.
+
+    Parameters
+    ----------
+    passes  : list      pass records (find_passes or plan_contacts)
+    look    : callable  look(idx, t) -> el_deg, az_deg of pass idx[i] at
+              t[i], for all samples of all passes in one call
+    rate_hz : float     ephemeris sample rate                    [Hz]
+
+    Returns
+    -------
+    list of dicts, one per pass, with keys
+      t, el, az (the satellite, azimuth unwrapped), az_cmd, el_cmd (the
+      rotor path), the matching spline_fit() second derivatives m_el, m_az,
+      m_az_cmd, m_el_cmd, and fold, keyhole as rotor_path()
+    """
+    k0 = [math.floor(p["start_s"] * rate_hz) for p in passes]
+    k1 = [math.ceil(p["end_s"] * rate_hz) for p in passes]
+    idx = np.repeat(np.arange(len(passes)), [b - a + 1 for a, b in zip(k0, k1)])
+    t   = np.concatenate([np.arange(a, b + 1) for a, b in zip(k0, k1)] or [[]]) / rate_hz
+    el, az = look(idx, t) if len(t) else (t, t)
+    bounds = np.searchsorted(idx, np.arange(len(passes) + 1))
+
+    ephem = []
+    for i in range(len(passes)):
+        sl = slice(bounds[i], bounds[i + 1])
+        ts = t[sl]
+        e  = {"t": ts, "el": el[sl], "az": np.degrees(np.unwrap(np.radians(az[sl])))}
+        e["az_cmd"], e["el_cmd"], e["fold"], e["keyhole"] = rotor_path(ts, az[sl], el[sl])
+        for k in ("el", "az", "az_cmd", "el_cmd"):
+            e["m_" + k] = spline_fit(ts, e[k])
+        ephem.append(e)
+    return ephem
+
+
+def rotor_target(e, t):
+    """Rotor azimuth and elevation [deg] of ephemeris e at t."""
+    az = spline_eval(e["t"], e["az_cmd"], e["m_az_cmd"], t)
+    el = spline_eval(e["t"], e["el_cmd"], e["m_el_cmd"], t)
+    return (rotor_azimuth(az) if e["fold"] else az), el
+
+
+def pointing_error_deg(az1, el1, az2, el2):
+    """Angle between two az/el directions [deg]."""
+    az1, el1, az2, el2 = np.radians([az1, el1, az2, el2])
+    c = np.sin(el1) * np.sin(el2) + np.cos(el1) * np.cos(el2) * np.cos(az1 - az2)
+    return float(np.degrees(np.arccos(np.clip(c, -1.0, 1.0))))
+
+
+def rot_command(sock, reader, cmd, lines=0):
+    """
+    Send one rotctld command.  Returns the RPRT code, or the reply lines for
+    a query that answers with `lines` values ("p" answers az and el).
+    """
+    sock.sendall((cmd + "\n").encode())
+    if lines:
+        reply = [reader.readline() for _ in range(lines)]
+        if reply[0].startswith("RPRT"):
+            raise ConnectionError(f"rotctld: {cmd} -> {reply[0].strip()}")
+        return [float(x) for x in reply]
+    reply = reader.readline()
+    if not reply:
+        raise ConnectionError("rotctld closed the connection")
+    reply = reply.strip()
+    return int(reply.split()[1]) if reply.startswith("RPRT") else 0
+
+
+def track_rotor(ephem, passes, epoch_unix, host="localhost", port=ROTCTLD_PORT,
+                loop_hz=ROTOR_LOOP_HZ, names=None):
+    """
+    Track every pass live through rotctld.
+
+    Passes are taken in AOS order; one that starts while another is being
+    tracked is skipped.  The rotor is sent to the start of the path
+    ROTOR_PRE_AOS_S before AOS, then commanded every 1/loop_hz s to the
+    spline target at now + smoothed command latency + ROTOR_LEAD_S.  Once a
+    second the rotor position is read back ("p") and compared with the
+    satellite.  Per pass, the tick jitter (lateness against the deadline)
+    and the pointing error are reported.
+
+    Parameters
+    ----------
+    ephem      : list   from rotor_ephemeris()
+    passes     : list   the pass records the ephemeris was made from
+    epoch_unix : float  wall-clock time of t = 0 of the passes  [s, Unix]
+    names      : list   optional label of each pass, for the log
+    """
+    sock   = socket.create_connection((host, port))
+    reader = sock.makefile("r")
+    lat_s  = 0.0
+    busy_until = -np.inf
+    print(f"  rotctld {host}:{port} -- {loop_hz:g} Hz loop, az {ROTOR_AZ_MIN_DEG:g}.."
+          f"{ROTOR_AZ_MAX_DEG:g} deg")
+    try:
+        for i in np.argsort([p["start_s"] for p in passes], kind="stable"):
+            p, e  = passes[i], ephem[i]
+            label = names[i] if names else f"pass {i + 1}"
+            if p["end_s"] <= time.time() - epoch_unix or len(e["t"]) < 2:
+                continue
+            if p["start_s"] < busy_until:
+                print(f"  {label}: skipped, overlaps the pass being tracked")
+                continue
+            busy_until = p["end_s"]
+
+            wait = p["start_s"] - ROTOR_PRE_AOS_S - (time.time() - epoch_unix)
+            if wait > 0:
+                print(f"  {label}: AOS in {wait + ROTOR_PRE_AOS_S:.0f} s")
+                time.sleep(wait)
+            az0, el0 = rotor_target(e, e["t"][0])
+            rot_command(sock, reader, f"P {az0:.1f} {max(el0, 0.0):.1f}")
+            wait = p["start_s"] - (time.time() - epoch_unix)
+            notes = (" key-hole," if e["keyhole"] else "") + (" unwinds at the stop," if e["fold"] else "")
+            print(f"  {label}:{notes} max el {p['max_el_deg']:.1f} deg, "
+                  f"parked at az {az0:.1f} el {el0:.1f}")
+            if wait > 0:
+                time.sleep(wait)
+
+            # Ticks on absolute deadlines of the monotonic clock
+            mono0 = time.monotonic()
+            t0    = time.time() - epoch_unix
+            tick  = 0
+            jitter, errors = [], []
+            next_check = t0
+            while True:
+                deadline = mono0 + tick / loop_hz
+                delay = deadline - time.monotonic()
+                if delay > 0:
+                    time.sleep(delay)
+                late = time.monotonic() - deadline
+                now  = t0 + (time.monotonic() - mono0)
+                if now >= p["end_s"]:
+                    break
+                jitter.append(late)
+                az, el = rotor_target(e, now + lat_s + ROTOR_LEAD_S)
+                t_cmd = time.monotonic()
+                rot_command(sock, reader, f"P {az:.2f} {el:.2f}")
+                lat_s = 0.8 * lat_s + 0.2 * (time.monotonic() - t_cmd)
+                if now >= next_check:
+                    az_r, el_r = rot_command(sock, reader, "p", lines=2)
+                    errors.append(pointing_error_deg(
+                        az_r, el_r, spline_eval(e["t"], e["az"], e["m_az"], now),
+                        spline_eval(e["t"], e["el"], e["m_el"], now)))
+                    next_check = now + 1.0
+                # The next deadline still ahead: an overrun skips the missed
+                # ticks instead of bunching them
+                tick = int((time.monotonic() - mono0) * loop_hz) + 1
+            jitter = np.array(jitter or [0.0]) * 1e3
+            print(f"  {label}: LOS, {len(jitter)} commands, jitter mean {np.mean(jitter):.1f} / "
+                  f"max {np.max(jitter):.1f} ms, pointing error mean "
+                  f"{np.mean(errors or [0.0]):.2f} / max {np.max(errors or [0.0]):.2f} deg")
+    finally:
+        reader.close()
+        sock.close()
+
+
+def rotctld_stub(port=ROTCTLD_PORT):
+    """
+    Simulated rotor behind a minimal rotctld, for testing track_rotor():
+    answers "P", "p" and "S" on localhost, slews toward the target at
+    ROTOR_AZ_RATE_DEG_S / ROTOR_EL_RATE_DEG_S, refuses targets outside the
+    stops, and logs its position once a second.
+    """
+    srv = socket.create_server(("localhost", port))
+    print(f"  rotctld stand-in on localhost:{port} (Ctrl+C to stop)")
+    pos, target = np.zeros(2), np.zeros(2)
+    rates = np.array([ROTOR_AZ_RATE_DEG_S, ROTOR_EL_RATE_DEG_S])
+    last, last_log = time.monotonic(), 0.0
+
+    def slew():
+        nonlocal last
+        now  = time.monotonic()
+        step = rates * (now - last)
+        pos[:] = pos + np.clip(target - pos, -step, step)
+        last = now
+
+    try:
+        while True:
+            conn, _ = srv.accept()
+            with conn, conn.makefile("rw") as rw:
+                for line in rw:
+                    cmd = line.split()
+                    if not cmd:
+                        continue
+                    slew()
+                    if cmd[0] == "P" and len(cmd) == 3:
+                        az, el = float(cmd[1]), float(cmd[2])
+                        if (ROTOR_AZ_MIN_DEG <= az <= ROTOR_AZ_MAX_DEG
+                                and 0.0 <= el <= ROTOR_EL_MAX_DEG):
+                            target[:] = az, el
+                            rw.write("RPRT 0\n")
+                        else:
+                            rw.write("RPRT -1\n")
+                    elif cmd[0] == "p":
+                        rw.write(f"{pos[0]:.2f}\n{pos[1]:.2f}\n")
+                    elif cmd[0] == "S":
+                        target[:] = pos
+                        rw.write("RPRT 0\n")
+                    else:
+                        rw.write("RPRT -1\n")
+                    rw.flush()
+                    if time.time() - last_log >= 1.0:
+                        last_log = time.time()
+                        print(f"  {last_log:.3f}  az {pos[0]:7.2f} el {pos[1]:6.2f}   "
+                              f"target az {target[0]:7.2f} el {target[1]:6.2f}", flush=True)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        srv.close()
+
+
 # ==============================================================================
-# SECTION 7 -- LINK BUDGET   (exact MATLAB match)
+# SECTION 11 -- LINK BUDGET   (exact MATLAB match)
 # ==============================================================================
 
 def link_budget(el_deg):
@@ -578,7 +2188,7 @@ def link_budget(el_deg):
 
 
 # ==============================================================================
-# SECTION 8 -- LORA TIME-ON-AIR
+# SECTION 12 -- LORA TIME-ON-AIR
 # ==============================================================================
 
 def lora_toa(n_bytes, sf=12, bw_khz=125.0, cr=1, preamble=8,
@@ -592,10 +2202,18 @@ def lora_toa(n_bytes, sf=12, bw_khz=125.0, cr=1, preamble=8,
         [Preamble: preamble+4.25] + [payload symbols: 8 + max(ceil(...), 0)]
 
     Low Data Rate Optimisation (LDRO):
-        Mandatory for SF >= 11.  It inserts de=2 in the symbol-count formula,
-        effectively extending each symbol to prevent inter-symbol interference
-        at very low chip rates.  SF12/BW=125kHz without LDRO is undecodable.
-        This function enables LDRO automatically for SF >= 11.
+        Semtech recommends it when the symbol time exceeds 16 ms.  It
+        inserts de=2 in the symbol-count formula, effectively extending
+        each symbol to prevent inter-symbol interference at very low chip
+        rates.  SF12/BW=125kHz without LDRO is undecodable.
+        The sketches leave LDRO to the Arduino LoRa library, which turns it
+        on when the integer symbol time 1000 / (bw_hz / 2^sf) [ms] is above
+        16.  That rounds SF11/125 kHz and SF12/250 kHz (16.4 ms) down to 16,
+        so the radio runs them without LDRO; this function applies the same
+        integer rule so the costed symbol count matches what is sent.
+
+    n_bytes, sf, bw_khz and cr may also be arrays, which are broadcast
+    together (beacon_sweep costs its whole grid in one call).
 
     Parameters
     ----------
@@ -608,32 +2226,45 @@ def lora_toa(n_bytes, sf=12, bw_khz=125.0, cr=1, preamble=8,
 
     Returns
     -------
-    float
+    float (np.ndarray for array arguments)
         Time-on-Air [s].
     """
-    bw    = bw_khz * 1e3
-    t_sym = (2**sf) / bw                   # symbol duration [s]
+    sf    = np.asarray(sf)
+    bw    = np.asarray(bw_khz) * 1e3
+    t_sym = (2.0**sf) / bw                 # symbol duration [s]
     t_pre = (preamble + 4.25) * t_sym      # preamble duration [s]
 
-    de = 2 if sf >= 11 else 0              # LDRO shift
+    de = np.where(1000 // (np.floor(bw) // 2.0**sf) > 16, 2, 0)   # LDRO shift
     ih = 0 if explicit_header else 1       # implicit header flag (0 = explicit)
 
     # Payload symbol count from spec (Table 3)
-    n_sym_pay = 8 + max(
-        int(np.ceil(
-            (8 * n_bytes - 4 * sf + 28 + 16 - 20 * ih) / (4 * (sf - de))
-        )) * (cr + 4),
+    n_sym_pay = 8 + np.maximum(
+        np.ceil(
+            (8 * np.asarray(n_bytes) - 4 * sf + 28 + 16 - 20 * ih) / (4 * (sf - de))
+        ) * (np.asarray(cr) + 4),
         0
     )
-    return t_pre + n_sym_pay * t_sym
+    toa = t_pre + n_sym_pay * t_sym
+    return float(toa) if np.ndim(toa) == 0 else toa
 
 
 # ==============================================================================
-# SECTION 9 -- BEACON TIMING OPTIMISER
+# SECTION 13 -- BEACON TIMING OPTIMISER
 # ==============================================================================
 
+BEACON_SWITCH_S = 0.5       # SX127x mode-switch + MCU overhead per cycle   [s]
+
+# Supply power of the RFM96W in each part of the cycle (SX1276 datasheet, 3.3 V)
+BEACON_TX_W   = 0.396       # TX at +20 dBm on PA_BOOST (120 mA)             [W]
+BEACON_RX_W   = 0.038       # RX with LNA boost (11.5 mA)                    [W]
+BEACON_IDLE_W = 0.005       # Standby during the mode switch (1.6 mA)       [W]
+
+# Grid of beacon_sweep() beyond the SF / BW / CR options
+SWEEP_PAYLOADS = (16, 32, 51, 64, 96, 128, 192, 255)    # DL and UL sizes [bytes]
+SWEEP_GUARDS_S = (1.0, 2.0, 3.0, 5.0)                   # UL timing guard   [s]
+
 def beacon_optimiser(dl_bytes=51, ul_bytes=51, guard_s=3.0,
-                     pass_dur_s=320.0):
+                     pass_dur_s=320.0, sf=12, bw_khz=125.0, cr=1):
     """
     Compute optimal beacon cycle timing for a GPS-less CubeSat.
 
@@ -663,6 +2294,7 @@ def beacon_optimiser(dl_bytes=51, ul_bytes=51, guard_s=3.0,
     guard_s    : float  timing guard added to y window     [s]
                         (covers oscillator drift + Doppler compensation latency)
     pass_dur_s : float  representative pass duration       [s]
+    sf, bw_khz, cr      LoRa settings of both windows (default SF12/125/CR4-5)
 
     Returns
     -------
@@ -676,9 +2308,9 @@ def beacon_optimiser(dl_bytes=51, ul_bytes=51, guard_s=3.0,
       toa_dl_s        : Time-on-Air of DL beacon          [s]
       toa_ul_s        : Time-on-Air of UL packet          [s]
     """
-    toa_dl = lora_toa(dl_bytes)
-    toa_ul = lora_toa(ul_bytes)
-    x      = toa_dl + 0.5           # 0.5 s = SX127x mode-switch + MCU overhead
+    toa_dl = lora_toa(dl_bytes, sf, bw_khz, cr)
+    toa_ul = lora_toa(ul_bytes, sf, bw_khz, cr)
+    x      = toa_dl + BEACON_SWITCH_S
     y      = toa_ul + guard_s
     cycle  = x + y
     wins   = int(pass_dur_s / cycle)
@@ -696,8 +2328,623 @@ def beacon_optimiser(dl_bytes=51, ul_bytes=51, guard_s=3.0,
     }
 
 
+def pareto_front(maximise, minimise):
+    """
+    Indices of the Pareto-optimal points of objectives (n,) arrays: no other
+    point is at least as good in every objective and better in one.  Of
+    points with identical objectives, only the first is kept.
+
+    The points are ordered best-first on the first objective to minimise, so
+    a point's dominators all come before it.  Exactly two objectives must be
+    maximised; for each distinct value of the first, a running maximum of
+    the second over the order gives the best point among the earlier ones
+    that match or beat that value.
+    """
+    (a, b), (c,) = maximise, minimise
+    order = np.lexsort((-b, -a, c))
+    a, b  = a[order], b[order]
+    best  = np.full(len(a), -np.inf)      # Best b of earlier points with a >= level
+    seen  = np.full(len(a), -np.inf)
+    for level in np.unique(a)[::-1]:
+        at = a == level
+        seen[at] = b[at]
+        prior = np.concatenate([[-np.inf], np.maximum.accumulate(seen)[:-1]])
+        best[at] = prior[at]
+    return np.sort(order[best < b])
+
+
+def beacon_sweep(passes, sfs=None, bws=None, crs=None, dl_bytes=SWEEP_PAYLOADS,
+                 ul_bytes=SWEEP_PAYLOADS, guards_s=SWEEP_GUARDS_S):
+    """
+    beacon_optimiser() over every combination of SF, BW, CR, downlink and
+    uplink payload size and guard time, all evaluated as arrays.
+
+    The link-margin check decides how much of each pass can use a setting:
+    uplink windows are only counted while lora_link_margin() at the pass
+    elevation profile is >= 0 dB, so fast settings that close only near
+    zenith get fewer windows.  Settings whose link never closes in any pass
+    are infeasible.
+
+    Objectives of the Pareto set:
+      ul_bytes_pass : uplink bytes per pass, averaged over all passes  (max)
+      p_hit_pct     : chance that a blind GS transmission lands in an
+                      uplink window                                     (max)
+      energy_wh_day : radio energy of the blind beacon cycle per day    (min)
+
+    Parameters
+    ----------
+    passes : list of pass records from find_passes() (with profiles)
+    sfs, bws, crs : LoRa options (default: LORA_SF/BW/CR_OPTIONS)
+    dl_bytes, ul_bytes, guards_s : payload sizes and guard times swept
+
+    Returns
+    -------
+    grid   : dict of np.ndarray, one entry per combination, with keys
+             sf, bw_khz, cr, dl_bytes, ul_bytes, guard_s, x_s, y_s, cycle_s,
+             windows_pass, ul_bytes_pass, p_hit_pct, energy_wh_day, feasible
+    pareto : np.ndarray  indices into grid of the Pareto set of the feasible
+             combinations, by increasing uplink bytes per pass
+    """
+    sfs = LORA_SF_OPTIONS if sfs is None else sfs
+    bws = LORA_BW_OPTIONS if bws is None else bws
+    crs = LORA_CR_OPTIONS if crs is None else crs
+    axes = np.meshgrid(np.asarray(sfs), np.asarray(bws, dtype=float), np.asarray(crs),
+                       np.asarray(dl_bytes), np.asarray(ul_bytes),
+                       np.asarray(guards_s, dtype=float), indexing="ij")
+    sf, bw, cr, dl, ul, guard = (g.ravel() for g in axes)
+
+    x     = lora_toa(dl, sf, bw, cr) + BEACON_SWITCH_S
+    y     = lora_toa(ul, sf, bw, cr) + guard
+    cycle = x + y
+
+    # Seconds of each pass with the link closed, per SF / BW pair
+    el = np.concatenate([[s[1] for s in p["profile"]] for p in passes] or [[]])
+    pass_of = np.repeat(np.arange(len(passes)), [len(p["profile"]) for p in passes])
+    dt = passes[0]["profile"][1][0] - passes[0]["profile"][0][0] if len(el) > 1 else 0.0
+    pairs, pair = np.unique(np.stack([sf, bw]), axis=1, return_inverse=True)
+    usable = np.zeros((len(passes), pairs.shape[1]))
+    for k, (s, b) in enumerate(pairs.T):
+        closed = lora_link_margin(el, int(s), b) >= 0.0
+        usable[:, k] = np.bincount(pass_of[closed], minlength=len(passes)) * dt
+
+    windows = np.floor(usable[:, pair.ravel()] / cycle).mean(axis=0) if passes else 0.0 * cycle
+    p_hit   = 100.0 * y / cycle
+    energy  = (((x - BEACON_SWITCH_S) * BEACON_TX_W + BEACON_SWITCH_S * BEACON_IDLE_W
+                + y * BEACON_RX_W) / cycle) * 24.0          # mean power [W] x 24 h
+    feasible = np.any(usable[:, pair.ravel()] > 0.0, axis=0) if passes else cycle < 0.0
+
+    grid = {"sf": sf, "bw_khz": bw, "cr": cr, "dl_bytes": dl, "ul_bytes": ul,
+            "guard_s": guard, "x_s": x, "y_s": y, "cycle_s": cycle,
+            "windows_pass": windows, "ul_bytes_pass": windows * ul,
+            "p_hit_pct": p_hit, "energy_wh_day": energy, "feasible": feasible}
+    ok = np.flatnonzero(feasible)
+    front = ok[pareto_front((grid["ul_bytes_pass"][ok], p_hit[ok]), (energy[ok],))]
+    return grid, front[np.argsort(grid["ul_bytes_pass"][front], kind="stable")]
+
+
+def write_beacon_sweep(grid, front, path):
+    """
+    Write every combination of beacon_sweep() to a CSV, one row each, with
+    a pareto column marking the Pareto set.
+
+    Returns
+    -------
+    int
+        Number of rows written.
+    """
+    on_front = np.zeros(len(grid["sf"]), dtype=bool)
+    on_front[front] = True
+    cols = [grid[k].tolist() for k in ("sf", "bw_khz", "cr", "dl_bytes", "ul_bytes",
+                                        "guard_s", "x_s", "y_s", "windows_pass",
+                                        "ul_bytes_pass", "p_hit_pct", "energy_wh_day")]
+    with open(path, "w") as f:
+        f.write("# Beacon timing sweep -- generated by adcs_skissue.py\n")
+        f.write("sf,bw_khz,cr,dl_bytes,ul_bytes,guard_s,x_s,y_s,windows_pass,"
+                "ul_bytes_pass,p_hit_pct,energy_wh_day,feasible,pareto\n")
+        f.writelines("%d,%g,%d,%d,%d,%g,%.3f,%.3f,%.2f,%.0f,%.2f,%.3f,%d,%d\n" % row
+                     for row in zip(*cols, grid["feasible"].tolist(), on_front.tolist()))
+    return len(on_front)
+
+
+# ==============================================================================
+# SECTION 14 -- DOWNLINK PASS SCHEDULE EXPORT
+# ==============================================================================
+
+def pass_airtime_budget(p, sf=12, bw_khz=125.0, cr=1, dl_bytes=51, ul_bytes=51,
+                        guard_s=3.0):
+    """
+    Downlink airtime available during one pass.
+
+    Only the part of the pass where the link margin of the given LoRa
+    settings (lora_link_margin) is non-negative is counted, and of that only
+    the TX share of the blind beacon cycle at those settings (x / (x + y)
+    from beacon_optimiser) -- the rest is spent listening.
+
+    Parameters
+    ----------
+    p        : dict   one pass record from find_passes
+    sf, bw_khz, cr    LoRa settings of the downlink
+    dl_bytes : int    beacon payload size used for the cycle   [bytes]
+    ul_bytes : int    uplink command size used for the cycle   [bytes]
+    guard_s  : float  uplink timing guard                      [s]
+
+    Returns
+    -------
+    float
+        Downlink airtime budget [s].
+    """
+    prof   = np.array(p["profile"])
+    dt_s   = prof[1, 0] - prof[0, 0] if len(prof) > 1 else 0.0
+    margin = lora_link_margin(prof[:, 1], sf, bw_khz, cr)
+    open_s = np.count_nonzero(margin >= 0.0) * dt_s
+    opt    = beacon_optimiser(dl_bytes, ul_bytes, guard_s, pass_dur_s=p["dur_s"],
+                              sf=sf, bw_khz=bw_khz, cr=cr)
+    return float(open_s * opt["x_s"] / opt["cycle_s"])
+
+
+def write_pass_schedule(passes, path, sf=12, bw_khz=125.0, cr=1):
+    """
+    Write the pass schedule CSV consumed by the packetizer (-s option).
+
+    Columns: pass,start_s,end_s,max_el_deg,budget_s,sf,bw_khz,cr
+    The LoRa settings tell the packetizer how to cost each frame with the
+    same Time-on-Air formula as lora_toa().
+
+    Parameters
+    ----------
+    passes : list    pass records from find_passes
+    path   : str     output CSV file
+    sf, bw_khz, cr   LoRa settings used for the downlink
+
+    Returns
+    -------
+    float
+        Total downlink airtime budget over all passes [s].
+    """
+    total = 0.0
+    with open(path, "w") as f:
+        f.write("# Downlink pass schedule -- generated by adcs_skissue.py\n")
+        f.write("pass,start_s,end_s,max_el_deg,budget_s,sf,bw_khz,cr\n")
+        for i, p in enumerate(passes, 1):
+            budget = pass_airtime_budget(p, sf, bw_khz, cr)
+            total += budget
+            f.write(f"{i},{p['start_s']:.1f},{p['end_s']:.1f},"
+                    f"{p['max_el_deg']:.2f},{budget:.2f},{sf},{bw_khz:g},{cr}\n")
+    return total
+
+
+def write_link_profile(passes, path):
+    """
+    Write the elevation / link-margin profile consumed by the packetizer (-e).
+
+    One row per profile sample of every pass:  t_s,el_deg,margin_db
+    where margin_db is LM_ebno from link_budget().  The packetizer picks the
+    Reed-Solomon check-byte count of each frame from the margin at its
+    transmit time.  A live tracker can stream the same rows to its stdin.
+
+    Parameters
+    ----------
+    passes : list  pass records from find_passes
+    path   : str   output CSV file
+
+    Returns
+    -------
+    int
+        Number of samples written.
+    """
+    n = 0
+    with open(path, "w") as f:
+        f.write("# Elevation / link-margin profile -- generated by adcs_skissue.py\n")
+        f.write("t_s,el_deg,margin_db\n")
+        for p in passes:
+            prof   = np.array(p["profile"])
+            margin = link_budget(prof[:, 1])["LM_ebno"]
+            for t, el, lm in zip(prof[:, 0], prof[:, 1], margin):
+                f.write(f"{t:.1f},{el:.2f},{lm:.2f}\n")
+            n += len(prof)
+    return n
+
+
+# ==============================================================================
+# SECTION 15 -- LORA RATE ADAPTATION
+#
+# link_budget() is calibrated for SF12 / 125 kHz / CR4/5.  Other settings are
+# referred to it through the SX1276 demodulator SNR floor: every SF step down
+# needs 2.5 dB more SNR, and doubling the bandwidth doubles the noise (+3 dB).
+# The datasheet sensitivity does not depend on CR, so CR only costs airtime.
+# ==============================================================================
+
+LORA_SNR_REQ = {7: -7.5, 8: -10.0, 9: -12.5, 10: -15.0, 11: -17.5, 12: -20.0}
+LORA_SF_OPTIONS = (7, 8, 9, 10, 11, 12)
+LORA_BW_OPTIONS = (125.0, 250.0, 500.0)   # 62.5 kHz is too narrow for +/-11 kHz Doppler
+LORA_CR_OPTIONS = (1, 2, 3, 4)
+
+
+def lora_link_margin(el_deg, sf, bw_khz, cr=1):
+    """
+    Eb/N0-equivalent link margin for arbitrary LoRa settings.
+
+    Equal to link_budget(el)["LM_ebno"] for SF12 / 125 kHz and offset by
+    the change in demodulator SNR floor and noise bandwidth otherwise.
+
+    Parameters
+    ----------
+    el_deg : float or np.ndarray  elevation [deg]
+    sf     : int                  spreading factor (7-12)
+    bw_khz : float                bandwidth [kHz]
+    cr     : int                  coding rate index (no effect on sensitivity)
+
+    Returns
+    -------
+    float or np.ndarray
+        Link margin [dB].
+    """
+    return (link_budget(el_deg)["LM_ebno"]
+            + (SNR_REQ - LORA_SNR_REQ[sf])
+            - 10.0 * np.log10(bw_khz * 1e3 / B_RX))
+
+
+def lora_rate_options(n_bytes=255, sfs=LORA_SF_OPTIONS, bws=LORA_BW_OPTIONS,
+                      crs=LORA_CR_OPTIONS):
+    """
+    Useful SF/BW/CR combinations, sorted from slowest to fastest goodput.
+
+    Goodput is payload bits per second of Time-on-Air for n_bytes packets,
+    so the ranking includes preamble and header overhead, not just the raw
+    LoRa bit rate.  Options that are both slower and less robust than some
+    other option are dropped, so along the returned list goodput rises and
+    link margin falls monotonically.
+
+    lora_link_margin() gives CR no sensitivity gain, so CR4/6..4/8 are
+    always dominated by CR4/5 at the same SF/BW and every returned option
+    is CR4/5.  The CR column is kept for a link model that credits coding
+    gain.
+
+    Returns
+    -------
+    list of dicts with keys  sf, bw_khz, cr, toa_s, goodput_bps
+    """
+    opts = []
+    for sf in sfs:
+        for bw in bws:
+            for cr in crs:
+                toa = lora_toa(n_bytes, sf=sf, bw_khz=bw, cr=cr)
+                opts.append({"sf": sf, "bw_khz": bw, "cr": cr, "toa_s": toa,
+                             "goodput_bps": n_bytes * 8 / toa,
+                             # margin offsets do not depend on elevation
+                             "margin_90": lora_link_margin(90.0, sf, bw, cr)})
+
+    kept, best_margin = [], -np.inf
+    for o in sorted(opts, key=lambda o: -o["goodput_bps"]):
+        if o["margin_90"] > best_margin:
+            kept.append(o)
+            best_margin = o["margin_90"]
+    return kept[::-1]
+
+
+def rate_schedule_for_pass(p, margin_db=0.0, min_dwell_s=30.0, n_bytes=255,
+                           crs=LORA_CR_OPTIONS):
+    """
+    Build the SF/BW/CR switching schedule for one pass.
+
+    Algorithm:
+      1. For every profile sample, pick the fastest option whose margin
+         (lora_link_margin) is >= margin_db.  Samples where even the slowest
+         option fails keep the slowest option (the link is simply closed).
+      2. Erode the choice with a min_dwell_s sliding minimum, so every
+         setting is held for at least the dwell time and is safe for the
+         whole window -- both ends switch rarely and never into a fade.
+      3. Merge consecutive samples with the same setting into segments.
+
+    Parameters
+    ----------
+    p           : dict   one pass record from find_passes
+    margin_db   : float  required link margin                 [dB]
+    min_dwell_s : float  minimum time between switches        [s]
+    n_bytes     : int    packet size used to rank goodput     [bytes]
+    crs         : tuple  coding rates allowed; with the current link model
+                         CR is always 4/5 (see lora_rate_options)
+
+    Returns
+    -------
+    segments : list of dicts  t_s, t_rel_s, sf, bw_khz, cr, margin_db
+    bytes_adaptive : float    payload bytes per pass following the schedule
+    bytes_fixed    : float    payload bytes at fixed SF12/125 kHz/CR4/5
+    """
+    opts = lora_rate_options(n_bytes, crs=crs)
+    prof = np.array(p["profile"])
+    t, el = prof[:, 0], prof[:, 1]
+    dt_s = t[1] - t[0] if len(t) > 1 else 10.0
+
+    # 1. Fastest feasible option per sample (index into opts)
+    ok = np.array([lora_link_margin(el, o["sf"], o["bw_khz"], o["cr"]) >= margin_db
+                   for o in opts])                       # (n_opts, n_samples)
+    best = np.where(ok.any(axis=0),
+                    len(opts) - 1 - np.argmax(ok[::-1], axis=0), 0)
+
+    # 2. Sliding minimum over the dwell window
+    half = int(np.ceil(min_dwell_s / dt_s / 2.0))
+    padded = np.pad(best, half, mode="edge")
+    chosen = np.min([padded[i:i + len(best)] for i in range(2 * half + 1)], axis=0)
+
+    # 3. Merge into segments
+    segments = []
+    for i, idx in enumerate(chosen):
+        if i == 0 or idx != chosen[i - 1]:
+            o = opts[idx]
+            segments.append({
+                "t_s"      : float(t[i]),
+                "t_rel_s"  : float(t[i] - t[0]),
+                "sf"       : o["sf"],
+                "bw_khz"   : o["bw_khz"],
+                "cr"       : o["cr"],
+                "margin_db": float(lora_link_margin(el[i], o["sf"], o["bw_khz"], o["cr"])),
+            })
+
+    open_adapt = ok[chosen, np.arange(len(chosen))]
+    bytes_adaptive = float(np.sum(np.where(
+        open_adapt, [opts[i]["goodput_bps"] for i in chosen], 0.0)) * dt_s / 8.0)
+
+    ref_ok = lora_link_margin(el, 12, 125.0, 1) >= margin_db
+    ref_bps = n_bytes * 8 / lora_toa(n_bytes)
+    bytes_fixed = float(np.count_nonzero(ref_ok) * dt_s * ref_bps / 8.0)
+    return segments, bytes_adaptive, bytes_fixed
+
+
+def write_rate_schedule(passes, csv_path=None, header_path=None, **kwargs):
+    """
+    Write the per-pass LoRa switching schedule for both ends of the link.
+
+    csv_path    : ground receiver table
+                  pass,t_s,t_rel_s,sf,bw_khz,cr,margin_db
+    header_path : C header for the beacon firmware and the ground sketch
+                  (lora_rate_schedule.h), stored in PROGMEM
+
+    Times in the header are seconds after AOS; the sketches start counting
+    when the pass is armed.  kwargs are passed to rate_schedule_for_pass.
+
+    Returns
+    -------
+    (total_adaptive_bytes, total_fixed_bytes) over all passes
+    """
+    rows, tot_a, tot_f = [], 0.0, 0.0
+    for i, p in enumerate(passes, 1):
+        segs, b_a, b_f = rate_schedule_for_pass(p, **kwargs)
+        tot_a += b_a
+        tot_f += b_f
+        rows += [(i, s) for s in segs]
+
+    if csv_path:
+        with open(csv_path, "w") as f:
+            f.write("# LoRa rate schedule -- generated by adcs_skissue.py\n")
+            f.write("pass,t_s,t_rel_s,sf,bw_khz,cr,margin_db\n")
+            for i, s in rows:
+                f.write(f"{i},{s['t_s']:.1f},{s['t_rel_s']:.1f},{s['sf']},"
+                        f"{s['bw_khz']:g},{s['cr']},{s['margin_db']:.2f}\n")
+
+    if header_path:
+        with open(header_path, "w") as f:
+            f.write("// LoRa rate schedule -- generated by adcs_skissue.py --rate-header.\n")
+            f.write("// Do not edit; regenerate after changing the orbit or link budget.\n")
+            f.write("// CR stays at 4/5: the link model gives higher CRs no margin, only airtime.\n")
+            gain = tot_a / tot_f if tot_f > 0 else float("inf")
+            f.write(f"// {len(passes)} passes: {tot_a/1e3:.1f} kB per week adaptive vs "
+                    f"{tot_f/1e3:.1f} kB at fixed SF12/125 kHz ({gain:.2f}x).\n")
+            if all(s["sf"] == 12 and s["bw_khz"] == 125.0 for _, s in rows):
+                f.write("// Every step is SF12/125 kHz: no faster setting keeps a non-negative\n"
+                        "// margin for the minimum dwell in any of these passes.\n")
+            f.write("#ifndef LORA_RATE_SCHEDULE_H\n#define LORA_RATE_SCHEDULE_H\n\n")
+            f.write("#include <Arduino.h>\n\n")
+            f.write("typedef struct {\n")
+            f.write("  uint16_t pass;     // Pass number (1-indexed)\n")
+            f.write("  uint16_t t_rel_s;  // Seconds after AOS\n")
+            f.write("  uint8_t  sf;       // Spreading factor\n")
+            f.write("  uint16_t bw_khz;   // Bandwidth [kHz]\n")
+            f.write("  uint8_t  cr;       // Coding rate denominator (4/cr)\n")
+            f.write("} lora_rate_step_t;\n\n")
+            f.write(f"const uint16_t LORA_RATE_STEPS = {len(rows)};\n")
+            f.write("const lora_rate_step_t LORA_RATE_SCHEDULE[] PROGMEM = {\n")
+            for i, s in rows:
+                f.write(f"  {{ {i}, {int(s['t_rel_s'])}, {s['sf']}, "
+                        f"{int(s['bw_khz'])}, {s['cr'] + 4} }},\n")
+            f.write("};\n\n#endif\n")
+    return tot_a, tot_f
+
+
+# ==============================================================================
+# SECTION 16 -- PASS REPLAY
+#
+# Plays the packetizer's KISS output through a week of passes.  The geometry
+# of every pass is evaluated at 1 s steps in one numpy batch, the SNR of each
+# second comes from link_budget(), and every FX.25 frame sent succeeds or
+# fails at the bit error rate of the second it is sent in.  Frames the ground
+# missed are sent again in the next pass (the ground reports them over the
+# uplink in between), so the replay shows how long an image takes to arrive.
+# ==============================================================================
+
+FX25_FRAME_BYTES = 263     # correlation tag (8) + RS codeword (255)
+FX25_TAG_MAX_ERRORS = 12   # tag bit errors tolerated by the receiver
+AX25_OVERHEAD = 18         # addresses, control, PID and FCS
+FX25_TAGS = {              # correlation tag -> RS check bytes (satellite_packetizer.c)
+    bytes([0x3E, 0x2F, 0x53, 0x8A, 0xDF, 0xB7, 0x4D, 0xB7]): 16,
+    bytes([0xCC, 0x8F, 0x8A, 0xE4, 0x85, 0xE2, 0x98, 0x01]): 32,
+    bytes([0x36, 0x28, 0xAE, 0xDE, 0x13, 0x0C, 0xDB, 0x3A]): 64,
+}
+REPLAY_SEED = 1
+
+
+def ax25_fcs(data):
+    """CCITT CRC-16 of an AX.25 frame, as calculate_crc() in the packetizer."""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc ^ 0xFFFF
+
+
+def read_fx25_kiss(path):
+    """
+    Read the FX.25 frames of a packetizer KISS file.
+
+    Returns
+    -------
+    nroots  : np.ndarray (int)  RS check bytes of each frame
+    payload : np.ndarray (int)  AX.25 payload bytes carried by each frame
+    """
+    with open(path, "rb") as f:
+        raw = f.read()
+    nroots, payload = [], []
+    for chunk in raw.split(b"\xc0"):
+        if len(chunk) < 2 or chunk[0] != 0x00:
+            continue
+        frame = chunk[1:].replace(b"\xdb\xdc", b"\xc0").replace(b"\xdb\xdd", b"\xdb")
+        if len(frame) != FX25_FRAME_BYTES:
+            raise ValueError(f"{path}: {len(frame)}-byte frame; only plain FX.25 "
+                             f"output ({FX25_FRAME_BYTES} bytes) can be replayed")
+        n = FX25_TAGS.get(frame[:8])
+        if n is None:
+            raise ValueError(f"{path}: unknown FX.25 correlation tag")
+        data = frame[8:8 + 255 - n]
+        last = len(data.rstrip(b"\x00"))
+        for length in range(max(last, AX25_OVERHEAD), min(last + 3, len(data)) + 1):
+            fcs = ax25_fcs(data[:length - 2])
+            if data[length - 2] == fcs & 0xFF and data[length - 1] == fcs >> 8:
+                break
+        else:
+            raise ValueError(f"{path}: frame {len(nroots) + 1} has no valid AX.25 FCS")
+        nroots.append(n)
+        payload.append(length - AX25_OVERHEAD)
+    return np.array(nroots, dtype=int), np.array(payload, dtype=int)
+
+
+def binomial_cdf(n, k_max, p):
+    """P(X <= k_max) for X ~ Binomial(n, p), for an array of p."""
+    p = np.clip(np.asarray(p, dtype=float), 1e-300, 1.0 - 1e-16)[:, None]
+    k = np.arange(k_max + 1)
+    log_comb = np.array([math.lgamma(n + 1) - math.lgamma(i + 1) - math.lgamma(n - i + 1)
+                         for i in k])
+    return np.exp(log_comb + k * np.log(p) + (n - k) * np.log1p(-p)).sum(axis=1)
+
+
+def fx25_frame_error_rate(ber, nroots):
+    """
+    Probability that an FX.25 frame is lost at bit error rate ber.
+
+    The frame is lost if the tag has more than FX25_TAG_MAX_ERRORS bit errors
+    or the codeword more than nroots/2 byte errors.
+    """
+    p_byte = 1.0 - (1.0 - np.asarray(ber)) ** 8
+    p_tag  = binomial_cdf(64, FX25_TAG_MAX_ERRORS, ber)
+    return 1.0 - p_tag * binomial_cdf(255, nroots // 2, p_byte)
+
+
+def replay_passes(passes, ic, nroots, payload, rng, sf=12, bw_khz=125.0, cr=1):
+    """
+    Replay a packetizer KISS stream over the passes of one IC.
+
+    Frames are sent back to back at the TX share of the beacon cycle, from
+    AOS to LOS, in order, but only those the ground is still missing.  The
+    Eb/N0 of each second is link_budget() margin + EBN0_THR, converted to a
+    bit error rate with the coherent BPSK curve (as fer_simulator does).
+
+    Parameters
+    ----------
+    passes      : list        pass records from find_passes
+    ic          : dict        one entry from INITIAL_CONDITIONS
+    nroots      : np.ndarray  RS check bytes of each frame (read_fx25_kiss)
+    payload     : np.ndarray  payload bytes of each frame
+    rng         : np.random.Generator
+    sf, bw_khz, cr            LoRa settings of the downlink
+
+    Returns
+    -------
+    list of dicts, one per pass, with keys
+      start_s, day, max_el_deg, sent, delivered, bytes, total_bytes
+    """
+    if not passes:
+        return []
+    # 1. Per-second geometry and bit error rate of every pass, in one batch
+    t_pass = [np.arange(p["start_s"], p["end_s"] + 1.0, 1.0) for p in passes]
+    t_all  = np.concatenate(t_pass)
+    ebn0   = 10.0 ** ((link_budget(elevation_series(t_all, ic))["LM_ebno"] + EBN0_THR) / 10.0)
+    ber    = 0.5 * np.vectorize(math.erfc)(np.sqrt(ebn0))
+    splits = np.cumsum([len(t) for t in t_pass])[:-1]
+
+    # 2. Airtime of one frame (split into SX127x packets) and its slot period
+    t_frame = (lora_toa(255, sf, bw_khz, cr)
+               + lora_toa(FX25_FRAME_BYTES - 255, sf, bw_khz, cr))
+
+    pending = np.arange(len(payload))
+    total, rows = 0, []
+    for p, ber_pass in zip(passes, np.split(ber, splits)):
+        opt    = beacon_optimiser(pass_dur_s=p["dur_s"])
+        slot_s = t_frame * opt["cycle_s"] / opt["x_s"]
+        n_slot = int(len(ber_pass) // slot_s) if len(pending) else 0
+        # Once fewer frames are missing than the pass has slots, they are
+        # repeated cyclically, so each one also gets the high-elevation slots.
+        sent   = np.resize(pending, n_slot)
+        # Each frame sees the bit error rate at the middle of its slot
+        idx    = np.minimum(((np.arange(n_slot) + 0.5) * slot_s).astype(int), len(ber_pass) - 1)
+        fer    = np.empty(n_slot)
+        for n in np.unique(nroots[sent]):
+            m = nroots[sent] == n
+            fer[m] = fx25_frame_error_rate(ber_pass[idx[m]], n)
+        ok      = rng.random(n_slot) >= fer
+        got_idx = np.unique(sent[ok])
+        got     = int(payload[got_idx].sum())
+        total  += got
+        pending = pending[~np.isin(pending, got_idx)]
+        rows.append({"start_s": p["start_s"], "day": p["day"], "max_el_deg": p["max_el_deg"],
+                     "sent": n_slot, "delivered": len(got_idx),
+                     "bytes": got, "total_bytes": total})
+    return rows
+
+
+def run_replay(kiss_path, csv_path=None, sim_days=7):
+    """
+    Replay a packetizer output file over every IC and print a summary.
+
+    csv_path : optional per-pass table
+               ic,pass,start_s,max_el_deg,sent,delivered,bytes,total_bytes
+    """
+    nroots, payload = read_fx25_kiss(kiss_path)
+    image = int(payload.sum())
+    print(f"  {kiss_path}: {len(payload)} FX.25 frames, {image} payload bytes")
+    sep("-")
+    print(f"  {'IC':>4}  {'Passes':>6}  {'Useful':>6}  {'Sent':>6}  {'Wasted':>6}  "
+          f"{'Bytes':>8}  {'B/useful pass':>13}  {'Done':>6}  Complete at")
+    sep("-")
+
+    rng  = np.random.default_rng(REPLAY_SEED)
+    csv  = open(csv_path, "w") if csv_path else None
+    if csv:
+        csv.write("# Pass replay -- generated by adcs_skissue.py --replay\n")
+        csv.write("ic,pass,start_s,max_el_deg,sent,delivered,bytes,total_bytes\n")
+    for idx, ic in enumerate(INITIAL_CONDITIONS, 1):
+        passes = find_passes(ic, sim_days=sim_days, dt_s=10.0)
+        rows   = replay_passes(passes, ic, nroots, payload, rng)
+        if csv:
+            for i, r in enumerate(rows, 1):
+                csv.write(f"{idx},{i},{r['start_s']:.1f},{r['max_el_deg']:.2f},{r['sent']},"
+                          f"{r['delivered']},{r['bytes']},{r['total_bytes']}\n")
+        total  = rows[-1]["total_bytes"] if rows else 0
+        useful = [r for r in rows if r["bytes"] > 0]
+        sent   = sum(r["sent"] for r in rows)
+        wasted = sent - sum(r["delivered"] for r in rows)   # lost or repeated
+        done   = next((r for r in rows if r["total_bytes"] >= image), None)
+        when   = f"day {done['day']} {hhmm(done['start_s'])}" if done else f"not in {sim_days} days"
+        per    = total / len(useful) if useful else 0.0
+        print(f"  IC-{idx:<1}  {len(rows):>6}  {len(useful):>6}  {sent:>6}  {wasted:>6}  "
+              f"{total:>8}  {per:>13.0f}  {100.0 * total / image:>5.1f}%  {when}")
+    if csv:
+        csv.close()
+        print(f"  Per-pass table -> {csv_path}")
+
+
 # ==============================================================================
-# SECTION 10 -- PRINT / REPORT HELPERS
+# SECTION 17 -- PRINT / REPORT HELPERS
 # ==============================================================================
 
 def hhmm(t_s):
@@ -868,14 +3115,105 @@ def print_beacon_for_ic(passes):
     print( '      "CMD=PING TS=20260324T120000Z RELAY=Hello_from_Pilani_GS!"')
 
 
+def print_beacon_sweep(grid, front, elapsed_s):
+    """
+    Print the Pareto set of beacon_sweep(): the best trade-offs between
+    uplink bytes per pass, hit probability and beacon energy.
+    """
+    n = len(grid["sf"])
+    print(f"  {n} combinations ({int(grid['feasible'].sum())} feasible) swept in "
+          f"{elapsed_s*1e3:.0f} ms; {len(front)} on the Pareto front")
+    print()
+    print(f"  {'SF':>3} {'BW':>4} {'CR':>4} {'DL_B':>5} {'UL_B':>5} {'guard':>6} "
+          f"{'cycle':>7} {'wins':>6} {'UL_B/pass':>10} {'P(hit)%':>8} {'Wh/day':>7}")
+    sep("-", 77)
+    for k in front:
+        print(f"  {grid['sf'][k]:>3} {grid['bw_khz'][k]:>4.0f} {'4/' + str(4 + grid['cr'][k]):>4} "
+              f"{grid['dl_bytes'][k]:>5} {grid['ul_bytes'][k]:>5} {grid['guard_s'][k]:>6.1f} "
+              f"{grid['cycle_s'][k]:>7.2f} {grid['windows_pass'][k]:>6.1f} "
+              f"{grid['ul_bytes_pass'][k]:>10.0f} {grid['p_hit_pct'][k]:>7.1f}% "
+              f"{grid['energy_wh_day'][k]:>7.3f}")
+
+
+def print_contacts(passes, start_jd):
+    """
+    Print the merged contact table of plan_contacts(), all stations and
+    satellites in AOS order.
+
+    Each row shows: contact index, station, satellite, AOS/LOS in UTC,
+    duration, peak elevation, AOS/LOS azimuths and the Eb/N0 link margin at
+    the peak.
+    """
+    if not passes:
+        print("  No contacts found.\n")
+        return
+
+    print(f"  {'#':>5}  {'Station':<12}  {'Satellite':<20}  {'AOS (UTC)':<19}  {'LOS':>8}  "
+          f"{'Dur(s)':>7}  {'MaxEl':>6}  {'AzAOS':>6}  {'AzLOS':>6}  {'LM_EbNo':>8}")
+    sep("-", 117)
+    for i, p in enumerate(passes, 1):
+        aos = datetime_from_jd(start_jd + p["start_s"] / 86400.0)
+        los = datetime_from_jd(start_jd + p["end_s"] / 86400.0)
+        lb  = link_budget(p["max_el_deg"])
+        print(f"  {i:>5}  {p['gs'][:12]:<12}  {p['name'][:20]:<20}  {aos:%Y-%m-%d %H:%M:%S}  "
+              f"{los:%H:%M:%S}  {p['dur_s']:>7.0f}  {p['max_el_deg']:>6.1f}  "
+              f"{p['az_rise']:>6.1f}  {p['az_set']:>6.1f}  {lb['LM_ebno']:>8.2f}")
+    print()
+
+
+def run_tracking(args, passes, start, state, look, names=None):
+    """
+    Write the --doppler schedule and run the --rigctld and --rotctld feeds
+    (together, each in its own thread) for the passes.
+
+    state, look : as doppler_schedule() and rotor_ephemeris() take them
+    """
+    epoch = start.replace(tzinfo=datetime.timezone.utc).timestamp()
+    feeds = []
+    if args.doppler or args.rigctld:
+        sched = doppler_schedule(passes, state, args.doppler_rate)
+        if args.doppler:
+            n = write_doppler_schedule(sched, args.doppler, start)
+            print(f"  {n} samples at {args.doppler_rate:g} Hz, max |Doppler| "
+                  f"{np.max(np.abs(sched['doppler_hz']), initial=0.0)/1e3:.2f} kHz, max rate "
+                  f"{np.max(np.abs(sched['doppler_rate_hz_s']), initial=0.0):.1f} Hz/s "
+                  f"-> {args.doppler}")
+        if args.rigctld:
+            host, _, port = args.rigctld.partition(":")
+            feeds.append((stream_doppler, (sched, passes, epoch, host or "localhost",
+                                           int(port) if port else RIGCTLD_PORT, names)))
+    if args.rotctld:
+        ephem = rotor_ephemeris(passes, look)
+        n_key = sum(e["keyhole"] for e in ephem)
+        n_fold = sum(e["fold"] for e in ephem)
+        print(f"  Rotor ephemeris: {len(ephem)} passes, {n_key} key-hole, "
+              f"{n_fold} unwinding at the stop")
+        host, _, port = args.rotctld.partition(":")
+        feeds.append((track_rotor, (ephem, passes, epoch, host or "localhost",
+                                    int(port) if port else ROTCTLD_PORT, args.rotor_rate, names)))
+
+    threads = [threading.Thread(target=f, args=a, daemon=True) for f, a in feeds[1:]]
+    for th in threads:
+        th.start()
+    if feeds:
+        feeds[0][0](*feeds[0][1])
+    for th in threads:
+        th.join()
+    print()
+
+
 # ==============================================================================
-# SECTION 11 -- MAIN
+# SECTION 18 -- MAIN
 # ==============================================================================
 
 def main():
     """
     Entry point.  All output goes to stdout.
 
+    With --schedule, --profile, --rate-schedule or --rate-header only the
+    requested files for one IC (--ic, default 1) are written and the full
+    report is skipped.  --replay prints only the pass replay summary.
+
     Output order:
       1. Link budget table      -- elevation-dependent only; same for all ICs
       2. LoRa ToA table         -- same for all ICs
@@ -885,6 +3223,166 @@ def main():
            c. Beacon timing recommendations
       4. Cross-IC comparison table
     """
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[4])
+    parser.add_argument("--schedule", metavar="PATH",
+                        help="write the packetizer pass schedule CSV and exit")
+    parser.add_argument("--profile", metavar="PATH",
+                        help="write the packetizer elevation/margin profile CSV and exit")
+    parser.add_argument("--rate-schedule", metavar="PATH",
+                        help="write the per-pass LoRa SF/BW/CR schedule CSV and exit")
+    parser.add_argument("--rate-header", metavar="PATH",
+                        help="write the same schedule as a C header for the sketches")
+    parser.add_argument("--replay", metavar="KISS",
+                        help="replay packetizer FX.25 output over a week of passes and exit")
+    parser.add_argument("--replay-csv", metavar="PATH",
+                        help="with --replay, also write the per-pass table")
+    parser.add_argument("--tle", metavar="PATH",
+                        help="predict passes of every satellite in a TLE file and exit")
+    parser.add_argument("--stations", metavar="PATH",
+                        help="with --tle, ground stations (name,lat_deg,lon_deg,alt_m per line; "
+                             "default Pilani)")
+    parser.add_argument("--contacts", metavar="PATH",
+                        help="with --tle, also write the merged contact table CSV")
+    parser.add_argument("--workers", type=int, default=None,
+                        help="with --tle, worker processes (default: one per core)")
+    parser.add_argument("--start", metavar="UTC",
+                        help="with --tle, window start as ISO UTC (default: now)")
+    parser.add_argument("--days", type=float, default=7.0,
+                        help="with --tle, window length in days (default 7)")
+    parser.add_argument("--doppler", metavar="PATH",
+                        help="write the Doppler schedule CSV of the passes (--ic, or --tle "
+                             "at the first station) and exit")
+    parser.add_argument("--doppler-rate", type=float, default=DOPPLER_RATE_HZ, metavar="HZ",
+                        help=f"Doppler schedule sample rate, 1-10 Hz (default {DOPPLER_RATE_HZ:g})")
+    parser.add_argument("--rigctld", metavar="HOST[:PORT]",
+                        help="tune a radio through rigctld live over the passes")
+    parser.add_argument("--rigctld-stub", type=int, nargs="?", const=RIGCTLD_PORT, metavar="PORT",
+                        help=f"run a stand-in rigctld for testing (default port {RIGCTLD_PORT})")
+    parser.add_argument("--rotctld", metavar="HOST[:PORT]",
+                        help="steer an antenna rotor through rotctld live over the passes")
+    parser.add_argument("--rotor-rate", type=float, default=ROTOR_LOOP_HZ, metavar="HZ",
+                        help=f"rotor control loop rate (default {ROTOR_LOOP_HZ:g})")
+    parser.add_argument("--rotctld-stub", type=int, nargs="?", const=ROTCTLD_PORT, metavar="PORT",
+                        help=f"run a simulated rotor behind rotctld (default port {ROTCTLD_PORT})")
+    parser.add_argument("--beacon-sweep", action="store_true",
+                        help="sweep beacon timing over SF/BW/CR/payload/guard and print the Pareto front")
+    parser.add_argument("--beacon-csv", metavar="PATH",
+                        help="with --beacon-sweep: write every combination to PATH")
+    parser.add_argument("--ic", type=int, default=1,
+                        choices=range(1, len(INITIAL_CONDITIONS) + 1),
+                        help="initial condition used for --schedule/--profile/--beacon-sweep (default 1)")
+    args = parser.parse_args()
+    if not 1.0 <= args.doppler_rate <= 10.0:
+        parser.error("--doppler-rate must be between 1 and 10 Hz")
+    if args.rotor_rate <= 0.0:
+        parser.error("--rotor-rate must be positive")
+
+    if args.rigctld_stub is not None:
+        rigctld_stub(args.rigctld_stub)
+        return
+    if args.rotctld_stub is not None:
+        rotctld_stub(args.rotctld_stub)
+        return
+
+    if args.tle:
+        tles     = read_tle_file(args.tle)
+        stations = read_station_file(args.stations) if args.stations else [ground_station()]
+        start    = utc_datetime(args.start)
+        start_jd = jd_from_datetime(start)
+        engine   = "C kernel" if sgp4_kernel() else "numpy"
+        print()
+        print(f"  CONTACT PLAN -- {len(tles)} objects x {len(stations)} stations, "
+              f"{args.days:g} days from {start:%Y-%m-%d %H:%M} UTC  (SGP4, {engine})")
+        t0 = datetime.datetime.now()
+        passes, skipped = plan_contacts(tles, stations, start_jd, days=args.days,
+                                        workers=args.workers)
+        elapsed = (datetime.datetime.now() - t0).total_seconds()
+        print(f"  {len(passes)} contacts found in {elapsed:.1f} s.")
+        for gs in stations:
+            n = sum(1 for p in passes if p["gs"] == gs["name"])
+            print(f"    {gs['name']:<16} {n:>6} contacts")
+        if skipped:
+            print(f"  Skipped {len(skipped)} deep-space objects (period >= "
+                  f"{SGP4_DEEP_SPACE_MIN:.0f} min, SDP4 not modelled): "
+                  + ", ".join(skipped[:5]) + (" ..." if len(skipped) > 5 else ""))
+        print()
+        if args.doppler or args.rigctld or args.rotctld:
+            # The radio and rotor are at the first station
+            passes = [p for p in passes if p["gs"] == stations[0]["name"]]
+            coef, epoch_jd, _ = sgp4_init(tles)
+            sat = np.array([p["sat"] for p in passes], dtype=int)
+            vec = [stations[0][k][:, None] for k in GS_VECTORS]
+
+            def state(idx, t):
+                return tle_relative_state(coef, epoch_jd, start_jd, sat[idx], t, vec[0])
+
+            def look(idx, t):
+                pos, vel = tle_ecef_samples(coef, epoch_jd, start_jd, sat[idx], t)
+                return topocentric(pos, vel, *vec)[:2]
+
+            run_tracking(args, passes, start, state, look, [p["name"] for p in passes])
+        elif args.contacts:
+            write_contact_table(passes, args.contacts, start_jd)
+            print(f"  Contact table -> {args.contacts}")
+            print()
+        else:
+            print_contacts(passes, start_jd)
+        return
+
+    if args.doppler or args.rigctld or args.rotctld:
+        ic     = INITIAL_CONDITIONS[args.ic - 1]
+        start  = utc_datetime(args.start)
+        passes = find_passes(ic, sim_days=args.days, dt_s=10.0)
+        print()
+        print(f"  {ic['name']}")
+        print(f"  {len(passes)} passes in {args.days:g} days, t = 0 at {start:%Y-%m-%d %H:%M:%S} UTC")
+        run_tracking(args, passes, start,
+                     lambda idx, t: kepler_relative_state(t, ic),
+                     lambda idx, t: look_angles_series(t, ic)[:2])
+        return
+
+    if args.beacon_sweep:
+        ic     = INITIAL_CONDITIONS[args.ic - 1]
+        passes = find_passes(ic, sim_days=7, dt_s=10.0)
+        print()
+        print(f"  BEACON TIMING SWEEP -- {ic['name']}, {len(passes)} passes in 7 days")
+        t0 = time.perf_counter()
+        grid, front = beacon_sweep(passes)
+        print_beacon_sweep(grid, front, time.perf_counter() - t0)
+        if args.beacon_csv:
+            n = write_beacon_sweep(grid, front, args.beacon_csv)
+            print(f"  {n} combinations -> {args.beacon_csv}")
+        print()
+        return
+
+    if args.replay:
+        print()
+        print("  PASS REPLAY -- 7 days, all initial conditions")
+        run_replay(args.replay, args.replay_csv)
+        print()
+        return
+
+    if args.schedule or args.profile or args.rate_schedule or args.rate_header:
+        ic     = INITIAL_CONDITIONS[args.ic - 1]
+        passes = find_passes(ic, sim_days=7, dt_s=10.0)
+        print(f"  {ic['name']}")
+        if args.schedule:
+            total = write_pass_schedule(passes, args.schedule)
+            print(f"  {len(passes)} passes, {total:.0f} s downlink airtime "
+                  f"-> {args.schedule}")
+        if args.profile:
+            n = write_link_profile(passes, args.profile)
+            print(f"  {n} elevation samples -> {args.profile}")
+        if args.rate_schedule or args.rate_header:
+            b_a, b_f = write_rate_schedule(passes, args.rate_schedule,
+                                           args.rate_header)
+            gain = b_a / b_f if b_f > 0 else float("inf")
+            print(f"  Adaptive SF/BW: {b_a/1e3:.1f} kB per week vs "
+                  f"{b_f/1e3:.1f} kB at fixed SF12/125 kHz  ({gain:.2f}x)")
+            for path in (args.rate_schedule, args.rate_header):
+                if path:
+                    print(f"  Rate schedule -> {path}")
+        return
 
     # ------------------------------------------------------------------
     # 1 & 2. Tables that depend only on RF parameters, not on orbit choice
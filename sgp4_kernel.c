@@ -0,0 +1,177 @@
+/**
+ * @file sgp4_kernel.c
+ * @brief Batched SGP4 propagation for adcs_skissue.py.
+ *
+ * adcs_skissue.py initialises every satellite from its TLE (sgp4_init) and
+ * hands the coefficient table to this kernel, which propagates every
+ * satellite to its row of times. It is the same near-Earth SGP4 as
+ * sgp4_propagate_numpy(), one sample at a time instead of one array
+ * operation at a time, so it keeps the working set in registers.
+ *
+ * Optional: without the library the script falls back to numpy.
+ *
+ * Build (next to adcs_skissue.py):
+ *   gcc -O3 -shared -fPIC sgp4_kernel.c -o sgp4_kernel.so -lm
+ */
+
+#include <math.h>
+
+// =============================================================================
+// Constants
+// =============================================================================
+
+// WGS-72, as in adcs_skissue.py (SGP4_*)
+#define SGP4_MU     398600.8
+#define SGP4_RE_KM  6378.135
+#define SGP4_J2     0.001082616
+
+// WHY: Column order of the coefficient table, which must match SGP4_FIELDS in
+// adcs_skissue.py; sgp4_num_fields() lets the script check it.
+enum {
+    F_NO, F_AO, F_ECCO, F_INCLO, F_MO, F_ARGPO, F_NODEO, F_BSTAR,
+    F_MDOT, F_ARGPDOT, F_NODEDOT, F_NODECF, F_CC1, F_CC4, F_CC5,
+    F_T2COF, F_T3COF, F_T4COF, F_T5COF, F_D2, F_D3, F_D4,
+    F_OMGCOF, F_XMCOF, F_ETA, F_DELMO, F_SINMAO,
+    F_AYCOF, F_XLCOF, F_CON41, F_X1MTH2, F_X7THM1,
+    SGP4_NUM_FIELDS
+};
+
+
+// =============================================================================
+// Propagation
+// =============================================================================
+
+int sgp4_num_fields(void) {
+    return SGP4_NUM_FIELDS;
+}
+
+/**
+ * @brief Propagates one satellite to one time.
+ * @param c Coefficients of the satellite (one row of the table).
+ * @param t Minutes from the TLE epoch.
+ * @param r Position [km] in TEME.
+ * @param v Velocity [km/s] in TEME.
+ * @return 0, or -1 if the satellite has decayed or the elements are invalid.
+ */
+static int sgp4_point(const double* c, double t, double r[3], double v[3]) {
+    const double twopi = 2.0 * M_PI;
+    const double xke = 60.0 / sqrt(SGP4_RE_KM * SGP4_RE_KM * SGP4_RE_KM / SGP4_MU);
+
+    // --- Secular gravity and drag ---
+    double xmdf = c[F_MO] + c[F_MDOT] * t;
+    double argpdf = c[F_ARGPO] + c[F_ARGPDOT] * t;
+    double nodedf = c[F_NODEO] + c[F_NODEDOT] * t;
+    double t2 = t * t, t3 = t2 * t, t4 = t2 * t2;
+    double nodem = nodedf + c[F_NODECF] * t2;
+    double delomg = c[F_OMGCOF] * t;
+    double delmtemp = 1.0 + c[F_ETA] * cos(xmdf);
+    double delm = c[F_XMCOF] * (delmtemp * delmtemp * delmtemp - c[F_DELMO]);
+    double mm = xmdf + delomg + delm;
+    double argpm = argpdf - delomg - delm;
+    double tempa = 1.0 - c[F_CC1] * t - c[F_D2] * t2 - c[F_D3] * t3 - c[F_D4] * t4;
+    double tempe = c[F_BSTAR] * c[F_CC4] * t + c[F_BSTAR] * c[F_CC5] * (sin(mm) - c[F_SINMAO]);
+    double templ = c[F_T2COF] * t2 + c[F_T3COF] * t3 + t4 * (c[F_T4COF] + t * c[F_T5COF]);
+
+    double am = c[F_AO] * tempa * tempa;
+    double nm = c[F_NO] / (tempa * tempa * tempa); // = xke / am^1.5
+    double em = c[F_ECCO] - tempe;
+    if (em >= 1.0 || em < -0.001) return -1;
+    if (em < 1e-6) em = 1e-6;
+    mm += c[F_NO] * templ;
+    double xlm = mm + argpm + nodem;
+    nodem = fmod(nodem, twopi);
+    argpm = fmod(argpm, twopi);
+    xlm = fmod(xlm, twopi);
+    mm = fmod(xlm - argpm - nodem, twopi);
+
+    // --- Long-period periodics ---
+    double sinip = sin(c[F_INCLO]), cosip = cos(c[F_INCLO]);
+    double axnl = em * cos(argpm);
+    double temp = 1.0 / (am * (1.0 - em * em));
+    double aynl = em * sin(argpm) + temp * c[F_AYCOF];
+    double xl = mm + argpm + nodem + temp * c[F_XLCOF] * axnl;
+
+    // --- Kepler's equation ---
+    double u = fmod(xl - nodem, twopi);
+    double eo1 = u, sineo1 = 0.0, coseo1 = 1.0, tem5 = 9999.9;
+    for (int ktr = 0; fabs(tem5) >= 1e-12 && ktr < 10; ktr++) {
+        sineo1 = sin(eo1);
+        coseo1 = cos(eo1);
+        tem5 = (u - aynl * coseo1 + axnl * sineo1 - eo1) / (1.0 - coseo1 * axnl - sineo1 * aynl);
+        if (tem5 > 0.95) tem5 = 0.95;
+        if (tem5 < -0.95) tem5 = -0.95;
+        eo1 += tem5;
+    }
+    sineo1 = sin(eo1);
+    coseo1 = cos(eo1);
+
+    // --- Short-period periodics ---
+    double ecose = axnl * coseo1 + aynl * sineo1;
+    double esine = axnl * sineo1 - aynl * coseo1;
+    double el2 = axnl * axnl + aynl * aynl;
+    double pl = am * (1.0 - el2);
+    if (pl < 0.0) return -1;
+    double rl = am * (1.0 - ecose);
+    double rdotl = sqrt(am) * esine / rl;
+    double rvdotl = sqrt(pl) / rl;
+    double betal = sqrt(1.0 - el2);
+    temp = esine / (1.0 + betal);
+    double sinu = am / rl * (sineo1 - aynl - axnl * temp);
+    double cosu = am / rl * (coseo1 - axnl + aynl * temp);
+    double su = atan2(sinu, cosu);
+    double sin2u = (cosu + cosu) * sinu;
+    double cos2u = 1.0 - 2.0 * sinu * sinu;
+    temp = 1.0 / pl;
+    double temp1 = 0.5 * SGP4_J2 * temp;
+    double temp2 = temp1 * temp;
+
+    double mrt = rl * (1.0 - 1.5 * temp2 * betal * c[F_CON41]) + 0.5 * temp1 * c[F_X1MTH2] * cos2u;
+    if (mrt < 1.0) return -1; // Decayed
+    su -= 0.25 * temp2 * c[F_X7THM1] * sin2u;
+    double xnode = nodem + 1.5 * temp2 * cosip * sin2u;
+    double xinc = c[F_INCLO] + 1.5 * temp2 * cosip * sinip * cos2u;
+    double mvt = rdotl - nm * temp1 * c[F_X1MTH2] * sin2u / xke;
+    double rvdot = rvdotl + nm * temp1 * (c[F_X1MTH2] * cos2u + 1.5 * c[F_CON41]) / xke;
+
+    // --- Orientation ---
+    double sinsu = sin(su), cossu = cos(su);
+    double snod = sin(xnode), cnod = cos(xnode);
+    double sini = sin(xinc), cosi = cos(xinc);
+    double xmx = -snod * cosi, xmy = cnod * cosi;
+    double ux = xmx * sinsu + cnod * cossu, uy = xmy * sinsu + snod * cossu, uz = sini * sinsu;
+    double vx = xmx * cossu - cnod * sinsu, vy = xmy * cossu - snod * sinsu, vz = sini * cossu;
+    double vkmpersec = SGP4_RE_KM * xke / 60.0;
+    r[0] = mrt * ux * SGP4_RE_KM;
+    r[1] = mrt * uy * SGP4_RE_KM;
+    r[2] = mrt * uz * SGP4_RE_KM;
+    v[0] = (mvt * ux + rvdot * vx) * vkmpersec;
+    v[1] = (mvt * uy + rvdot * vy) * vkmpersec;
+    v[2] = (mvt * uz + rvdot * vz) * vkmpersec;
+    return 0;
+}
+
+/**
+ * @brief Propagates every satellite to its row of times.
+ * @param coef Coefficient table, n_sat x n_fields, row-major.
+ * @param tsince Minutes from each satellite's epoch, n_sat x n_t, row-major.
+ * @param r Positions [km], 3 x n_sat x n_t; NaN where propagation failed.
+ * @param v Velocities [km/s], laid out like r.
+ */
+void sgp4_propagate(int n_sat, int n_t, int n_fields, const double* coef, const double* tsince,
+                    double* r, double* v) {
+    long plane = (long)n_sat * n_t;
+    for (int s = 0; s < n_sat; s++) {
+        const double* c = coef + (long)s * n_fields;
+        for (int j = 0; j < n_t; j++) {
+            long i = (long)s * n_t + j;
+            double ri[3], vi[3];
+            if (sgp4_point(c, tsince[i], ri, vi) < 0) {
+                ri[0] = ri[1] = ri[2] = vi[0] = vi[1] = vi[2] = NAN;
+            }
+            for (int k = 0; k < 3; k++) {
+                r[k * plane + i] = ri[k];
+                v[k * plane + i] = vi[k];
+            }
+        }
+    }
+}
@@ -1,38 +1,208 @@
 
 #include <RF24.h>
+#include <serial_frame.h>
+#include <channel_hop.h>
 
 // Set up nRF24L01 on pins 7 (CE) and 8 (CSN)
 RF24 radio(7, 8); 
 
 // A completely arbitrary 5-letter address for our radio pipe
 const byte address[6] = "AUDIO"; 
+// Hop announcements go to their own address (libraries/channel_hop)
+const byte hopAddress[6] = "AHOP0";
 
-// A buffer to hold exactly 32 bytes of audio
-byte payload[32]; 
+// A buffer to hold exactly 32 bytes of compressed audio (frames from the
+// Mac are COBS + CRC framed, see libraries/serial_frame)
+byte payload[SERIAL_FRAME_MAX_PAYLOAD]; 
+serial_frame_decoder_t link;
+unsigned long badFrames = 0;
+
+// 1: ignore the Mac and transmit test payloads flat out at 2 Mbps, printing
+// the throughput on the serial monitor. 0: normal audio streaming.
+#define TX_BENCHMARK 0
+
+// --- Burst transmit ---
+// writeFast() only waits while all three TX FIFO slots are full, so the radio
+// always has the next payload queued. The FIFO drains on its own (auto-ack is
+// off); txStandBy() is only called once no data has come in for a while.
+#define BURST_IDLE_MS 5
+#define STATS_INTERVAL_MS 1000
+bool burstOpen = false;
+unsigned long lastTxMs = 0;
+unsigned long txPayloads = 0;
+unsigned long txBursts = 0;
+unsigned long statsStartMs = 0;
+
+// --- Channel hopping ---
+// 16 slots of 64 ms (4 payloads each in ADPCM2) over the quietest channels
+// found by the carrier-detect sweep. The last GUARD_MS of a slot carry no
+// data: payloads that arrive then are held and go out after the hop.
+#define SLOT_MS 64
+#define GUARD_MS 8
+#define STARTUP_SWEEPS 16
+#define SCAN_INTERVAL_MS 25   // One channel per idle gap: a full sweep every ~3 s
+#define HOLD_DEPTH 4
+channel_scan_t scan;
+channel_hop_tx_t hopper;
+uint8_t hopChannel = 0;
+byte held[HOLD_DEPTH][32];
+byte heldCount = 0;
+unsigned long lastScanMs = 0;
+
+void sendPayload(const byte *p) {
+  radio.writeFast(p, 32, true);  // true = multicast: no ACK expected
+  burstOpen = true;
+  lastTxMs = millis();
+  txPayloads++;
+}
+
+// Carrier detect on one channel; only call with the TX FIFO empty
+bool sampleChannel(uint8_t ch) {
+  radio.setChannel(ch);
+  radio.startListening();
+  delayMicroseconds(128);
+  radio.stopListening();
+  return radio.testCarrier();
+}
+
+void sweepAllChannels(int passes) {
+  for (int p = 0; p < passes; p++) {
+    for (uint8_t ch = 0; ch < CHANNEL_HOP_CHANNELS; ch++) {
+      channel_scan_add(&scan, ch, sampleChannel(ch));
+    }
+  }
+  radio.setChannel(hopChannel);
+}
+
+// Samples one channel in the gaps between bursts, and plans again after every
+// full sweep if a channel in use has turned busy
+void scanWhenIdle() {
+  unsigned long now = millis();
+  if (burstOpen || now - lastScanMs < SCAN_INTERVAL_MS || channel_hop_tx_quiet(&hopper, now)) return;
+  lastScanMs = now;
+  channel_scan_add(&scan, scan.next, sampleChannel(scan.next));
+  radio.setChannel(hopChannel);
+  if (++scan.next == CHANNEL_HOP_CHANNELS) {
+    scan.next = 0;
+    channel_hop_map_t next;
+    if (channel_hop_replan(&scan, &hopper.map, &next)) channel_hop_tx_plan(&hopper, &next);
+  }
+}
+
+void hopIfDue() {
+  unsigned long now = millis();
+  if (!channel_hop_tx_due(&hopper, now)) return;
+  if (burstOpen) {
+    radio.txStandBy();  // The last payloads go out on the old channel
+    burstOpen = false;
+    txBursts++;
+  }
+  byte announce[32] = { 0 };
+  int more;
+  radio.openWritingPipe(hopAddress);
+  do {
+    more = channel_hop_tx_hop(&hopper, now, &hopChannel, announce);
+    radio.setChannel(hopChannel);
+    radio.write(announce, sizeof(announce), true);
+  } while (more);
+  radio.openWritingPipe(address);
+
+  for (byte i = 0; i < heldCount; i++) sendPayload(held[i]);
+  heldCount = 0;
+}
+
+// Sends now, or holds the payload over the guard time at the end of a slot
+void queuePayload(const byte *p) {
+  if (channel_hop_tx_quiet(&hopper, millis()) && heldCount < HOLD_DEPTH) {
+    memcpy(held[heldCount++], p, 32);
+  } else {
+    sendPayload(p);
+  }
+}
+
+void endBurstWhenIdle() {
+  if (burstOpen && millis() - lastTxMs >= BURST_IDLE_MS) {
+    radio.txStandBy();  // FIFO has drained by now; back to standby
+    burstOpen = false;
+    txBursts++;
+  }
+}
+
+void reportStats() {
+  unsigned long now = millis();
+  unsigned long elapsed = now - statsStartMs;
+  if (elapsed < STATS_INTERVAL_MS) return;
+
+  // Payload throughput only: 32 bytes per packet, air-rate overhead excluded
+  char line[SERIAL_FRAME_MAX_PAYLOAD];
+  unsigned long kbps = txPayloads * 32UL * 8UL / elapsed;
+  int len = snprintf(line, sizeof(line), "TX %lu pkt/s %lu kbit/s %lu bursts %lu bad map %u",
+                     txPayloads * 1000UL / elapsed, kbps, txBursts, badFrames, hopper.map.epoch);
+#if TX_BENCHMARK
+  Serial.println(line);
+#else
+  // The Mac reads these frames back and prints them
+  byte framed[SERIAL_FRAME_MAX_ENCODED];
+  Serial.write(framed, serial_frame_encode((const byte *)line, len, framed));
+#endif
+  txPayloads = 0;
+  txBursts = 0;
+  statsStartMs = now;
+}
 
 void setup() {
   // Must match the baud rate in our Python script!
-  Serial.begin(115200); 
+  Serial.begin(500000); 
   
   radio.begin();
   radio.openWritingPipe(address);
   
-  // Set to max power and fastest speed for audio streaming
-  radio.setChannel(115);
+  // Set to max power and the slowest, longest-range speed: each payload is
+  // an ADPCM frame (audioreceiever/audio_codec.h), so 250 kbps keeps up
   radio.setPALevel(RF24_PA_MAX);
+#if TX_BENCHMARK
   radio.setDataRate(RF24_2MBPS);
+#else
+  radio.setDataRate(RF24_250KBPS);
+#endif
   radio.setAutoAck(false); 
   
   // We are only transmitting, so stop listening
   radio.stopListening(); 
+
+  // Find the quiet channels before the first slot
+  sweepAllChannels(STARTUP_SWEEPS);
+  channel_hop_map_t map;
+  channel_hop_plan(&scan, 0, SLOT_MS, GUARD_MS, &map);
+  channel_hop_tx_start(&hopper, &map, millis());
+#if TX_BENCHMARK
+  // No hopping: the benchmark measures the radio, on the quietest channel
+  hopChannel = map.seq[0];
+  radio.setChannel(hopChannel);
+#endif
+  statsStartMs = millis();
 }
 
 void loop() {
-  // If the Mac has pushed at least 32 bytes down the USB...
-  if (Serial.available() >= 32) {
-    // ...scoop them up into our payload array...
-    Serial.readBytes(payload, 32);
-    // ...and blast them into the air!
-    radio.write(&payload, sizeof(payload));
+#if TX_BENCHMARK
+  // Keep the FIFO full with numbered dummy payloads
+  memcpy(payload, &txPayloads, sizeof(txPayloads));
+  sendPayload(payload);
+#else
+  // Whatever the Mac has pushed down the USB...
+  while (Serial.available()) {
+    // ...goes through the deframer until a whole, CRC-checked frame is in...
+    int len = serial_frame_push(&link, Serial.read(), payload);
+    if (len == 32) {
+      // ...and then we queue it for the air!
+      queuePayload(payload);
+    } else if (len < 0) {
+      badFrames++;  // Dropped; the next 0x00 delimiter resyncs us
+    }
   }
-}
\ No newline at end of file
+  hopIfDue();
+  endBurstWhenIdle();
+  scanWhenIdle();
+#endif
+  reportStats();
+}
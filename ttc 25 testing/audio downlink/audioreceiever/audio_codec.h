@@ -0,0 +1,228 @@
+// ADPCM voice codec for the nRF24 audio downlink. Plain C, no Arduino calls:
+// the receiver sketch includes it, and mic_to_usb.py loads the same code as a
+// shared library, together with the serial framing:
+//
+//   gcc -O2 -shared -fPIC -DAUDIO_CODEC_API= -DSERIAL_FRAME_API= -x c audioreceiever/audio_codec.h libraries/serial_frame/serial_frame.h -o audio_codec.so
+//
+// Every 32-byte radio payload is one self-contained frame, so a lost payload
+// costs only its own audio:
+//
+//   [mode 2 bits | sequence 6 bits] [step index 1] [first sample 1] [codes 29]
+//
+// The sequence number counts frames modulo 64; usb_to_speaker.py uses it to
+// put frames back in order and to spot the lost ones, which
+// audio_conceal_frame() then fills in.
+//
+// The first sample is sent as-is (8-bit PCM), and the codes carry the rest as
+// IMA-style ADPCM: each code is a sign bit plus magnitude bits that scale the
+// current step size, and the step adapts after every sample.
+//
+//   Mode                 Bits  Rate    Samples/frame  Audio/frame  vs 8-bit PCM
+//   AUDIO_MODE_IMA4       4    8 kHz        59           7.4 ms       1.8x
+//   AUDIO_MODE_ADPCM2     2    8 kHz       117          14.6 ms       3.7x
+//   AUDIO_MODE_ADPCM2_4K  2    4 kHz       117          29.3 ms       7.3x
+//
+// AUDIO_MODE_ADPCM2_4K averages sample pairs before encoding and the decoder
+// interpolates back to 8 kHz, so it passes only up to about 2 kHz.
+#ifndef AUDIO_CODEC_H
+#define AUDIO_CODEC_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef AUDIO_CODEC_API
+#define AUDIO_CODEC_API static inline
+#endif
+
+#define AUDIO_PAYLOAD 32          // nRF24 maximum payload
+#define AUDIO_HEADER 3
+#define AUDIO_CODE_BYTES (AUDIO_PAYLOAD - AUDIO_HEADER)
+#define AUDIO_MAX_SAMPLES (2 * (1 + AUDIO_CODE_BYTES * 4))  // 8 kHz samples in one frame
+
+#define AUDIO_MODE_IMA4      0
+#define AUDIO_MODE_ADPCM2    1
+#define AUDIO_MODE_ADPCM2_4K 2
+#define AUDIO_MODE_MASK      0x03
+#define AUDIO_SEQ_MODULO     64    // Sequence number in the upper 6 bits of byte 0
+
+static const int16_t AUDIO_STEPS[89] = {
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+  50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+  253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+  1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+  3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+  11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+  32767
+};
+static const int8_t AUDIO_INDEX_4BIT[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+static const int8_t AUDIO_INDEX_2BIT[2] = { -1, 2 };
+
+typedef struct {
+  uint8_t index;     // Step index carried from frame to frame
+  uint8_t seq;       // Sequence number of the next frame
+} audio_encoder_t;
+
+typedef struct {
+  int16_t last;      // Last decoded sample, for 4 kHz interpolation
+  uint8_t losses;    // Frames concealed in a row
+  int16_t history_len;
+  uint8_t history[AUDIO_MAX_SAMPLES];  // Last frame played, for concealment
+} audio_decoder_t;
+
+typedef struct {
+  int16_t predictor;
+  int8_t index;
+} audio_adpcm_t;
+
+static inline int audio_code_bits(int mode) {
+  return mode == AUDIO_MODE_IMA4 ? 4 : 2;
+}
+
+/**
+ * @brief 8 kHz PCM samples carried by one frame in this mode.
+ */
+AUDIO_CODEC_API int audio_frame_samples(int mode) {
+  int coded = 1 + AUDIO_CODE_BYTES * 8 / audio_code_bits(mode);
+  return mode == AUDIO_MODE_ADPCM2_4K ? 2 * coded : coded;
+}
+
+// Applies one code to the state; the encoder runs this too, so both ends track.
+static inline void audio_adpcm_step(audio_adpcm_t* s, uint8_t code, int bits) {
+  int shift = bits - 1;
+  int magnitude = code & ((1 << shift) - 1);
+  int32_t diff = ((int32_t)(2 * magnitude + 1) * AUDIO_STEPS[s->index]) >> shift;
+  int32_t p = (code >> shift) ? (int32_t)s->predictor - diff : (int32_t)s->predictor + diff;
+  s->predictor = (int16_t)(p > 32767 ? 32767 : (p < -32768 ? -32768 : p));
+  int index = s->index + (bits == 4 ? AUDIO_INDEX_4BIT[magnitude] : AUDIO_INDEX_2BIT[magnitude]);
+  s->index = (int8_t)(index < 0 ? 0 : (index > 88 ? 88 : index));
+}
+
+static inline uint8_t audio_adpcm_code(const audio_adpcm_t* s, int16_t sample, int bits) {
+  int shift = bits - 1;
+  int32_t d = (int32_t)sample - s->predictor;
+  uint8_t sign = 0;
+  if (d < 0) {
+    sign = 1 << shift;
+    d = -d;
+  }
+  // WHY: Reconstruction is (2m + 1) * step / 2^shift, so the nearest level is
+  // half of d * 2^shift / step, rounded down.
+  int32_t magnitude = ((d << shift) / AUDIO_STEPS[s->index]) >> 1;
+  int32_t max = (1 << shift) - 1;
+  return sign | (uint8_t)(magnitude > max ? max : magnitude);
+}
+
+static inline int16_t audio_from_u8(uint8_t x) { return (int16_t)(((int16_t)x - 128) * 256); }
+
+static inline uint8_t audio_to_u8(int16_t x) {
+  int32_t v = ((int32_t)x + 128 + 32768) >> 8;  // Round to the nearest 8-bit level
+  return (uint8_t)(v > 255 ? 255 : v);
+}
+
+/**
+ * @brief Encodes audio_frame_samples(mode) 8-bit PCM samples into one payload.
+ * @return AUDIO_PAYLOAD, or -1 for an unknown mode.
+ */
+AUDIO_CODEC_API int audio_encode_frame(audio_encoder_t* enc, int mode, const uint8_t* pcm, uint8_t* payload) {
+  if (mode < AUDIO_MODE_IMA4 || mode > AUDIO_MODE_ADPCM2_4K) return -1;
+  int bits = audio_code_bits(mode);
+  int half = mode == AUDIO_MODE_ADPCM2_4K;
+  int n = audio_frame_samples(mode) >> half;
+
+  // WHY: The first sample is exact in 8 bits, so the state restarts from the
+  // same value the decoder reads from the header.
+  uint8_t first = half ? (uint8_t)((pcm[0] + pcm[1] + 1) >> 1) : pcm[0];
+  audio_adpcm_t s = { audio_from_u8(first), (int8_t)(enc->index > 88 ? 88 : enc->index) };
+  payload[0] = (uint8_t)(mode | (enc->seq << 2));
+  enc->seq = (enc->seq + 1) % AUDIO_SEQ_MODULO;
+  payload[1] = (uint8_t)s.index;
+  payload[2] = first;
+  memset(payload + AUDIO_HEADER, 0, AUDIO_CODE_BYTES);
+
+  for (int i = 1; i < n; i++) {
+    uint8_t x = half ? (uint8_t)((pcm[2 * i] + pcm[2 * i + 1] + 1) >> 1) : pcm[i];
+    uint8_t code = audio_adpcm_code(&s, audio_from_u8(x), bits);
+    audio_adpcm_step(&s, code, bits);
+    int bit = (i - 1) * bits;
+    payload[AUDIO_HEADER + bit / 8] |= (uint8_t)(code << (bit % 8));
+  }
+  enc->index = (uint8_t)s.index;
+  return AUDIO_PAYLOAD;
+}
+
+static inline int audio_decode_samples(int16_t* last, const uint8_t* payload, uint8_t* pcm) {
+  int mode = payload[0] & AUDIO_MODE_MASK;
+  if (mode > AUDIO_MODE_ADPCM2_4K || payload[1] > 88) return -1;
+  int bits = audio_code_bits(mode);
+  int half = mode == AUDIO_MODE_ADPCM2_4K;
+  int n = audio_frame_samples(mode) >> half;
+
+  audio_adpcm_t s = { audio_from_u8(payload[2]), (int8_t)payload[1] };
+  int out = 0;
+  for (int i = 0; i < n; i++) {
+    if (i > 0) {
+      int bit = (i - 1) * bits;
+      uint8_t code = (payload[AUDIO_HEADER + bit / 8] >> (bit % 8)) & ((1 << bits) - 1);
+      audio_adpcm_step(&s, code, bits);
+    }
+    if (half) pcm[out++] = audio_to_u8((int16_t)(((int32_t)*last + s.predictor) / 2));
+    pcm[out++] = audio_to_u8(s.predictor);
+    *last = s.predictor;
+  }
+  return out;
+}
+
+/**
+ * @brief Decodes one payload into 8 kHz, 8-bit PCM.
+ * @param pcm Output buffer of at least AUDIO_MAX_SAMPLES bytes.
+ * @return The number of samples, or -1 if the payload is not a codec frame.
+ */
+AUDIO_CODEC_API int audio_decode_frame(audio_decoder_t* dec, const uint8_t* payload, uint8_t* pcm) {
+  int out = audio_decode_samples(&dec->last, payload, pcm);
+  if (out < 0) return -1;
+  memcpy(dec->history, pcm, out);
+  dec->history_len = (int16_t)out;
+  dec->losses = 0;
+  return out;
+}
+
+static inline uint8_t audio_attenuate_u8(uint8_t x, int shift) {
+  return (uint8_t)(128 + (((int)x - 128) >> shift));
+}
+
+/**
+ * @brief Fills in n samples for a lost frame.
+ *
+ * The last frame played is repeated, at half the level for every further
+ * frame lost in a row, so a long gap fades to silence instead of buzzing. If
+ * the frame after the gap has already arrived (next != NULL), the repetition
+ * is cross-faded into that frame played backwards, which ends on the frame's
+ * first sample, so playback resumes without a click.
+ * @param n Samples to fill, at most AUDIO_MAX_SAMPLES.
+ * @return n.
+ */
+AUDIO_CODEC_API int audio_conceal_frame(audio_decoder_t* dec, const uint8_t* next, int n, uint8_t* pcm) {
+  if (n > AUDIO_MAX_SAMPLES) n = AUDIO_MAX_SAMPLES;
+  int losses = dec->losses < 7 ? dec->losses : 7;
+  for (int i = 0; i < n; i++) {
+    pcm[i] = dec->history_len ? audio_attenuate_u8(dec->history[i % dec->history_len], losses) : 128;
+  }
+  uint8_t ahead[AUDIO_MAX_SAMPLES];
+  int16_t last = dec->last;
+  int n_ahead = next ? audio_decode_samples(&last, next, ahead) : -1;
+  if (n_ahead > 0) {
+    for (int i = 0; i < n; i++) {
+      int32_t w = (int32_t)256 * (i + 1) / n;  // Weight of the next frame, up to 256
+      int j = n - 1 - i;                       // Time-reversed: ends on next's first sample
+      int32_t from = (int32_t)pcm[i] * (256 - w);
+      int32_t to = (int32_t)ahead[j < n_ahead ? j : n_ahead - 1] * w;
+      pcm[i] = (uint8_t)((from + to) >> 8);
+    }
+  }
+  memcpy(dec->history, pcm, n);
+  dec->history_len = (int16_t)n;
+  dec->losses++;
+  return n;
+}
+
+#endif
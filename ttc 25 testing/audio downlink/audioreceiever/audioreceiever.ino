@@ -1,40 +1,123 @@
 #include <nRF24L01.h>
 #include <RF24.h>
+#include <serial_frame.h>
+#include <channel_hop.h>
+#include "audio_codec.h"
 
 // Set up nRF24L01 on pins 7 (CE) and 8 (CSN)
 RF24 radio(7, 8); 
 
 // Must match the exact 5-letter address from the transmitter
 const byte address[6] = "AUDIO"; 
+const byte hopAddress[6] = "AHOP0";
 
-// A buffer to catch the 32 bytes of audio
-byte payload[32]; 
+// A buffer to catch the 32 bytes of compressed audio...
+byte payload[AUDIO_PAYLOAD]; 
+
+// 0: forward the frames COBS + CRC framed (libraries/serial_frame);
+//    usb_to_speaker.py reorders, decodes and conceals lost frames.
+// 1: decode here and send plain 8-bit PCM (no loss concealment).
+#define DECODE_ON_RECEIVER 0
+
+#if DECODE_ON_RECEIVER
+byte pcm[AUDIO_MAX_SAMPLES];
+audio_decoder_t decoder;
+#else
+byte framed[SERIAL_FRAME_MAX_ENCODED];
+#endif
+
+// --- Channel hopping (libraries/channel_hop) ---
+// The sender's announcements set the sequence and the slot clock; we only
+// need a guess of the slot length to search with until the first one.
+// Searching parks on each channel for a full cycle (16 x SLOT_MS), so the
+// worst case, when the sender's channels come last, is 126 cycles (2.2 min)
+// to first lock and 142 (2.4 min) to relock; see autoACKdisabledReceiver.ino.
+#define SLOT_MS 64            // Must match audio_sender.ino
+#define STARTUP_SWEEPS 16
+#define REPORT_INTERVAL_MS 625  // One channel per report: all 16 every 10 s
+channel_hop_rx_t hop;
+uint8_t listenChannel = 255;
+uint8_t reportSlot = 0;
+unsigned long lastReportMs = 0;
+
+// Sends the loss on one channel of the sequence to usb_to_speaker.py
+void reportChannels() {
+#if !DECODE_ON_RECEIVER
+  if (millis() - lastReportMs < REPORT_INTERVAL_MS || !hop.have_map) return;
+  lastReportMs = millis();
+  char line[SERIAL_FRAME_MAX_PAYLOAD];
+  int len = snprintf(line, sizeof(line), "HOP map %u ch %u: %u/%u announced, %u payloads",
+                     hop.map.epoch, hop.map.seq[reportSlot], hop.announced[reportSlot],
+                     hop.visits[reportSlot], hop.payloads[reportSlot]);
+  Serial.write(framed, serial_frame_encode((const byte *)line, len, framed));
+  reportSlot = (reportSlot + 1) % CHANNEL_HOP_SLOTS;
+#endif
+}
 
 void setup() {
   // Must match the Python baud rate!
-  Serial.begin(115200); 
+  Serial.begin(500000); 
   
   radio.begin();
   radio.openReadingPipe(0, address);
-
-  radio.setChannel(115);
+  radio.openReadingPipe(1, hopAddress);
   
   radio.setPALevel(RF24_PA_MAX);
-  radio.setDataRate(RF24_2MBPS); 
+  // ADPCM needs a quarter of the raw PCM packet rate or less, so use the
+  // slowest, most sensitive data rate for range
+  radio.setDataRate(RF24_250KBPS); 
 
   radio.setAutoAck(false);
+
+  // Rank the channels by our own carrier-detect sweep: we search the
+  // quietest first, which is most likely where the sender hops
+  channel_scan_t scan = {};
+  for (int p = 0; p < STARTUP_SWEEPS; p++) {
+    for (uint8_t ch = 0; ch < CHANNEL_HOP_CHANNELS; ch++) {
+      radio.setChannel(ch);
+      radio.startListening();
+      delayMicroseconds(128);
+      radio.stopListening();
+      channel_scan_add(&scan, ch, radio.testCarrier());
+    }
+  }
+  channel_hop_rx_init(&hop, &scan, SLOT_MS);
   
   // We are the receiver, so start listening to the airwaves
   radio.startListening(); 
 }
 
 void loop() {
+  // Follow the sender around the band
+  uint8_t ch = channel_hop_rx_tick(&hop, millis());
+  if (ch != listenChannel) {
+    radio.setChannel(ch);
+    listenChannel = ch;
+  }
+
   // If the radio caught a packet from the air...
-  if (radio.available()) {
+  uint8_t pipe;
+  if (radio.available(&pipe)) {
     // ...read the 32 bytes into our payload array...
     radio.read(&payload, sizeof(payload));
+    if (pipe == 1) {
+      // ...a hop announcement only moves us along...
+      channel_hop_rx_announce(&hop, payload, sizeof(payload), millis());
+      return;
+    }
+    channel_hop_rx_payload(&hop);
     
+#if DECODE_ON_RECEIVER
+    // ...decode them...
+    int samples = audio_decode_frame(&decoder, payload, pcm);
+
     // ...and immediately shove them up the USB cable to Windows!
-    Serial.write(payload, sizeof(payload));
+    if (samples > 0) Serial.write(pcm, samples);
+#else
+    // ...and immediately shove them up the USB cable to Windows, in one write
+    int len = serial_frame_encode(payload, sizeof(payload), framed);
+    Serial.write(framed, len);
+#endif
   }
+  reportChannels();
 }
\ No newline at end of file
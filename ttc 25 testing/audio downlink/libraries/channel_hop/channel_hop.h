@@ -0,0 +1,326 @@
+// Channel scanning and adaptive hopping for the nRF24 links (audio and text
+// downlinks). Plain C, no radio calls: the sketches do the SPI work and feed
+// the results in. Install it like serial_frame (copy or symlink this folder
+// into the Arduino libraries folder).
+//
+// Scan:  carrier detect (RPD, above -64 dBm) is sampled on every channel,
+//        0-125 (2400-2525 MHz), and kept as a running occupancy per channel.
+// Plan:  the CHANNEL_HOP_SLOTS quietest channels make up the hop sequence.
+// Hop:   the sender owns the clock. Every slot_ms it moves to the next slot
+//        and first sends an announcement, on its own pipe address:
+//
+//          [tag 1] [epoch 1] [slot 1] [slot_ms 2, LE] [guard_ms 1] [sequence 16]
+//
+//        so a receiver that hears any slot learns the whole sequence and
+//        where the sender is in it. The last guard_ms of every slot carry no
+//        data, which gives the receiver room to hop before the sender does.
+// Adapt: the sender keeps sweeping in its idle time. Once a channel in use
+//        turns busy it plans again, and the new sequence (next epoch) takes
+//        over at the end of the cycle, announced on the old first channel.
+//
+// The receiver counts, per channel, the slots it visited and the
+// announcements it heard there. The sender announces every slot, so the
+// ratio is the packet loss on that channel, whatever the payloads are.
+#ifndef CHANNEL_HOP_H
+#define CHANNEL_HOP_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define CHANNEL_HOP_CHANNELS 126
+#define CHANNEL_HOP_SLOTS 16
+#define CHANNEL_HOP_TAG 0xC4
+#define CHANNEL_HOP_ANNOUNCE_LEN (6 + CHANNEL_HOP_SLOTS)
+#define CHANNEL_HOP_BUSY 32     // Occupancy (of 255) on a channel in use that triggers a new plan
+#define CHANNEL_HOP_SPREAD 37   // Tie order over the band: coprime with CHANNEL_HOP_CHANNELS
+#define CHANNEL_HOP_STRIDE 7    // Slot order: coprime with CHANNEL_HOP_SLOTS
+
+typedef struct {
+  uint8_t busy[CHANNEL_HOP_CHANNELS];  // Carrier-detect occupancy, 0 (never) to 255 (always)
+  uint8_t next;                        // Next channel the background sweep samples
+} channel_scan_t;
+
+typedef struct {
+  uint8_t epoch;                       // Bumped for every new plan
+  uint16_t slot_ms;
+  uint8_t guard_ms;                    // Quiet time at the end of every slot
+  uint8_t seq[CHANNEL_HOP_SLOTS];
+} channel_hop_map_t;
+
+/**
+ * @brief Adds one carrier-detect sample to the occupancy of a channel.
+ * A moving average over about 8 samples: one burst of WiFi does not condemn
+ * a channel, a busy one climbs to 255 within a few sweeps.
+ */
+static inline void channel_scan_add(channel_scan_t* scan, uint8_t channel, int carrier) {
+  uint8_t b = scan->busy[channel];
+  scan->busy[channel] = carrier ? (uint8_t)(b + (255 - b + 7) / 8) : (uint8_t)(b - (b + 7) / 8);
+}
+
+/**
+ * @brief Lists the n quietest channels, quietest first. Ties are taken in
+ * steps of CHANNEL_HOP_SPREAD, so a clean band is used end to end instead of
+ * from channel 0 up.
+ */
+static inline void channel_scan_rank(const channel_scan_t* scan, uint8_t* out, int n) {
+  uint8_t taken[(CHANNEL_HOP_CHANNELS + 7) / 8];
+  memset(taken, 0, sizeof(taken));
+  for (int k = 0; k < n; k++) {
+    int best = -1;
+    for (int i = 0; i < CHANNEL_HOP_CHANNELS; i++) {
+      int ch = (i * CHANNEL_HOP_SPREAD) % CHANNEL_HOP_CHANNELS;
+      if (taken[ch >> 3] & (1 << (ch & 7))) continue;
+      if (best < 0 || scan->busy[ch] < scan->busy[best]) best = ch;
+    }
+    taken[best >> 3] |= (uint8_t)(1 << (best & 7));
+    out[k] = (uint8_t)best;
+  }
+}
+
+/**
+ * @brief Builds a hop sequence from the quietest channels.
+ * The channels are sorted by frequency and visited in steps of
+ * CHANNEL_HOP_STRIDE, so consecutive slots land far apart and one wideband
+ * interferer (a WiFi channel is 20 MHz wide) hits few slots in a row.
+ */
+static inline void channel_hop_plan(const channel_scan_t* scan, uint8_t epoch, uint16_t slot_ms,
+                                    uint8_t guard_ms, channel_hop_map_t* map) {
+  uint8_t quiet[CHANNEL_HOP_SLOTS];
+  channel_scan_rank(scan, quiet, CHANNEL_HOP_SLOTS);
+  for (int i = 1; i < CHANNEL_HOP_SLOTS; i++) {
+    uint8_t ch = quiet[i];
+    int j = i;
+    for (; j > 0 && quiet[j - 1] > ch; j--) quiet[j] = quiet[j - 1];
+    quiet[j] = ch;
+  }
+  map->epoch = epoch;
+  map->slot_ms = slot_ms;
+  map->guard_ms = guard_ms;
+  for (int s = 0; s < CHANNEL_HOP_SLOTS; s++) {
+    map->seq[s] = quiet[(s * CHANNEL_HOP_STRIDE) % CHANNEL_HOP_SLOTS];
+  }
+}
+
+static inline uint8_t channel_hop_worst(const channel_scan_t* scan, const channel_hop_map_t* map) {
+  uint8_t worst = 0;
+  for (int s = 0; s < CHANNEL_HOP_SLOTS; s++) {
+    if (scan->busy[map->seq[s]] > worst) worst = scan->busy[map->seq[s]];
+  }
+  return worst;
+}
+
+/**
+ * @brief Plans again once a channel in use has turned busy.
+ * @return 1 if next holds a quieter plan (the next epoch), 0 to keep map.
+ */
+static inline int channel_hop_replan(const channel_scan_t* scan, const channel_hop_map_t* map,
+                                     channel_hop_map_t* next) {
+  uint8_t worst = channel_hop_worst(scan, map);
+  if (worst < CHANNEL_HOP_BUSY) return 0;
+  channel_hop_plan(scan, (uint8_t)(map->epoch + 1), map->slot_ms, map->guard_ms, next);
+  return channel_hop_worst(scan, next) < worst;
+}
+
+static inline void channel_hop_announce(const channel_hop_map_t* map, uint8_t slot, uint8_t* out) {
+  out[0] = CHANNEL_HOP_TAG;
+  out[1] = map->epoch;
+  out[2] = slot;
+  out[3] = (uint8_t)map->slot_ms;
+  out[4] = (uint8_t)(map->slot_ms >> 8);
+  out[5] = map->guard_ms;
+  memcpy(out + 6, map->seq, CHANNEL_HOP_SLOTS);
+}
+
+// ==========================================
+// SENDER
+// ==========================================
+
+typedef struct {
+  channel_hop_map_t map;
+  channel_hop_map_t next;   // Plan waiting for the end of the cycle
+  uint8_t pending;
+  uint8_t bridged;          // The new plan was announced on the old first channel
+  uint8_t slot;
+  uint32_t since_ms;        // Start of the current slot
+} channel_hop_tx_t;
+
+/**
+ * @brief Starts hopping on map; the first channel_hop_tx_due() is immediate.
+ */
+static inline void channel_hop_tx_start(channel_hop_tx_t* tx, const channel_hop_map_t* map, uint32_t now_ms) {
+  memset(tx, 0, sizeof(*tx));
+  tx->map = *map;
+  tx->slot = CHANNEL_HOP_SLOTS - 1;
+  tx->since_ms = now_ms - map->slot_ms;
+}
+
+/**
+ * @brief Queues a new plan; it takes over at the end of the cycle.
+ */
+static inline void channel_hop_tx_plan(channel_hop_tx_t* tx, const channel_hop_map_t* next) {
+  tx->next = *next;
+  tx->pending = 1;
+}
+
+static inline int channel_hop_tx_due(const channel_hop_tx_t* tx, uint32_t now_ms) {
+  return now_ms - tx->since_ms >= tx->map.slot_ms;
+}
+
+/**
+ * @brief 1 in the guard time at the end of a slot: hold data until the hop.
+ */
+static inline int channel_hop_tx_quiet(const channel_hop_tx_t* tx, uint32_t now_ms) {
+  return now_ms - tx->since_ms >= (uint32_t)(tx->map.slot_ms - tx->map.guard_ms);
+}
+
+/**
+ * @brief Moves to the next slot. Send the announcement on the returned
+ * channel before any data.
+ * @param announce Buffer of at least CHANNEL_HOP_ANNOUNCE_LEN bytes.
+ * @param channel Set to the channel to send on.
+ * @return 1 if another hop must follow straight away: a new plan was just
+ * announced on the old first channel, where the receiver is listening.
+ */
+static inline int channel_hop_tx_hop(channel_hop_tx_t* tx, uint32_t now_ms, uint8_t* channel, uint8_t* announce) {
+  if (tx->bridged) {
+    tx->bridged = 0;
+    *channel = tx->map.seq[0];
+    channel_hop_announce(&tx->map, 0, announce);
+    return 0;
+  }
+  tx->slot = (uint8_t)((tx->slot + 1) % CHANNEL_HOP_SLOTS);
+  // Stay on the slot grid, unless the caller stalled for more than a slot
+  tx->since_ms = (now_ms - tx->since_ms < 2UL * tx->map.slot_ms) ? tx->since_ms + tx->map.slot_ms : now_ms;
+  *channel = tx->map.seq[tx->slot];
+  if (tx->slot == 0 && tx->pending) {
+    tx->map = tx->next;
+    tx->pending = 0;
+    tx->bridged = 1;
+    channel_hop_announce(&tx->map, 0, announce);
+    return 1;
+  }
+  channel_hop_announce(&tx->map, tx->slot, announce);
+  return 0;
+}
+
+// ==========================================
+// RECEIVER
+// ==========================================
+
+typedef struct {
+  channel_hop_map_t map;
+  uint8_t have_map;
+  uint8_t slot;
+  uint8_t missed;           // Announcements missed in a row; a full cycle means lost
+  uint8_t search;           // Position in the search order while lost
+  uint32_t since_ms;        // When we moved to this slot, or parked while searching
+  uint8_t order[CHANNEL_HOP_CHANNELS];  // Search order: quietest first, by our own scan
+  uint16_t visits[CHANNEL_HOP_SLOTS];   // Per slot of the current plan
+  uint16_t announced[CHANNEL_HOP_SLOTS];
+  uint16_t payloads[CHANNEL_HOP_SLOTS];
+} channel_hop_rx_t;
+
+/**
+ * @param slot_ms The sender's slot length, used for the search until the
+ * first announcement brings the real one.
+ */
+static inline void channel_hop_rx_init(channel_hop_rx_t* rx, const channel_scan_t* scan, uint16_t slot_ms) {
+  memset(rx, 0, sizeof(*rx));
+  rx->map.slot_ms = slot_ms;
+  channel_scan_rank(scan, rx->order, CHANNEL_HOP_CHANNELS);
+}
+
+static inline int channel_hop_rx_lost(const channel_hop_rx_t* rx) {
+  return !rx->have_map || rx->missed >= CHANNEL_HOP_SLOTS;
+}
+
+/**
+ * @brief The channel to listen on now.
+ * While lost, each channel is watched for one full cycle: the channels of
+ * the last plan first, then the whole band, quietest first.
+ * WHY: A full cycle is what guarantees hearing the sender on any channel of
+ * its sequence; a shorter dwell only meets it by chance. The price is the
+ * worst case: CHANNEL_HOP_CHANNELS (+ CHANNEL_HOP_SLOTS with a plan) cycles.
+ */
+static inline uint8_t channel_hop_rx_channel(const channel_hop_rx_t* rx) {
+  if (!channel_hop_rx_lost(rx)) return rx->map.seq[rx->slot];
+  int k = rx->search;
+  if (rx->have_map) {
+    if (k < CHANNEL_HOP_SLOTS) return rx->map.seq[k];
+    k -= CHANNEL_HOP_SLOTS;
+  }
+  return rx->order[k];
+}
+
+/**
+ * @brief Advances the slot (or the search) with the clock.
+ * @return The channel to listen on; the caller retunes when it changes.
+ */
+static inline uint8_t channel_hop_rx_tick(channel_hop_rx_t* rx, uint32_t now_ms) {
+  uint32_t slot_ms = rx->map.slot_ms;
+  if (channel_hop_rx_lost(rx)) {
+    if (now_ms - rx->since_ms >= slot_ms * CHANNEL_HOP_SLOTS) {
+      int n = CHANNEL_HOP_CHANNELS + (rx->have_map ? CHANNEL_HOP_SLOTS : 0);
+      rx->search = (uint8_t)((rx->search + 1) % n);
+      rx->since_ms = now_ms;
+    }
+  } else if (now_ms - rx->since_ms >= slot_ms) {
+    rx->since_ms += slot_ms;
+    rx->slot = (uint8_t)((rx->slot + 1) % CHANNEL_HOP_SLOTS);
+    rx->visits[rx->slot]++;
+    if (++rx->missed >= CHANNEL_HOP_SLOTS) {
+      rx->search = 0;  // Lost: start searching where the sender most likely is
+      rx->since_ms = now_ms;
+    }
+  }
+  return channel_hop_rx_channel(rx);
+}
+
+/**
+ * @brief Counts a data payload heard on the current slot.
+ */
+static inline void channel_hop_rx_payload(channel_hop_rx_t* rx) {
+  if (!channel_hop_rx_lost(rx)) rx->payloads[rx->slot]++;
+}
+
+/**
+ * @brief Takes an announcement: adopts a new plan and lines up with the
+ * sender's slot clock.
+ * @return 0, or -1 if the packet is not a valid announcement.
+ */
+static inline int channel_hop_rx_announce(channel_hop_rx_t* rx, const uint8_t* in, int len, uint32_t now_ms) {
+  if (len < CHANNEL_HOP_ANNOUNCE_LEN || in[0] != CHANNEL_HOP_TAG || in[2] >= CHANNEL_HOP_SLOTS) return -1;
+  uint16_t slot_ms = (uint16_t)(in[3] | ((uint16_t)in[4] << 8));
+  if (slot_ms == 0 || in[5] >= slot_ms) return -1;
+  for (int s = 0; s < CHANNEL_HOP_SLOTS; s++) {
+    if (in[6 + s] >= CHANNEL_HOP_CHANNELS) return -1;
+  }
+
+  int was_lost = channel_hop_rx_lost(rx);
+  if (!rx->have_map || in[1] != rx->map.epoch) {
+    rx->map.epoch = in[1];
+    memcpy(rx->map.seq, in + 6, CHANNEL_HOP_SLOTS);
+    memset(rx->visits, 0, sizeof(rx->visits));
+    memset(rx->announced, 0, sizeof(rx->announced));
+    memset(rx->payloads, 0, sizeof(rx->payloads));
+    rx->have_map = 1;
+    was_lost = 1;
+  }
+  rx->map.slot_ms = slot_ms;
+  rx->map.guard_ms = in[5];
+  if (was_lost || rx->slot != in[2]) {
+    rx->visits[in[2]]++;
+  } else if (rx->missed == 0) {
+    return 0;  // Second announcement of a new plan, already taken
+  }
+  rx->slot = in[2];
+  rx->announced[rx->slot]++;
+  rx->missed = 0;
+  // WHY: The announcement follows the sender's hop by about one packet time.
+  // Hopping half a guard early keeps us ahead of its next hop and still
+  // behind the last data it sends on this channel.
+  rx->since_ms = now_ms - rx->map.guard_ms / 2;
+  return 0;
+}
+
+#endif
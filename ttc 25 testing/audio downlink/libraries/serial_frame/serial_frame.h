@@ -0,0 +1,124 @@
+// Framed USB-serial transport between the host bridges and the audio sketches.
+// Plain C, no Arduino calls. The sketches include it as a library (copy or
+// symlink this folder into the Arduino libraries folder), and the host scripts
+// load it from the same shared library as the codec:
+//
+//   gcc -O2 -shared -fPIC -DAUDIO_CODEC_API= -DSERIAL_FRAME_API= -x c audioreceiever/audio_codec.h libraries/serial_frame/serial_frame.h -o audio_codec.so
+//
+// Wire format:  COBS( payload | CRC-16 ) 0x00
+//
+// COBS removes every zero byte from the frame, so 0x00 only ever marks the end
+// of a frame. A receiver that starts mid-stream, or loses or corrupts a byte,
+// drops at most the frame it is in and picks up again at the next delimiter.
+// The CRC is the CCITT CRC-16 the packetizer uses for the AX.25 FCS, sent
+// big-endian. A 32-byte radio payload becomes 36 bytes on the wire.
+#ifndef SERIAL_FRAME_H
+#define SERIAL_FRAME_H
+
+#include <stdint.h>
+
+#ifndef SERIAL_FRAME_API
+#define SERIAL_FRAME_API static inline
+#endif
+
+#define SERIAL_FRAME_MAX_PAYLOAD 64
+#define SERIAL_FRAME_CRC_LEN 2
+// COBS adds one byte per 254 and the delimiter one more
+#define SERIAL_FRAME_MAX_ENCODED (SERIAL_FRAME_MAX_PAYLOAD + SERIAL_FRAME_CRC_LEN + 2)
+
+// --- Status codes ---
+#define SERIAL_FRAME_PENDING     0  // Frame not complete yet
+#define SERIAL_FRAME_ERR_FORMAT -1  // Bad COBS, too long or too short
+#define SERIAL_FRAME_ERR_CRC    -2  // CRC mismatch
+
+typedef struct {
+  uint8_t buf[SERIAL_FRAME_MAX_ENCODED];
+  uint8_t len;
+  uint8_t overflow;  // Frame too long: discard until the next delimiter
+} serial_frame_decoder_t;
+
+static inline uint16_t serial_frame_crc(const uint8_t* data, int length) {
+  uint16_t crc = 0xFFFF;
+  for (int i = 0; i < length; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (int j = 0; j < 8; j++) {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc ^ 0xFFFF;
+}
+
+/**
+ * @brief Frames a payload: CRC, COBS and the 0x00 delimiter.
+ * @param out Buffer of at least SERIAL_FRAME_MAX_ENCODED bytes.
+ * @return The number of bytes to send, or SERIAL_FRAME_ERR_FORMAT if the
+ * payload is longer than SERIAL_FRAME_MAX_PAYLOAD.
+ */
+SERIAL_FRAME_API int serial_frame_encode(const uint8_t* payload, int len, uint8_t* out) {
+  if (len < 0 || len > SERIAL_FRAME_MAX_PAYLOAD) return SERIAL_FRAME_ERR_FORMAT;
+  uint16_t crc = serial_frame_crc(payload, len);
+  int code_pos = 0, n = 1;
+  uint8_t code = 1;
+  for (int i = 0; i < len + SERIAL_FRAME_CRC_LEN; i++) {
+    uint8_t b = (i < len) ? payload[i] : (uint8_t)(i == len ? crc >> 8 : crc);
+    if (b != 0) {
+      out[n++] = b;
+      code++;
+    }
+    if (b == 0 || code == 0xFF) {
+      out[code_pos] = code;
+      code_pos = n++;
+      code = 1;
+    }
+  }
+  out[code_pos] = code;
+  out[n++] = 0x00;
+  return n;
+}
+
+/**
+ * @brief Decodes one frame without its delimiter and checks the CRC.
+ * @param payload Buffer of at least SERIAL_FRAME_MAX_PAYLOAD bytes.
+ * @return The payload length, or one of the SERIAL_FRAME_ERR_ codes.
+ */
+SERIAL_FRAME_API int serial_frame_decode(const uint8_t* in, int len, uint8_t* payload) {
+  uint8_t raw[SERIAL_FRAME_MAX_PAYLOAD + SERIAL_FRAME_CRC_LEN];
+  int n = 0, i = 0;
+  while (i < len) {
+    uint8_t code = in[i++];
+    if (code == 0 || i + code - 1 > len) return SERIAL_FRAME_ERR_FORMAT;
+    for (int k = 1; k < code; k++) {
+      if (in[i] == 0 || n == (int)sizeof(raw)) return SERIAL_FRAME_ERR_FORMAT;
+      raw[n++] = in[i++];
+    }
+    if (code != 0xFF && i < len) {
+      if (n == (int)sizeof(raw)) return SERIAL_FRAME_ERR_FORMAT;
+      raw[n++] = 0;
+    }
+  }
+  if (n < SERIAL_FRAME_CRC_LEN) return SERIAL_FRAME_ERR_FORMAT;
+  n -= SERIAL_FRAME_CRC_LEN;
+  if (serial_frame_crc(raw, n) != (uint16_t)((raw[n] << 8) | raw[n + 1])) return SERIAL_FRAME_ERR_CRC;
+  for (int k = 0; k < n; k++) payload[k] = raw[k];
+  return n;
+}
+
+/**
+ * @brief Feeds one received byte to the streaming decoder.
+ * @return The payload length when a good frame ends on this byte,
+ * SERIAL_FRAME_PENDING, or one of the SERIAL_FRAME_ERR_ codes for a bad frame.
+ */
+static inline int serial_frame_push(serial_frame_decoder_t* dec, uint8_t byte, uint8_t* payload) {
+  if (byte != 0x00) {
+    if (dec->len == sizeof(dec->buf)) dec->overflow = 1;
+    else dec->buf[dec->len++] = byte;
+    return SERIAL_FRAME_PENDING;
+  }
+  int len = dec->len, overflow = dec->overflow;
+  dec->len = 0;
+  dec->overflow = 0;
+  if (len == 0) return SERIAL_FRAME_PENDING;  // Back-to-back delimiters (resync)
+  return overflow ? SERIAL_FRAME_ERR_FORMAT : serial_frame_decode(dec->buf, len, payload);
+}
+
+#endif
@@ -1,3 +1,5 @@
+import ctypes
+import os
 import serial
 import pyaudio
 import time
@@ -6,7 +8,8 @@ import time
 # CHANGE THIS to match your Arduino's port! 
 # (e.g., 'COM3' for Windows, or '/dev/cu.usbmodem14101' for Mac)
 SERIAL_PORT = '/dev/cu.usbserial-110'
-BAUD_RATE = 115200 # A fast baud rate is required to push audio quickly
+BAUD_RATE = 500000 # Exact on a 16 MHz AVR; must match audio_sender.ino
+FRAMES_PER_WRITE = 2 # Two framed payloads (72 bytes) fill a 64-byte USB packet
 
 # --- Audio Configuration ---
 CHUNK = 32               # 32 bytes perfectly matches the nRF24L01 max payload
@@ -14,6 +17,21 @@ FORMAT = pyaudio.paUInt8 # 8-bit audio (easiest for the Arduino to handle)
 CHANNELS = 1             # Mono
 RATE = 8000              # 8kHz sample rate (fits within the Serial bandwidth)
 
+# --- Codec Configuration ---
+# Each 32-byte payload is one sequence-numbered ADPCM frame
+# (audioreceiever/audio_codec.h), decoded by usb_to_speaker.py. Build the library once with:
+# gcc -O2 -shared -fPIC -DAUDIO_CODEC_API= -DSERIAL_FRAME_API= -x c audioreceiever/audio_codec.h libraries/serial_frame/serial_frame.h -o audio_codec.so
+# 0 = IMA 4-bit (7.4 ms per payload), 1 = 2-bit (14.6 ms), 2 = 2-bit at 4 kHz (29.3 ms)
+CODEC_MODE = 1
+CODEC_LIB = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'audio_codec.so')
+
+codec = ctypes.CDLL(CODEC_LIB)
+codec_state = (ctypes.c_uint8 * 2)()  # audio_encoder_t: step index and sequence number
+FRAME_SAMPLES = codec.audio_frame_samples(CODEC_MODE)
+payload = ctypes.create_string_buffer(CHUNK)
+framed = ctypes.create_string_buffer(CHUNK + 4)  # serial_frame.h: COBS + CRC + delimiter
+status = ctypes.create_string_buffer(64)          # Text frames sent back by the sender
+
 print(f"Connecting to Arduino on {SERIAL_PORT}...")
 try:
     arduino_serial = serial.Serial(SERIAL_PORT, BAUD_RATE, timeout=0)
@@ -29,17 +47,33 @@ stream = p.open(format=FORMAT,
                 channels=CHANNELS,
                 rate=RATE,
                 input=True,
-                frames_per_buffer=CHUNK)
+                frames_per_buffer=FRAME_SAMPLES * FRAMES_PER_WRITE)
 
 print("Recording and sending to Arduino... (Press Ctrl+C to stop)")
 
 try:
+    replies = b''
     while True:
-        # 1. Read exactly 32 bytes of audio from the microphone
-        data = stream.read(CHUNK, exception_on_overflow=False)
-        
-        # 2. Blast those 32 bytes directly down the USB cable to the Arduino
-        arduino_serial.write(data)
+        # 1. Read a few frames' worth of audio from the microphone
+        data = stream.read(FRAME_SAMPLES * FRAMES_PER_WRITE, exception_on_overflow=False)
+
+        # 2. Compress each frame into a 32-byte payload and frame it for the serial link
+        batch = bytearray()
+        for i in range(FRAMES_PER_WRITE):
+            codec.audio_encode_frame(codec_state, CODEC_MODE, data[i * FRAME_SAMPLES:], payload)
+            n = codec.serial_frame_encode(payload, CHUNK, framed)
+            batch += framed.raw[:n]
+
+        # 3. Blast them down the USB cable to the Arduino in one write
+        arduino_serial.write(batch)
+
+        # 4. Print the transmit statistics the Arduino sends back once a second
+        replies += arduino_serial.read(arduino_serial.in_waiting)
+        *complete, replies = replies.split(b'\x00')
+        for frame in complete:
+            n = codec.serial_frame_decode(frame, len(frame), status) if frame else -1
+            if n > 0:
+                print(status.raw[:n].decode(errors='replace'))
             
 except KeyboardInterrupt:
     print("\nStopping stream...")
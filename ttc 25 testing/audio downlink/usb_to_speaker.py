@@ -1,9 +1,14 @@
+import ctypes
+import os
+import queue
+import threading
+import time
 import serial
 import pyaudio
 
 # --- Serial Configuration ---
 SERIAL_PORT = 'COM3' # <--- CHANGE THIS TO YOUR WINDOWS COM PORT
-BAUD_RATE = 115200
+BAUD_RATE = 500000 # Must match audioreceiever.ino
 
 # --- Audio Configuration ---
 CHUNK = 32               # Must match the 32-byte radio payload
@@ -11,15 +16,151 @@ FORMAT = pyaudio.paUInt8 # 8-bit audio
 CHANNELS = 1             # Mono
 RATE = 8000              # 8kHz sample rate
 
+# --- Codec Configuration ---
+# Same library as mic_to_usb.py (codec and serial framing; see audioreceiever/audio_codec.h)
+CODEC_LIB = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'audio_codec.so')
+AUDIO_MAX_SAMPLES = 234  # Largest decoded frame
+SERIAL_FRAME_MAX_PAYLOAD = 64
+SEQ_MODULO = 64          # Frames are numbered modulo 64
+
+# --- Jitter Buffer Configuration ---
+TARGET_LATENCY_MS = 60   # Audio held back before playing, to ride out late packets
+MAX_LATENCY_MS = 300     # The target grows after underruns, but never past this
+                         # (nor past what the sequence numbers can tell apart)
+RELAX_AFTER_S = 10       # Shrink the target again after this long without an underrun
+STATS_INTERVAL_S = 5
+
+
+class AudioDecoder(ctypes.Structure):
+    # Mirrors audio_decoder_t
+    _fields_ = [('last', ctypes.c_int16),
+                ('losses', ctypes.c_uint8),
+                ('history_len', ctypes.c_int16),
+                ('history', ctypes.c_uint8 * AUDIO_MAX_SAMPLES)]
+
+
+class JitterBuffer:
+    """
+    Holds received frames by sequence number and hands them out in order.
+
+    Playback starts once the buffered audio reaches the target latency. A gap
+    with later frames already waiting is a lost frame: it is concealed and
+    skipped. An empty buffer is an underrun: a concealed frame is played
+    without consuming a sequence number, which adds one frame of latency, and
+    the target grows by one frame so the same burst does not starve it again.
+    Frames that arrive after their slot has been played are counted as late
+    and dropped.
+    """
+
+    def __init__(self, codec):
+        self.codec = codec
+        self.frames = {}
+        self.next_seq = None
+        self.playing = False
+        self.frame_ms = 0.0
+        self.target_ms = TARGET_LATENCY_MS
+        self.last_underrun = time.monotonic()
+        self.concealed_seqs = set()
+        self.stats = dict(played=0, late=0, lost=0, concealed=0, underruns=0, dropped=0, corrupt=0)
+
+    def push(self, payload):
+        seq = payload[0] >> 2
+        if self.next_seq is None:
+            self.next_seq = seq
+        if (seq - self.next_seq) % SEQ_MODULO >= SEQ_MODULO // 2:
+            # Behind the playout point: its slot was concealed already
+            self.stats['late'] += 1
+            if seq in self.concealed_seqs:
+                self.concealed_seqs.discard(seq)
+                self.stats['lost'] -= 1
+            return
+        self.frames[seq] = payload
+        self.frame_ms = 1000.0 * self.codec.audio_frame_samples(payload[0] & 0x03) / RATE
+
+    def buffered_ms(self):
+        return len(self.frames) * self.frame_ms
+
+    def max_target_ms(self):
+        # A frame half the sequence space ahead counts as late, so the buffer
+        # (target plus the two frames of slack before catching up) must stay
+        # below that: 29 frames, 215 ms in the 7.4 ms IMA4 mode.
+        return min(MAX_LATENCY_MS, (SEQ_MODULO // 2 - 3) * self.frame_ms)
+
+    def next_frame(self):
+        """Returns (payload, following payload) for the next slot; None marks a gap."""
+        now = time.monotonic()
+        if not self.playing:
+            if not self.frames or self.buffered_ms() < self.target_ms:
+                return None
+            self.playing = True
+
+        if not self.frames:
+            self.stats['underruns'] += 1
+            self.stats['concealed'] += 1
+            self.target_ms = min(self.target_ms + self.frame_ms, self.max_target_ms())
+            self.last_underrun = now
+            return (None, None)
+
+        self.target_ms = min(self.target_ms, self.max_target_ms()) # frame_ms follows the codec mode
+        if now - self.last_underrun > RELAX_AFTER_S and self.target_ms > TARGET_LATENCY_MS:
+            self.target_ms = max(self.target_ms - self.frame_ms, TARGET_LATENCY_MS)
+            self.last_underrun = now
+        # Far above target (e.g. after a burst): drop one frame to catch up
+        while self.buffered_ms() > self.target_ms + 2 * self.frame_ms and self.next_seq in self.frames:
+            del self.frames[self.next_seq]
+            self.next_seq = (self.next_seq + 1) % SEQ_MODULO
+            self.stats['dropped'] += 1
+
+        seq = self.next_seq
+        self.next_seq = (seq + 1) % SEQ_MODULO
+        payload = self.frames.pop(seq, None)
+        if payload is None:
+            self.stats['lost'] += 1
+            self.stats['concealed'] += 1
+            self.concealed_seqs.add(seq)
+            self.concealed_seqs.discard((seq + SEQ_MODULO // 2) % SEQ_MODULO)
+            return (None, self.frames.get(self.next_seq))
+        self.stats['played'] += 1
+        return (payload, None)
+
+
+def read_frames(arduino_serial, codec, frames):
+    # Runs in its own thread so a blocking speaker write never stalls the serial port.
+    # Frames end at a 0x00 byte (serial_frame.h); a corrupted one is reported as
+    # None and the next delimiter resynchronizes. Any other length is one of
+    # the receiver's per-channel hop reports (40-odd bytes of text), printed
+    # as it comes.
+    pending = b''
+    payload = ctypes.create_string_buffer(SERIAL_FRAME_MAX_PAYLOAD)
+    while True:
+        pending += arduino_serial.read(max(1, arduino_serial.in_waiting))
+        *complete, pending = pending.split(b'\x00')
+        for frame in complete:
+            if not frame:
+                continue
+            n = codec.serial_frame_decode(frame, len(frame), payload)
+            if n > 0 and n != CHUNK:
+                print(payload.raw[:n].decode(errors='replace'))
+                continue
+            frames.put(payload.raw[:n] if n == CHUNK else None)
+
+
 print(f"Connecting to Arduino Receiver on {SERIAL_PORT}...")
 try:
     # timeout=None means it will wait forever for data
-    arduino_serial = serial.Serial(SERIAL_PORT, BAUD_RATE, timeout=None) 
+    arduino_serial = serial.Serial(SERIAL_PORT, BAUD_RATE, timeout=None)
     print("Connected!")
 except Exception as e:
     print(f"Error opening serial port: {e}")
     exit()
 
+codec = ctypes.CDLL(CODEC_LIB)
+decoder = AudioDecoder()
+pcm = (ctypes.c_uint8 * AUDIO_MAX_SAMPLES)()
+jitter = JitterBuffer(codec)
+arrivals = queue.Queue()
+threading.Thread(target=read_frames, args=(arduino_serial, codec, arrivals), daemon=True).start()
+
 print("Initializing Speakers...")
 p = pyaudio.PyAudio()
 stream = p.open(format=FORMAT,
@@ -27,17 +168,40 @@ stream = p.open(format=FORMAT,
                 rate=RATE,
                 output=True) # Output=True means it plays to speakers
 
-print("Listening for audio... (Press Ctrl+C to stop)")
+print(f"Listening for audio with {TARGET_LATENCY_MS} ms of buffering... (Press Ctrl+C to stop)")
 
 try:
+    last_stats = time.monotonic()
     while True:
-        # Check if exactly 32 bytes have arrived from the Arduino
-        if arduino_serial.in_waiting >= CHUNK:
-            # Read the bytes from the USB port
-            data = arduino_serial.read(CHUNK)
-            # Instantly push them to the computer speakers
-            stream.write(data)
-            
+        # Take everything that arrived while the last frame was playing
+        while not arrivals.empty():
+            frame = arrivals.get_nowait()
+            if frame is None:
+                jitter.stats['corrupt'] += 1
+            else:
+                jitter.push(frame)
+
+        slot = jitter.next_frame()
+        if slot is None:
+            time.sleep(0.002) # Still filling the buffer
+            continue
+        payload, following = slot
+        if payload is not None:
+            n = codec.audio_decode_frame(ctypes.byref(decoder), payload, pcm)
+        else:
+            n = round(jitter.frame_ms * RATE / 1000)
+            codec.audio_conceal_frame(ctypes.byref(decoder), following, n, pcm)
+        if n > 0:
+            # Blocks for roughly one frame, which paces the whole loop
+            stream.write(bytes(pcm[:n]))
+
+        if time.monotonic() - last_stats >= STATS_INTERVAL_S:
+            s = jitter.stats
+            print(f"played {s['played']}, late {s['late']}, lost {s['lost']}, corrupt {s['corrupt']}, "
+                  f"concealed {s['concealed']}, underruns {s['underruns']}, dropped {s['dropped']} | "
+                  f"buffer {jitter.buffered_ms():.0f} ms, target {jitter.target_ms:.0f} ms")
+            last_stats = time.monotonic()
+
 except KeyboardInterrupt:
     print("\nStopping stream...")
 finally:
@@ -46,4 +210,4 @@ finally:
     stream.close()
     p.terminate()
     arduino_serial.close()
-    print("Closed.")
\ No newline at end of file
+    print("Closed.")
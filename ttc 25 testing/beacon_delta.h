@@ -0,0 +1,136 @@
+// Delta beacons: keyframes plus predicted residuals, on top of the generated
+// beacon_telemetry.h. Plain C, shared by lora_packet.ino and lora_depacket.ino.
+//
+// Frame:  [header 1] [payload]
+//   header bit 7    1 = keyframe, 0 = delta
+//   header bits 0-6 beacon counter, modulo 128
+//   keyframe        the BEACON_BYTES bit-packed beacon
+//   delta           one zigzag LEB128 varint per field: the quantized value
+//                   minus its prediction, modulo the field's level count
+//
+// The prediction is a straight line through the two previous values, so a
+// steady rotation costs almost nothing. Residuals are taken modulo the level
+// count, so heading passing 360 -> 0 is a small step, not a full-range jump.
+// A delta only decodes if the receiver holds the beacon just before it; after
+// a lost beacon the receiver waits for the next keyframe.
+#ifndef BEACON_DELTA_H
+#define BEACON_DELTA_H
+
+#include "beacon_telemetry.h"
+
+#ifndef BEACON_KEYFRAME_INTERVAL
+#define BEACON_KEYFRAME_INTERVAL 8  // Beacons per keyframe; worst-case outage after a loss
+#endif
+#if 128 % BEACON_KEYFRAME_INTERVAL != 0
+#error "BEACON_KEYFRAME_INTERVAL must divide the 128-beacon counter"
+#endif
+#define BEACON_DELTA_MAX_FRAME (1 + (BEACON_BYTES > 5 * BEACON_FIELDS ? BEACON_BYTES : 5 * BEACON_FIELDS))
+
+// --- Status codes ---
+#define BEACON_DELTA_OK       0
+#define BEACON_DELTA_ERR_FORMAT -1  // Truncated frame or a value out of range
+#define BEACON_DELTA_ERR_SYNC   -2  // Beacon lost before this delta; wait for a keyframe
+
+typedef struct {
+  uint8_t  count;    // Counter of the last beacon sent or decoded
+  uint8_t  synced;   // Receiver: 1 while the deltas can be applied
+  uint32_t prev[BEACON_FIELDS];
+  uint32_t prev2[BEACON_FIELDS];
+} beacon_delta_state_t;
+
+static inline void beacon_delta_init(beacon_delta_state_t* st) {
+  memset(st, 0, sizeof(*st));
+  st->count = 0x7F;  // The first beacon sent is number 0, a keyframe
+}
+
+static inline uint32_t beacon_delta_predict(const beacon_delta_state_t* st, int k) {
+  uint32_t m = BEACON_LEVELS[k];
+  uint32_t slope = (st->prev[k] + m - st->prev2[k]) % m;
+  return (st->prev[k] + slope) % m;
+}
+
+static inline void beacon_delta_push(beacon_delta_state_t* st, const uint32_t* q, int keyframe) {
+  for (int k = 0; k < BEACON_FIELDS; k++) {
+    st->prev2[k] = keyframe ? q[k] : st->prev[k];  // No slope across a keyframe
+    st->prev[k] = q[k];
+  }
+}
+
+/**
+ * @brief Encodes the next beacon, a keyframe every BEACON_KEYFRAME_INTERVAL.
+ * @param out Buffer of at least BEACON_DELTA_MAX_FRAME bytes.
+ * @return The frame length.
+ */
+static inline int beacon_delta_encode(beacon_delta_state_t* st, const beacon_t* t, uint8_t* out) {
+  uint32_t q[BEACON_FIELDS];
+  beacon_quantize(t, q);
+  st->count = (st->count + 1) & 0x7F;
+  int keyframe = st->count % BEACON_KEYFRAME_INTERVAL == 0;
+  int len = 1;
+  out[0] = st->count | (keyframe ? 0x80 : 0);
+  if (keyframe) {
+    beacon_pack_q(q, out + 1);
+    len += BEACON_BYTES;
+  } else {
+    for (int k = 0; k < BEACON_FIELDS; k++) {
+      uint32_t m = BEACON_LEVELS[k];
+      uint32_t r = (q[k] + m - beacon_delta_predict(st, k)) % m;
+      int32_t d = (r > m / 2) ? (int32_t)r - (int32_t)m : (int32_t)r;  // Shortest way round
+      uint32_t z = ((uint32_t)d << 1) ^ (uint32_t)(d >> 31);           // Zigzag: small |d| -> small z
+      while (z >= 0x80) {
+        out[len++] = (uint8_t)(z | 0x80);
+        z >>= 7;
+      }
+      out[len++] = (uint8_t)z;
+    }
+  }
+  beacon_delta_push(st, q, keyframe);
+  return len;
+}
+
+/**
+ * @brief Decodes a delta beacon frame into t.
+ * @return BEACON_DELTA_OK or one of the BEACON_DELTA_ERR_ codes; t is only
+ * written on success.
+ */
+static inline int beacon_delta_decode(beacon_delta_state_t* st, const uint8_t* in, int len, beacon_t* t) {
+  if (len < 2) return BEACON_DELTA_ERR_FORMAT;
+  uint8_t count = in[0] & 0x7F;
+  uint32_t q[BEACON_FIELDS];
+
+  if (in[0] & 0x80) {
+    if (len != 1 + BEACON_BYTES) return BEACON_DELTA_ERR_FORMAT;
+    beacon_unpack_q(in + 1, q);
+    for (int k = 0; k < BEACON_FIELDS; k++) {
+      if (q[k] >= BEACON_LEVELS[k]) return BEACON_DELTA_ERR_FORMAT;
+    }
+  } else {
+    if (!st->synced || count != ((st->count + 1) & 0x7F)) {
+      st->synced = 0;
+      return BEACON_DELTA_ERR_SYNC;
+    }
+    int pos = 1;
+    for (int k = 0; k < BEACON_FIELDS; k++) {
+      uint32_t z = 0;
+      int shift = 0;
+      do {
+        if (pos == len || shift > 28) return BEACON_DELTA_ERR_FORMAT;
+        z |= (uint32_t)(in[pos] & 0x7F) << shift;
+        shift += 7;
+      } while (in[pos++] & 0x80);
+      uint32_t m = BEACON_LEVELS[k];
+      int32_t d = (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+      uint32_t r = (d < 0) ? (m - -(uint32_t)d % m) % m : (uint32_t)d % m;
+      q[k] = (beacon_delta_predict(st, k) + r) % m;
+    }
+    if (pos != len) return BEACON_DELTA_ERR_FORMAT;
+  }
+
+  st->count = count;
+  st->synced = 1;
+  beacon_delta_push(st, q, in[0] & 0x80);
+  beacon_dequantize(q, t);
+  return BEACON_DELTA_OK;
+}
+
+#endif
@@ -0,0 +1,76 @@
+// Beacon telemetry -- generated by telemetry_schema from beacon_schema.csv.
+// Do not edit; change the schema and regenerate.
+#ifndef BEACON_TELEMETRY_H
+#define BEACON_TELEMETRY_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define BEACON_BYTES 5  // 38 bits
+
+typedef struct {
+  float heading;  // 0 to 360, step 0.0625 (13 bits)
+  float roll;     // -90 to 90, step 0.0625 (12 bits)
+  float pitch;    // -180 to 180, step 0.0625 (13 bits)
+} beacon_t;
+
+#define BEACON_FIELDS 3
+// Number of quantization levels of each field
+static const uint32_t BEACON_LEVELS[BEACON_FIELDS] = { 5761UL, 2881UL, 5761UL };
+
+// Values outside a field's range are clamped to it.
+static inline void beacon_quantize(const beacon_t* t, uint32_t* q) {
+  float v;
+  v = t->heading;
+  if (!(v > 0.0f)) v = 0.0f;
+  if (v > 360.0f) v = 360.0f;
+  q[0] = (uint32_t)((v - (0.0f)) / 0.0625f + 0.5f);
+  if (q[0] > 5760UL) q[0] = 5760UL;
+  v = t->roll;
+  if (!(v > -90.0f)) v = -90.0f;
+  if (v > 90.0f) v = 90.0f;
+  q[1] = (uint32_t)((v - (-90.0f)) / 0.0625f + 0.5f);
+  if (q[1] > 2880UL) q[1] = 2880UL;
+  v = t->pitch;
+  if (!(v > -180.0f)) v = -180.0f;
+  if (v > 180.0f) v = 180.0f;
+  q[2] = (uint32_t)((v - (-180.0f)) / 0.0625f + 0.5f);
+  if (q[2] > 5760UL) q[2] = 5760UL;
+}
+
+static inline void beacon_dequantize(const uint32_t* q, beacon_t* t) {
+  t->heading = 0.0f + (float)q[0] * 0.0625f;
+  t->roll = -90.0f + (float)q[1] * 0.0625f;
+  t->pitch = -180.0f + (float)q[2] * 0.0625f;
+}
+
+static inline void beacon_pack_q(const uint32_t* q, uint8_t* out) {
+  memset(out, 0, BEACON_BYTES);
+  out[0] |= (uint8_t)(q[0] >> 5);
+  out[1] |= (uint8_t)(q[0] << 3);
+  out[1] |= (uint8_t)(q[1] >> 9);
+  out[2] |= (uint8_t)(q[1] >> 1);
+  out[3] |= (uint8_t)(q[1] << 7);
+  out[3] |= (uint8_t)(q[2] >> 6);
+  out[4] |= (uint8_t)(q[2] << 2);
+}
+
+static inline void beacon_unpack_q(const uint8_t* in, uint32_t* q) {
+  q[0] = ((uint32_t)in[0] << 5 | (uint32_t)in[1] >> 3) & 0x1FFFUL;
+  q[1] = ((uint32_t)in[1] << 9 | (uint32_t)in[2] << 1 | (uint32_t)in[3] >> 7) & 0xFFFUL;
+  q[2] = ((uint32_t)in[3] << 6 | (uint32_t)in[4] >> 2) & 0x1FFFUL;
+}
+
+static inline void beacon_pack(const beacon_t* t, uint8_t* out) {
+  uint32_t q[BEACON_FIELDS];
+  beacon_quantize(t, q);
+  beacon_pack_q(q, out);
+}
+
+static inline void beacon_unpack(const uint8_t* in, beacon_t* t) {
+  uint32_t q[BEACON_FIELDS];
+  beacon_unpack_q(in, q);
+  beacon_dequantize(q, t);
+}
+
+#endif
@@ -1,5 +1,9 @@
 #include <SPI.h>
 #include <LoRa.h>
+#include <EEPROM.h>
+#include "lora_rate_follow.h"
+#include "uplink_command.h"
+#include "beacon_delta.h"
 
 #define LORA_NSS 10
 #define LORA_RST 9
@@ -7,19 +11,31 @@
 
 uint8_t relayLen = 0;
 
-float flt_x;
-float flt_y;
-float flt_z;
-uint8_t packet[3];
-
-uint16_t ui_x;
-uint16_t ui_y;
-uint16_t ui_z;
+beacon_t beacon;
+uint8_t rx[32];
+
+#define DELTA_BEACONS 0   // Must match lora_packet.ino
+beacon_delta_state_t deltaState;
+
+// --- Uplink commands (frames built by Packetization/uplink_encoder) ---
+// The key is generated from the ground key file and never committed:
+//   Packetization/uplink_encoder -k key.hex -H "ttc 25 testing/uplink_key.h"
+#if __has_include("uplink_key.h")
+#include "uplink_key.h"
+#else
+#error "uplink_key.h is missing: generate it with uplink_encoder -k key.hex -H uplink_key.h"
+#endif
+#define EEPROM_LAST_SEQ 0   // Last accepted sequence number survives a reset
+uint32_t lastSeq = 0;
+bool uplinkOpen = true;
+bool killed = false;
 
 int spreadingFactor = 7;
 long bandwidth = 125E3; 
 int txPower = 14;  
 
+// Rate schedule: armed with "P<pass>" lines, see lora_rate_follow.h
+
 void setup() {
   Serial.begin(9600);
 
@@ -35,36 +51,83 @@ void setup() {
   LoRa.setSyncWord(0x22);
   LoRa.setTxPower(txPower);
   LoRa.enableCrc(); 
+  EEPROM.get(EEPROM_LAST_SEQ, lastSeq);
+  if (lastSeq == 0xFFFFFFFF) lastSeq = 0;  // Erased EEPROM
+  beacon_delta_init(&deltaState);
   Serial.println("LoRa RX ready");
 
 
 }
 
 void loop() {
-  
+  if (killed) return;
+  followRateSchedule();
   readRelay();
 
-  ui_x=((uint16_t)packet[0]<<8) | packet[1];
-  ui_y=((uint16_t)packet[2]<<8) | packet[3];
-  ui_z=((uint16_t)packet[4]<<8) | packet[5];
-
-  flt_x = (float)(~(int16_t)ui_x+1)/100.0;
-  flt_y = (float)(~(int16_t)ui_y+1)/100.0;
-  flt_z = (float)(~(int16_t)ui_z+1)/100.0;
-
-
-  Serial.print(flt_x);
-  Serial.print(flt_y);
-  Serial.print(flt_z);
+  Serial.print(beacon.heading);
+  Serial.print(beacon.roll);
+  Serial.print(beacon.pitch);
 
 }
 
 void readRelay(){
-  //probably we should add some signature (our call sign?) so we dont read random loras ka data uring uplink, or we can also add command parsing for kill code and end uplink stuff 
+  // Anything on sync word 0x22 arrives here. A packet is a command only if its
+  // SipHash tag checks under our key, so other LoRa traffic cannot command us.
   int packetSize = LoRa.parsePacket();
   if (!packetSize) return;
   relayLen = 0;
-  while (LoRa.available() && relayLen < 32) {
-    packet[relayLen++] = LoRa.read();
+  while (LoRa.available() && relayLen < sizeof(rx)) {
+    rx[relayLen++] = LoRa.read();
+  }
+
+  uplink_command_t cmd;
+  int status = uplink_verify(rx, relayLen, UPLINK_KEY, lastSeq, &cmd);
+  if (status == UPLINK_OK) {
+    lastSeq = cmd.seq;
+    EEPROM.put(EEPROM_LAST_SEQ, lastSeq);
+    if (uplinkOpen || cmd.opcode == UPLINK_OP_ARM_RATES) handleCommand(&cmd);
+    return;
+  }
+  if (status == UPLINK_ERR_REPLAY) {
+    Serial.println("Replayed command ignored");
+    return;
+  }
+
+  // Orientation telemetry
+#if DELTA_BEACONS
+  if (beacon_delta_decode(&deltaState, rx, relayLen, &beacon) == BEACON_DELTA_ERR_SYNC) {
+    Serial.println("Beacon lost, waiting for keyframe");
+  }
+#else
+  if (relayLen == BEACON_BYTES) {
+    beacon_unpack(rx, &beacon);
+  }
+#endif
+}
+
+void handleCommand(const uplink_command_t *cmd){
+  switch (cmd->opcode) {
+    case UPLINK_OP_PING:
+      Serial.println("CMD ping");
+      break;
+    case UPLINK_OP_ARM_RATES:
+      if (cmd->n_args == 2) {
+        uplinkOpen = true;
+        armRateSchedule(((int)cmd->args[0] << 8) | cmd->args[1]);
+      }
+      break;
+    case UPLINK_OP_END_UPLINK:
+      uplinkOpen = false;  // Ignore commands until the next pass is armed
+      Serial.println("CMD end of uplink");
+      break;
+    case UPLINK_OP_KILL:
+      Serial.println("CMD kill");
+      LoRa.sleep();
+      killed = true;
+      break;
+    default:
+      Serial.print("CMD unknown opcode ");
+      Serial.println(cmd->opcode);
+      break;
   }
 }
@@ -4,27 +4,29 @@
 #include <utility/imumaths.h>
 #include <SPI.h>
 #include <LoRa.h>
+#include "lora_rate_follow.h"
+#include "beacon_delta.h"
 
 
 #define LORA_NSS 10
 #define LORA_RST 9
 #define LORA_DIO0 2
 
-float flt_x;
-float flt_y;
-float flt_z;
+// Layout generated from beacon_schema.csv by Packetization/telemetry_schema
+beacon_t beacon;
+uint8_t packet[BEACON_DELTA_MAX_FRAME];
 
-const int size=6;
-uint8_t packet[size];
-
-uint8_t ui_x;
-uint8_t ui_y;
-uint8_t ui_z;
+// 1 = keyframes plus deltas (beacon_delta.h), 0 = every beacon in full.
+// Must match lora_depacket.ino.
+#define DELTA_BEACONS 0
+beacon_delta_state_t deltaState;
 
 int spreadingFactor = 7;
 long bandwidth = 125E3; 
 int txPower = 14;  
 
+// Rate schedule: armed with "P<pass>" lines, see lora_rate_follow.h
+
 Adafruit_BNO055 bno = Adafruit_BNO055(55);
 
 void setup() {
@@ -46,35 +48,34 @@ void setup() {
 
   bno.begin();
   bno.setExtCrystalUse(true);
+  beacon_delta_init(&deltaState);
 
 }
 
 void loop() {
+  followRateSchedule();
+
   sensors_event_t event; 
   bno.getEvent(&event);
   
-  flt_x=100*event.orientation.x;
-  flt_y=100*event.orientation.y;
-  flt_z=100*event.orientation.z;
-
-  ui_x=(uint16_t)(~(int)flt_x+1);
-  ui_y=(uint16_t)(~(int)flt_y+1);
-  ui_z=(uint16_t)(~(int)flt_z+1);
-
-  packet[0]=ui_x>>8; packet[1]=ui_x & 0xFF;
-  packet[2]=ui_y>>8; packet[3]=ui_y & 0xFF;
-  packet[4]=ui_z>>8; packet[5]=ui_z & 0xFF; 
-  
-
-  sendBeacon(packet);
+  beacon.heading=event.orientation.x;
+  beacon.roll=event.orientation.y;
+  beacon.pitch=event.orientation.z;
+
+#if DELTA_BEACONS
+  sendBeacon(packet, beacon_delta_encode(&deltaState, &beacon, packet));
+#else
+  beacon_pack(&beacon, packet);
+  sendBeacon(packet, BEACON_BYTES);
+#endif
   delay(1000);
 
 }
 
-void sendBeacon(uint8_t *pac){
-  // normal stuff, just sending beacon
+void sendBeacon(const uint8_t *pac, size_t len){
+  // normal stuff, just sending beacon (sizeof(pac) here would be the pointer size)
   LoRa.beginPacket();
-  LoRa.write(pac, sizeof(pac));
+  LoRa.write(pac, len);
   LoRa.endPacket();
   Serial.println("TX done");
 }
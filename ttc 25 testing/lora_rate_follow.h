@@ -0,0 +1,68 @@
+// Follows the generated lora_rate_schedule.h, shared by lora_packet.ino and
+// lora_depacket.ino so both ends switch the same way.
+//
+// Arm with a "P<pass>" line on the serial port at AOS (or armRateSchedule()
+// from an uplink command); the radio then switches SF/BW/CR at the
+// schedule's offsets into that pass. Unarmed, the sketch's own settings stay.
+// Send "P<pass>" again before every pass to re-arm.
+//
+// The serial port is read a byte at a time without waiting, so the loop is
+// never held up. Bytes outside a "P<digits>" line are discarded.
+#ifndef LORA_RATE_FOLLOW_H
+#define LORA_RATE_FOLLOW_H
+
+#include <LoRa.h>
+#include "lora_rate_schedule.h"
+
+int schedPass = 0;
+unsigned long schedStartMs = 0;
+int schedStep = -1;
+long schedLineValue = -1;  // Pass number being read; -1 = not inside a "P" line
+
+void armRateSchedule(int pass) {
+  schedPass = pass;
+  schedStartMs = millis();
+  schedStep = -1;
+  Serial.print("Rate schedule armed for pass ");
+  Serial.println(pass);
+}
+
+// Consumes everything waiting on the serial port; arms on a complete line.
+void readRateArm() {
+  while (Serial.available()) {
+    int c = Serial.read();
+    if (c == 'P') {
+      schedLineValue = 0;
+    } else if (schedLineValue >= 0 && c >= '0' && c <= '9' && schedLineValue < 10000) {
+      schedLineValue = schedLineValue * 10 + (c - '0');
+    } else {
+      if ((c == '\n' || c == '\r') && schedLineValue > 0) armRateSchedule((int)schedLineValue);
+      schedLineValue = -1;
+    }
+  }
+}
+
+void followRateSchedule() {
+  readRateArm();
+  if (!schedPass) return;
+
+  unsigned long t = (millis() - schedStartMs) / 1000;
+  int step = -1;
+  lora_rate_step_t s;
+  for (int i = 0; i < LORA_RATE_STEPS; i++) {
+    memcpy_P(&s, &LORA_RATE_SCHEDULE[i], sizeof(s));
+    if (s.pass == schedPass && s.t_rel_s <= t) step = i;
+  }
+  if (step < 0 || step == schedStep) return;
+
+  memcpy_P(&s, &LORA_RATE_SCHEDULE[step], sizeof(s));
+  LoRa.setSpreadingFactor(s.sf);
+  LoRa.setSignalBandwidth((long)s.bw_khz * 1000);
+  LoRa.setCodingRate4(s.cr);
+  schedStep = step;
+  Serial.print("Rate -> SF"); Serial.print(s.sf);
+  Serial.print(" BW"); Serial.print(s.bw_khz);
+  Serial.print(" CR4/"); Serial.println(s.cr);
+}
+
+#endif
@@ -0,0 +1,57 @@
+// LoRa rate schedule -- generated by adcs_skissue.py --rate-header.
+// Do not edit; regenerate after changing the orbit or link budget.
+// CR stays at 4/5: the link model gives higher CRs no margin, only airtime.
+// 33 passes: 15.8 kB per week adaptive vs 15.8 kB at fixed SF12/125 kHz (1.00x).
+// Every step is SF12/125 kHz: no faster setting keeps a non-negative
+// margin for the minimum dwell in any of these passes.
+#ifndef LORA_RATE_SCHEDULE_H
+#define LORA_RATE_SCHEDULE_H
+
+#include <Arduino.h>
+
+typedef struct {
+  uint16_t pass;     // Pass number (1-indexed)
+  uint16_t t_rel_s;  // Seconds after AOS
+  uint8_t  sf;       // Spreading factor
+  uint16_t bw_khz;   // Bandwidth [kHz]
+  uint8_t  cr;       // Coding rate denominator (4/cr)
+} lora_rate_step_t;
+
+const uint16_t LORA_RATE_STEPS = 33;
+const lora_rate_step_t LORA_RATE_SCHEDULE[] PROGMEM = {
+  { 1, 0, 12, 125, 5 },
+  { 2, 0, 12, 125, 5 },
+  { 3, 0, 12, 125, 5 },
+  { 4, 0, 12, 125, 5 },
+  { 5, 0, 12, 125, 5 },
+  { 6, 0, 12, 125, 5 },
+  { 7, 0, 12, 125, 5 },
+  { 8, 0, 12, 125, 5 },
+  { 9, 0, 12, 125, 5 },
+  { 10, 0, 12, 125, 5 },
+  { 11, 0, 12, 125, 5 },
+  { 12, 0, 12, 125, 5 },
+  { 13, 0, 12, 125, 5 },
+  { 14, 0, 12, 125, 5 },
+  { 15, 0, 12, 125, 5 },
+  { 16, 0, 12, 125, 5 },
+  { 17, 0, 12, 125, 5 },
+  { 18, 0, 12, 125, 5 },
+  { 19, 0, 12, 125, 5 },
+  { 20, 0, 12, 125, 5 },
+  { 21, 0, 12, 125, 5 },
+  { 22, 0, 12, 125, 5 },
+  { 23, 0, 12, 125, 5 },
+  { 24, 0, 12, 125, 5 },
+  { 25, 0, 12, 125, 5 },
+  { 26, 0, 12, 125, 5 },
+  { 27, 0, 12, 125, 5 },
+  { 28, 0, 12, 125, 5 },
+  { 29, 0, 12, 125, 5 },
+  { 30, 0, 12, 125, 5 },
+  { 31, 0, 12, 125, 5 },
+  { 32, 0, 12, 125, 5 },
+  { 33, 0, 12, 125, 5 },
+};
+
+#endif
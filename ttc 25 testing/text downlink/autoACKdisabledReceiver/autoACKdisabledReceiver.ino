@@ -1,8 +1,38 @@
 #include <SPI.h>
 #include <RF24.h>
+#include <channel_hop.h>  // From audio downlink/libraries, see channel_hop.h
 
 RF24 radio(7, 8);
 const byte address[6] = "00001"; 
+const byte hopAddress[6] = "THOP0";
+
+// --- Channel hopping ---
+// While lost, the receiver parks on each candidate channel for a full cycle
+// (16 x SLOT_MS = 4 s), so it locks on at the first of the sender's channels
+// it reaches. That is usually within a few candidates, as both ends rank the
+// same band quietest first, but the worst case is every channel: 126 x 4 s
+// = 8.4 min to first lock, 142 x 4 s = 9.5 min to relock after losing a
+// known plan. Both scale with SLOT_MS.
+#define SLOT_MS 250             // Must match the transmitter
+#define STARTUP_SWEEPS 16
+#define REPORT_INTERVAL_MS 625  // One channel per line: all 16 every 10 s
+channel_hop_rx_t hop;
+uint8_t listenChannel = 255;
+uint8_t reportSlot = 0;
+unsigned long lastReportMs = 0;
+
+// Packet loss on one channel of the sequence: announcements heard out of
+// slots visited (the transmitter announces every slot)
+void reportChannels() {
+  if (millis() - lastReportMs < REPORT_INTERVAL_MS || !hop.have_map) return;
+  lastReportMs = millis();
+  char line[64];
+  snprintf(line, sizeof(line), "Channel %u: %u/%u announced, %u messages",
+           hop.map.seq[reportSlot], hop.announced[reportSlot],
+           hop.visits[reportSlot], hop.payloads[reportSlot]);
+  Serial.println(line);
+  reportSlot = (reportSlot + 1) % CHANNEL_HOP_SLOTS;
+}
 
 void setup() {
   Serial.begin(9600);
@@ -16,23 +46,53 @@ void setup() {
   }
   
   radio.openReadingPipe(0, address);
+  radio.openReadingPipe(1, hopAddress);
   
   // The Nuclear Option Settings (Must match transmitter):
-  radio.setChannel(115);
   radio.setPALevel(RF24_PA_LOW);
   radio.setDataRate(RF24_250KBPS);
   radio.setAutoAck(false); 
+
+  // Search the channels that are quietest here first
+  channel_scan_t scan = {};
+  for (int p = 0; p < STARTUP_SWEEPS; p++) {
+    for (uint8_t ch = 0; ch < CHANNEL_HOP_CHANNELS; ch++) {
+      radio.setChannel(ch);
+      radio.startListening();
+      delayMicroseconds(128);
+      radio.stopListening();
+      channel_scan_add(&scan, ch, radio.testCarrier());
+    }
+  }
+  channel_hop_rx_init(&hop, &scan, SLOT_MS);
   
   radio.startListening();
   Serial.println("Listening for incoming messages...");
 }
 
 void loop() {
-  if (radio.available()) {
+  uint8_t ch = channel_hop_rx_tick(&hop, millis());
+  if (ch != listenChannel) {
+    radio.setChannel(ch);
+    listenChannel = ch;
+  }
+
+  uint8_t pipe;
+  if (radio.available(&pipe)) {
     char text[32] = ""; 
     radio.read(&text, sizeof(text));
+    if (pipe == 1) {
+      bool wasLost = channel_hop_rx_lost(&hop);
+      if (channel_hop_rx_announce(&hop, (const uint8_t*)text, sizeof(text), millis()) == 0 && wasLost) {
+        Serial.print("Found the transmitter, following hop map ");
+        Serial.println(hop.map.epoch);
+      }
+      return;
+    }
+    channel_hop_rx_payload(&hop);
     
     Serial.print("Message Received: ");
     Serial.println(text);
   }
+  reportChannels();
 }
\ No newline at end of file
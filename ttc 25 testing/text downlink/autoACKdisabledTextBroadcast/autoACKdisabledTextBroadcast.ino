@@ -1,8 +1,65 @@
 #include <SPI.h>
 #include <RF24.h>
+#include <channel_hop.h>  // From audio downlink/libraries, see channel_hop.h
 
 RF24 radio(7, 8);
 const byte address[6] = "00001";
+const byte hopAddress[6] = "THOP0";
+
+// --- Channel hopping ---
+// 16 slots of 250 ms over the quietest channels found by the carrier-detect
+// sweep; at one message a second, one slot in four carries a message. Nothing
+// is sent in the last GUARD_MS of a slot, while the receiver retunes.
+#define SLOT_MS 250
+#define GUARD_MS 8
+#define STARTUP_SWEEPS 16
+#define SCAN_INTERVAL_MS 25   // One channel at a time: a full sweep every ~3 s
+#define SEND_INTERVAL_MS 1000
+channel_scan_t scan;
+channel_hop_tx_t hopper;
+uint8_t hopChannel = 0;
+unsigned long lastScanMs = 0;
+unsigned long lastSendMs = 0;
+
+// Carrier detect on one channel
+bool sampleChannel(uint8_t ch) {
+  radio.setChannel(ch);
+  radio.startListening();
+  delayMicroseconds(128);
+  radio.stopListening();
+  return radio.testCarrier();
+}
+
+void scanNextChannel() {
+  unsigned long now = millis();
+  if (now - lastScanMs < SCAN_INTERVAL_MS || channel_hop_tx_quiet(&hopper, now)) return;
+  lastScanMs = now;
+  channel_scan_add(&scan, scan.next, sampleChannel(scan.next));
+  radio.setChannel(hopChannel);
+  if (++scan.next == CHANNEL_HOP_CHANNELS) {
+    // Full sweep done: move off any channel in use that has turned busy
+    scan.next = 0;
+    channel_hop_map_t next;
+    if (channel_hop_replan(&scan, &hopper.map, &next)) {
+      channel_hop_tx_plan(&hopper, &next);
+      Serial.println("Busy channel in the hop sequence, new plan from the next cycle");
+    }
+  }
+}
+
+void hopIfDue() {
+  unsigned long now = millis();
+  if (!channel_hop_tx_due(&hopper, now)) return;
+  byte announce[32] = { 0 };
+  int more;
+  radio.openWritingPipe(hopAddress);
+  do {
+    more = channel_hop_tx_hop(&hopper, now, &hopChannel, announce);
+    radio.setChannel(hopChannel);
+    radio.write(announce, sizeof(announce), true);
+  } while (more);
+  radio.openWritingPipe(address);
+}
 
 void setup() {
   Serial.begin(9600);
@@ -18,24 +75,45 @@ void setup() {
   radio.openWritingPipe(address);
   
   // The Nuclear Option Settings:
-  radio.setChannel(115);                 // Dodge WiFi
   radio.setPALevel(RF24_PA_LOW);         // Bump power up slightly
   radio.setDataRate(RF24_250KBPS);       // Slowest speed = highest reliability
   radio.setAutoAck(false);               // TURN OFF receipts (bypasses clone bugs)
   
   radio.stopListening();
+
+  // Dodge WiFi (and everything else): hop over the quietest channels
+  for (int p = 0; p < STARTUP_SWEEPS; p++) {
+    for (uint8_t ch = 0; ch < CHANNEL_HOP_CHANNELS; ch++) {
+      channel_scan_add(&scan, ch, sampleChannel(ch));
+    }
+  }
+  channel_hop_map_t map;
+  channel_hop_plan(&scan, 0, SLOT_MS, GUARD_MS, &map);
+  channel_hop_tx_start(&hopper, &map, millis());
+  Serial.print("Hop sequence:");
+  for (int s = 0; s < CHANNEL_HOP_SLOTS; s++) {
+    Serial.print(' ');
+    Serial.print(map.seq[s]);
+  }
+  Serial.println();
   Serial.println("Setup Complete. Entering Main Loop...");
 }
 
 void loop() {
+  hopIfDue();
+  scanNextChannel();
+  if (millis() - lastSendMs < SEND_INTERVAL_MS || channel_hop_tx_quiet(&hopper, millis())) return;
+  lastSendMs = millis();
+
   const char text[] = "Hello World";
   
-  Serial.print("Attempting to send... ");
+  Serial.print("Attempting to send on channel ");
+  Serial.print(hopChannel);
+  Serial.print("... ");
   
   // Because Auto-ACK is off, this will ALWAYS return true now.
   // It is just shouting into the void.
   radio.write(&text, sizeof(text));
   
   Serial.println("Broadcast Sent! (No receipt requested)");
-  delay(1000);
 }
\ No newline at end of file
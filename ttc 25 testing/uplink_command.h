@@ -0,0 +1,179 @@
+// Authenticated uplink command frames, shared by the flight sketches and the
+// ground encoder (Packetization/uplink_encoder.c). Plain C, no Arduino calls.
+//
+// Frame:  [opcode 1] [sequence varint 1-5] [arguments 0-8] [tag UPLINK_TAG_LEN]
+//
+// The tag is SipHash-2-4 of everything before it, under a 128-bit key shared
+// by the spacecraft and the ground, truncated to UPLINK_TAG_LEN bytes. The
+// sequence number must increase with every command, so a recorded command
+// cannot be replayed. Nothing else is sent: the argument length is what is
+// left between the sequence number and the tag.
+//
+// With the 4-byte tag, a command with up to 3 argument bytes and a sequence
+// number below 16384 is 10 bytes: two payload blocks at SF12, the shortest
+// LoRa packet that can carry a tag. Verification is a single SipHash of at
+// most 14 bytes, well under a millisecond even on an 8-bit AVR.
+#ifndef UPLINK_COMMAND_H
+#define UPLINK_COMMAND_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef UPLINK_TAG_LEN
+#define UPLINK_TAG_LEN 4   // Truncated tag length, 4 to 8 bytes
+#endif
+#define UPLINK_KEY_LEN 16
+#define UPLINK_MAX_ARGS 8
+#define UPLINK_MAX_FRAME (1 + 5 + UPLINK_MAX_ARGS + UPLINK_TAG_LEN)
+
+#if UPLINK_TAG_LEN < 4 || UPLINK_TAG_LEN > 8
+#error "UPLINK_TAG_LEN must be 4 to 8 bytes"
+#endif
+
+// --- Opcodes ---
+#define UPLINK_OP_PING       0x01  // No arguments; proves the link and the key
+#define UPLINK_OP_ARM_RATES  0x02  // uint16 pass number (big-endian): arm the rate schedule
+#define UPLINK_OP_END_UPLINK 0x03  // No arguments; stop listening until the next pass
+#define UPLINK_OP_KILL       0x7F  // No arguments; transmitter off
+
+// --- Status codes ---
+#define UPLINK_OK          0
+#define UPLINK_ERR_FORMAT -1  // Too short, too long or a bad varint
+#define UPLINK_ERR_TAG    -2  // Tag does not match: not ours, corrupted or forged
+#define UPLINK_ERR_REPLAY -3  // Sequence number not newer than the last command
+
+typedef struct {
+  uint8_t  opcode;
+  uint32_t seq;
+  uint8_t  n_args;
+  uint8_t  args[UPLINK_MAX_ARGS];
+} uplink_command_t;
+
+
+// =============================================================================
+// SipHash-2-4 (Aumasson & Bernstein)
+// =============================================================================
+
+#define UPLINK_ROTL(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+#define UPLINK_SIPROUND                                              \
+  do {                                                               \
+    v0 += v1; v1 = UPLINK_ROTL(v1, 13); v1 ^= v0; v0 = UPLINK_ROTL(v0, 32); \
+    v2 += v3; v3 = UPLINK_ROTL(v3, 16); v3 ^= v2;                    \
+    v0 += v3; v3 = UPLINK_ROTL(v3, 21); v3 ^= v0;                    \
+    v2 += v1; v1 = UPLINK_ROTL(v1, 17); v1 ^= v2; v2 = UPLINK_ROTL(v2, 32); \
+  } while (0)
+
+static inline uint64_t uplink_load64(const uint8_t* p, int n) {
+  uint64_t x = 0;
+  for (int i = n - 1; i >= 0; i--) x = (x << 8) | p[i];
+  return x;
+}
+
+/**
+ * @brief SipHash-2-4 of msg under a 16-byte key.
+ */
+static inline uint64_t uplink_siphash(const uint8_t* key, const uint8_t* msg, int len) {
+  uint64_t k0 = uplink_load64(key, 8), k1 = uplink_load64(key + 8, 8);
+  uint64_t v0 = k0 ^ 0x736f6d6570736575ULL;
+  uint64_t v1 = k1 ^ 0x646f72616e646f6dULL;
+  uint64_t v2 = k0 ^ 0x6c7967656e657261ULL;
+  uint64_t v3 = k1 ^ 0x7465646279746573ULL;
+  int i = 0;
+  for (; i + 8 <= len; i += 8) {
+    uint64_t m = uplink_load64(msg + i, 8);
+    v3 ^= m;
+    UPLINK_SIPROUND;
+    UPLINK_SIPROUND;
+    v0 ^= m;
+  }
+  uint64_t b = ((uint64_t)len << 56) | uplink_load64(msg + i, len - i);
+  v3 ^= b;
+  UPLINK_SIPROUND;
+  UPLINK_SIPROUND;
+  v0 ^= b;
+  v2 ^= 0xff;
+  UPLINK_SIPROUND;
+  UPLINK_SIPROUND;
+  UPLINK_SIPROUND;
+  UPLINK_SIPROUND;
+  return v0 ^ v1 ^ v2 ^ v3;
+}
+
+
+// =============================================================================
+// Command Frames
+// =============================================================================
+
+/**
+ * @brief Writes v as an unsigned LEB128 varint.
+ * @return The number of bytes written (1 to 5).
+ */
+static inline int uplink_put_varint(uint8_t* out, uint32_t v) {
+  int n = 0;
+  while (v >= 0x80) {
+    out[n++] = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  out[n++] = (uint8_t)v;
+  return n;
+}
+
+/**
+ * @brief Reads an unsigned LEB128 varint of at most 5 bytes.
+ * @return The number of bytes read, or 0 if it is truncated or too long.
+ */
+static inline int uplink_get_varint(const uint8_t* in, int len, uint32_t* v) {
+  uint32_t x = 0;
+  for (int n = 0; n < len && n < 5; n++) {
+    x |= (uint32_t)(in[n] & 0x7F) << (7 * n);
+    if (!(in[n] & 0x80)) {
+      *v = x;
+      return n + 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Builds the frame for a command.
+ * @param frame Output buffer of at least UPLINK_MAX_FRAME bytes.
+ * @return The frame length, or UPLINK_ERR_FORMAT if there are too many arguments.
+ */
+static inline int uplink_encode(const uplink_command_t* cmd, const uint8_t* key, uint8_t* frame) {
+  if (cmd->n_args > UPLINK_MAX_ARGS) return UPLINK_ERR_FORMAT;
+  int len = 0;
+  frame[len++] = cmd->opcode;
+  len += uplink_put_varint(frame + len, cmd->seq);
+  memcpy(frame + len, cmd->args, cmd->n_args);
+  len += cmd->n_args;
+  uint64_t tag = uplink_siphash(key, frame, len);
+  for (int i = 0; i < UPLINK_TAG_LEN; i++) frame[len++] = (uint8_t)(tag >> (8 * i));
+  return len;
+}
+
+/**
+ * @brief Checks a received frame and extracts the command.
+ * The tag is compared in constant time, before anything in the frame is trusted.
+ * @param last_seq Sequence number of the last accepted command; the caller
+ * stores cmd->seq as the new value when UPLINK_OK is returned.
+ * @return UPLINK_OK or one of the UPLINK_ERR_ codes.
+ */
+static inline int uplink_verify(const uint8_t* frame, int len, const uint8_t* key,
+                                uint32_t last_seq, uplink_command_t* cmd) {
+  if (len < 2 + UPLINK_TAG_LEN || len > UPLINK_MAX_FRAME) return UPLINK_ERR_FORMAT;
+  int body = len - UPLINK_TAG_LEN;
+  uint64_t tag = uplink_siphash(key, frame, body);
+  uint8_t diff = 0;
+  for (int i = 0; i < UPLINK_TAG_LEN; i++) diff |= frame[body + i] ^ (uint8_t)(tag >> (8 * i));
+  if (diff) return UPLINK_ERR_TAG;
+
+  int n = uplink_get_varint(frame + 1, body - 1, &cmd->seq);
+  if (n == 0 || body - 1 - n > UPLINK_MAX_ARGS) return UPLINK_ERR_FORMAT;
+  if (cmd->seq <= last_seq) return UPLINK_ERR_REPLAY;
+  cmd->opcode = frame[0];
+  cmd->n_args = (uint8_t)(body - 1 - n);
+  memcpy(cmd->args, frame + 1 + n, cmd->n_args);
+  return UPLINK_OK;
+}
+
+#endif